@@ -1762,6 +1762,7 @@ static int base_want(struct ai_type *ait, struct player *pplayer,
     }
 
     pplayer->wonders[improvement_index(pimprove)] = wonder_city_id;
+    requirement_cache_invalidate();
   }
 
   return final_want;
@@ -139,8 +139,71 @@ static void tile_data_cache_destroy(struct tile_data_cache *ptdc);
 #define SPECHASH_DATA_FREE tile_data_cache_destroy
 #include "spechash.h"
 
+#ifdef DEBUG
+/* Check every reused value of a city site against a fresh calculation. */
+#define SITEMAP_DEBUG
+#endif
+
+/* The value of a city site, as city_desirability() gives it before the
+ * checks which depend on the settler, is shared by all the searches of the
+ * player during the turn. A value is calculated again only when something
+ * it depends on has changed: a tile within the city radius of the site or
+ * adjacent to it, or the player. Each of those remembers its state and the
+ * stamp of its last change; a value is valid while none of them changed
+ * after it. */
+
+/* The state of a tile the values depend on, and the value of the site. */
+struct site_tile_state {
+  int reserved;                 /* citymap_read() */
+  const struct city *worked;
+  bool known;
+  struct terrain *terrain;
+  struct resource *resource;
+  bv_special special;
+  bv_bases bases;
+  bv_roads roads;
+  struct player *owner;
+  Continent_id continent;
+  unsigned int stamp;           /* stamp of the last change of the tile */
+
+  int value;                    /* total of the site; -1 if no city would
+                                 * be founded here */
+  unsigned int value_stamp;     /* when 'value' was calculated; 0 if it
+                                 * never was */
+  int value_radius_sq;          /* the city radius 'value' depends on */
+};
+
+/* The state of the player the values depend on. */
+struct site_player_state {
+  int turn;
+  struct government *government;        /* the goal government */
+  int food_priority;
+  int shield_priority;
+  int science_priority;
+  bool handicap;                        /* H_MAP */
+  bv_techs techs;
+  int wonders[B_LAST];
+  int great_wonder_owners[B_LAST];
+  int *gov_centers;                     /* ids of the gov center cities */
+  int num_gov_centers;
+};
+
+struct site_map {
+  unsigned int stamp;           /* stamp of the last change seen */
+  unsigned int valid_stamp;     /* the values older than this are invalid */
+  int num_tiles;
+  struct site_tile_state *tiles;
+  struct site_player_state player;
+};
+
+FC_STATIC_ASSERT(sizeof(((struct site_player_state *) NULL)
+                          ->great_wonder_owners)
+                 == sizeof(game.info.great_wonder_owners),
+                 site_great_wonder_owners_size);
+
 struct ai_settler {
   struct tile_data_cache_hash *tdc_hash;
+  struct site_map sites;
 
 #ifdef DEBUG
   struct {
@@ -200,6 +263,14 @@ static int defense_bonus(struct player *pplayer,
 static int naval_bonus(const struct cityresult *result);
 static void print_cityresult(struct player *pplayer,
                              const struct cityresult *cr);
+static bool city_site_possible(struct player *pplayer, struct unit *punit,
+                               struct tile *ptile);
+static struct cityresult *city_site_result(struct ai_type *ait,
+                                           struct player *pplayer,
+                                           struct tile *ptile);
+static void city_sites_refresh(struct ai_type *ait, struct player *pplayer);
+static int city_site_value(struct ai_type *ait, struct player *pplayer,
+                           struct tile *ptile);
 struct cityresult *city_desirability(struct ai_type *ait,
                                      struct player *pplayer,
                                      struct unit *punit, struct tile *ptile);
@@ -274,8 +345,8 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
 {
   struct city *pcity = tile_city(ptile);
   struct government *curr_govt = government_of_player(pplayer);
-  struct player *saved_owner = NULL;
-  struct tile *saved_claimer = NULL;
+  struct city vcity;
+  struct tile vcenter;
   bool virtual_city = FALSE;
   bool handicap = ai_handicap(pplayer, H_MAP);
   struct adv_data *adv = adv_data_get(pplayer, NULL);
@@ -291,10 +362,13 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
   result = cityresult_new(ptile);
 
   if (!pcity) {
-    pcity = create_city_virtual(pplayer, result->tile, "Virtuaville");
-    saved_owner = tile_owner(result->tile);
-    saved_claimer = tile_claimer(result->tile);
-    tile_set_owner(result->tile, pplayer, result->tile); /* temporarily */
+    /* The virtual city stands on a copy of the tile, owned by the player;
+     * neither the real tile nor the allocator are touched. */
+    tile_virtual_init(&vcenter, result->tile);
+    vcenter.continent = tile_continent(result->tile);
+    tile_set_owner(&vcenter, pplayer, result->tile);
+    city_virtual_init(&vcity, pplayer, &vcenter, "Virtuaville");
+    pcity = &vcity;
     city_choose_build_default(pcity);  /* ?? */
     virtual_city = TRUE;
   }
@@ -306,6 +380,8 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
     int tindex = tile_index(ptile);
     int reserved = citymap_read(ptile);
     bool city_center = (result->tile == ptile); /*is_city_center()*/
+    /* The outputs of the center are those of the city's own tile. */
+    const struct tile *otile = city_center ? city_tile(pcity) : ptile;
     struct tile_data_cache *ptdc;
 
     if (reserved < 0
@@ -326,11 +402,11 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
         ptdc = tile_data_cache_new();
 
         /* Food */
-        ptdc->food = city_tile_output(pcity, ptile, FALSE, O_FOOD);
+        ptdc->food = city_tile_output(pcity, otile, FALSE, O_FOOD);
         /* Shields */
-        ptdc->shield = city_tile_output(pcity, ptile, FALSE, O_SHIELD);
+        ptdc->shield = city_tile_output(pcity, otile, FALSE, O_SHIELD);
         /* Trade */
-        ptdc->trade = city_tile_output(pcity, ptile, FALSE, O_TRADE);
+        ptdc->trade = city_tile_output(pcity, otile, FALSE, O_TRADE);
         /* Weighted sum */
         ptdc->sum = ptdc->food * adv->food_priority
                     + ptdc->trade * adv->science_priority
@@ -439,10 +515,6 @@ static struct cityresult *cityresult_fill(struct ai_type *ait,
   result->total = MAX(0, result->total);
 
   pplayer->government = curr_govt;
-  if (virtual_city) {
-    destroy_city_virtual(pcity);
-    tile_set_owner(result->tile, saved_owner, saved_claimer);
-  }
 
   fc_assert_ret_val(result->city_center.tdc->sum >= 0, NULL);
   fc_assert_ret_val(result->remaining >= 0, NULL);
@@ -701,53 +773,60 @@ static void print_cityresult(struct player *pplayer,
 }
 
 /*****************************************************************************
-  Calculates the desire for founding a new city at 'ptile'. The citymap
-  ensures that we do not build cities too close to each other. Returns NULL
-  if no place was found.
+  Return TRUE if the unit may consider founding a city at 'ptile'. These are
+  the checks of city_desirability() which depend on the unit, or which are
+  cheap enough to do each time.
 *****************************************************************************/
-struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer,
-                                     struct unit *punit, struct tile *ptile)
+static bool city_site_possible(struct player *pplayer, struct unit *punit,
+                               struct tile *ptile)
 {
   struct city *pcity = tile_city(ptile);
-  struct adv_data *ai = adv_data_get(pplayer, NULL);
-  struct cityresult *cr = NULL;
-
-  fc_assert_ret_val(punit, NULL);
-  fc_assert_ret_val(pplayer, NULL);
-  fc_assert_ret_val(ai, NULL);
 
   if (!city_can_be_built_here(ptile, punit)
       || (ai_handicap(pplayer, H_MAP)
           && !map_is_known(ptile, pplayer))) {
-    return NULL;
+    return FALSE;
   }
 
   /* Check if another settler has taken a spot within mindist */
   square_iterate(ptile, game.info.citymindist-1, tile1) {
     if (citymap_is_reserved(tile1)) {
-      return NULL;
+      return FALSE;
     }
   } square_iterate_end;
 
   if (adv_danger_at(punit, ptile)) {
-    return NULL;
+    return FALSE;
   }
 
   if (pcity && (city_size_get(pcity) + unit_pop_value(punit)
                 > game.info.add_to_size_limit)) {
     /* Can't exceed population limit. */
-    return NULL;
+    return FALSE;
   }
 
   if (!pcity && citymap_is_reserved(ptile)) {
-    return NULL; /* reserved, go away */
+    return FALSE; /* reserved, go away */
   }
 
   /* If (x, y) is an existing city, consider immigration */
   if (pcity && city_owner(pcity) == pplayer) {
-    return NULL;
+    return FALSE;
   }
 
+  return TRUE;
+}
+
+/*****************************************************************************
+  Calculates the desire of the player for a city at 'ptile', whichever unit
+  founds it. Returns NULL if no city would be founded there.
+*****************************************************************************/
+static struct cityresult *city_site_result(struct ai_type *ait,
+                                           struct player *pplayer,
+                                           struct tile *ptile)
+{
+  struct cityresult *cr;
+
   cr = cityresult_fill(ait, pplayer, ptile); /* Burn CPU, burn! */
   if (!cr) {
     /* Failed to find a good spot */
@@ -772,6 +851,222 @@ struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer
   return cr;
 }
 
+/*****************************************************************************
+  Note the current state of the tile, and stamp it if it changed.
+*****************************************************************************/
+static void city_site_tile_refresh(struct site_map *sites,
+                                   struct player *pplayer,
+                                   struct tile *ptile)
+{
+  struct site_tile_state *pstate = &sites->tiles[tile_index(ptile)];
+  int reserved = citymap_read(ptile);
+  bool known = map_is_known(ptile, pplayer);
+
+  if (pstate->stamp != 0
+      && pstate->reserved == reserved
+      && pstate->worked == tile_worked(ptile)
+      && pstate->known == known
+      && pstate->terrain == tile_terrain(ptile)
+      && pstate->resource == ptile->resource
+      && BV_ARE_EQUAL(pstate->special, ptile->special)
+      && BV_ARE_EQUAL(pstate->bases, ptile->bases)
+      && BV_ARE_EQUAL(pstate->roads, ptile->roads)
+      && pstate->owner == tile_owner(ptile)
+      && pstate->continent == tile_continent(ptile)) {
+    return;
+  }
+
+  pstate->reserved = reserved;
+  pstate->worked = tile_worked(ptile);
+  pstate->known = known;
+  pstate->terrain = tile_terrain(ptile);
+  pstate->resource = ptile->resource;
+  pstate->special = ptile->special;
+  pstate->bases = ptile->bases;
+  pstate->roads = ptile->roads;
+  pstate->owner = tile_owner(ptile);
+  pstate->continent = tile_continent(ptile);
+  pstate->stamp = ++sites->stamp;
+}
+
+/*****************************************************************************
+  Note the current state of the tiles the value of the site at 'ptile'
+  depends on, for a city of the squared radius 'radius_sq'. Returns TRUE
+  if none of them changed after 'stamp'.
+*****************************************************************************/
+static bool city_site_tiles_refresh(struct site_map *sites,
+                                    struct player *pplayer,
+                                    struct tile *ptile, int radius_sq,
+                                    unsigned int stamp)
+{
+  bool unchanged = TRUE;
+
+  city_tile_iterate(radius_sq, ptile, ptile1) {
+    city_site_tile_refresh(sites, pplayer, ptile1);
+    if (sites->tiles[tile_index(ptile1)].stamp > stamp) {
+      unchanged = FALSE;
+    }
+  } city_tile_iterate_end;
+  adjc_iterate(ptile, adjc_tile) {
+    city_site_tile_refresh(sites, pplayer, adjc_tile);
+    if (sites->tiles[tile_index(adjc_tile)].stamp > stamp) {
+      unchanged = FALSE;
+    }
+  } adjc_iterate_end;
+
+  return unchanged;
+}
+
+/*****************************************************************************
+  Note the current state of the player, and forget all the values of the
+  sites if it changed. Must be called before the values are used in a
+  search.
+*****************************************************************************/
+static void city_sites_refresh(struct ai_type *ait, struct player *pplayer)
+{
+  struct ai_plr *ai = dai_plr_data_get(ait, pplayer, NULL);
+  struct adv_data *adv = adv_data_get(pplayer, NULL);
+  struct site_map *sites = &ai->settler->sites;
+  struct site_player_state *pstate = &sites->player;
+  bool handicap = ai_handicap(pplayer, H_MAP);
+  bool changed = FALSE;
+  bv_techs techs;
+  int *gov_centers = NULL;
+  int num_gov_centers = 0;
+
+  if (sites->num_tiles != MAP_INDEX_SIZE) {
+    free(sites->tiles);
+    sites->num_tiles = MAP_INDEX_SIZE;
+    sites->tiles = fc_calloc(sites->num_tiles, sizeof(*sites->tiles));
+    changed = TRUE;
+  }
+
+  BV_CLR_ALL(techs);
+  advance_index_iterate(A_FIRST, tech) {
+    if (player_invention_state(pplayer, tech) == TECH_KNOWN) {
+      BV_SET(techs, tech);
+    }
+  } advance_index_iterate_end;
+
+  /* The waste of a city depends on its distance to the gov centers. */
+  city_list_iterate(pplayer->cities, pcity) {
+    if (is_gov_center(pcity)) {
+      gov_centers = fc_realloc(gov_centers,
+                               (num_gov_centers + 1) * sizeof(*gov_centers));
+      gov_centers[num_gov_centers++] = pcity->id;
+    }
+  } city_list_iterate_end;
+
+  if (!changed
+      && pstate->turn == game.info.turn
+      && pstate->government == adv->goal.govt.gov
+      && pstate->food_priority == adv->food_priority
+      && pstate->shield_priority == adv->shield_priority
+      && pstate->science_priority == adv->science_priority
+      && pstate->handicap == handicap
+      && BV_ARE_EQUAL(pstate->techs, techs)
+      && 0 == memcmp(pstate->wonders, pplayer->wonders,
+                     sizeof(pstate->wonders))
+      && 0 == memcmp(pstate->great_wonder_owners,
+                     game.info.great_wonder_owners,
+                     sizeof(pstate->great_wonder_owners))
+      && pstate->num_gov_centers == num_gov_centers
+      && (0 == num_gov_centers
+          || 0 == memcmp(pstate->gov_centers, gov_centers,
+                         num_gov_centers * sizeof(*gov_centers)))) {
+    free(gov_centers);
+    return;
+  }
+
+  pstate->turn = game.info.turn;
+  pstate->government = adv->goal.govt.gov;
+  pstate->food_priority = adv->food_priority;
+  pstate->shield_priority = adv->shield_priority;
+  pstate->science_priority = adv->science_priority;
+  pstate->handicap = handicap;
+  pstate->techs = techs;
+  memcpy(pstate->wonders, pplayer->wonders, sizeof(pstate->wonders));
+  memcpy(pstate->great_wonder_owners, game.info.great_wonder_owners,
+         sizeof(pstate->great_wonder_owners));
+  free(pstate->gov_centers);
+  pstate->gov_centers = gov_centers;
+  pstate->num_gov_centers = num_gov_centers;
+  sites->valid_stamp = ++sites->stamp;
+}
+
+/*****************************************************************************
+  Return the total of city_site_result() for 'ptile', or -1 if no city
+  would be founded there. The value is calculated only if something it
+  depends on changed since it last was.
+*****************************************************************************/
+static int city_site_value(struct ai_type *ait, struct player *pplayer,
+                           struct tile *ptile)
+{
+  struct ai_plr *ai = dai_plr_data_get(ait, pplayer, NULL);
+  struct site_map *sites = &ai->settler->sites;
+  struct site_tile_state *pstate = &sites->tiles[tile_index(ptile)];
+  struct cityresult *cr;
+
+  if (NULL != tile_city(ptile)) {
+    /* The value of an existing city depends on the city itself. */
+    cr = city_site_result(ait, pplayer, ptile);
+    if (cr == NULL) {
+      return -1;
+    } else {
+      int value = cr->total;
+
+      cityresult_destroy(cr);
+      return value;
+    }
+  }
+
+  if (pstate->value_stamp != 0
+      && city_site_tiles_refresh(sites, pplayer, ptile,
+                                 pstate->value_radius_sq,
+                                 pstate->value_stamp)
+      && pstate->value_stamp >= sites->valid_stamp) {
+#ifdef SITEMAP_DEBUG
+    cr = city_site_result(ait, pplayer, ptile);
+    fc_assert(pstate->value == (cr != NULL ? cr->total : -1));
+    cityresult_destroy(cr);
+#endif /* SITEMAP_DEBUG */
+    return pstate->value;
+  }
+
+  cr = city_site_result(ait, pplayer, ptile);
+  pstate->value = (cr != NULL ? cr->total : -1);
+  /* The radius of the city may differ from the last time, and is not known
+   * if no city would be founded. */
+  pstate->value_radius_sq = (cr != NULL ? cr->city_radius_sq
+                             : CITY_MAP_MAX_RADIUS_SQ);
+  city_site_tiles_refresh(sites, pplayer, ptile, pstate->value_radius_sq, 0);
+  pstate->value_stamp = sites->stamp;
+  cityresult_destroy(cr);
+
+  return pstate->value;
+}
+
+/*****************************************************************************
+  Calculates the desire for founding a new city at 'ptile'. The citymap
+  ensures that we do not build cities too close to each other. Returns NULL
+  if no place was found.
+*****************************************************************************/
+struct cityresult *city_desirability(struct ai_type *ait, struct player *pplayer,
+                                     struct unit *punit, struct tile *ptile)
+{
+  struct adv_data *ai = adv_data_get(pplayer, NULL);
+
+  fc_assert_ret_val(punit, NULL);
+  fc_assert_ret_val(pplayer, NULL);
+  fc_assert_ret_val(ai, NULL);
+
+  if (!city_site_possible(pplayer, punit, ptile)) {
+    return NULL;
+  }
+
+  return city_site_result(ait, pplayer, ptile);
+}
+
 /**************************************************************************
   Find nearest and best city placement in a PF iteration according to 
   "parameter".  The value in "boat_cost" is both the penalty to pay for 
@@ -788,14 +1083,18 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
                                               struct unit *punit,
                                               int boat_cost)
 {
-  struct cityresult *cr = NULL, *best = NULL;
+  struct cityresult *best = NULL;
+  struct tile *best_tile = NULL;
+  int best_result = 0;
   int best_turn = 0; /* Which turn we found the best fit */
   struct player *pplayer = unit_owner(punit);
   struct pf_map *pfm;
 
+  city_sites_refresh(ait, pplayer);
+
   pfm = pf_map_new(parameter);
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
-    int turns;
+    int turns, value, result;
 
     if (boat_cost == 0 && unit_class(punit)->adv.sea_move == MOVE_NONE
         && tile_continent(ptile) != tile_continent(unit_tile(punit))) {
@@ -814,45 +1113,41 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
     }
 
     /* Calculate worth */
-    cr = city_desirability(ait, pplayer, punit, ptile);
+    if (!city_site_possible(pplayer, punit, ptile)) {
+      continue;
+    }
+    value = city_site_value(ait, pplayer, ptile);
 
     /* Check if actually found something */
-    if (!cr) {
+    if (value < 0) {
       continue;
     }
 
     /* This algorithm punishes long treks */
     turns = move_cost / parameter->move_rate;
-    cr->result = amortize(cr->total, PERFECTION * turns);
+    result = amortize(value, PERFECTION * turns);
 
     /* Reduce want by settler cost. Easier than amortize, but still
      * weeds out very small wants. ie we create a threshold here. */
     /* We also penalise here for using a boat (either virtual or real)
      * it's crude but what isn't? */
-    cr->result -= unit_build_shield_cost(punit) + boat_cost;
+    result -= unit_build_shield_cost(punit) + boat_cost;
 
     /* Find best spot */
-    if ((!best && cr->result > 0)
-        || (best && cr->result > best->result)) {
-      /* Destroy the old 'best' value. */
-      cityresult_destroy(best);
-      /* save the new 'best' value. */
-      best = cr;
-      cr = NULL;
+    if ((!best_tile && result > 0)
+        || (best_tile && result > best_result)) {
+      best_tile = ptile;
+      best_result = result;
       best_turn = turns;
 
       log_debug("settler map search (search): (%d,%d) %d",
-                TILE_XY(best->tile), best->result);
-    } else {
-      /* Destroy the unused result. */
-      cityresult_destroy(cr);
-      cr = NULL;
+                TILE_XY(best_tile), best_result);
     }
 
     /* Can we terminate early? We have a 'good enough' spot, and
      * we don't block the establishment of a better city just one
      * further step away. */
-    if (best && best->result > RESULT_IS_ENOUGH
+    if (best_tile && best_result > RESULT_IS_ENOUGH
         && turns > parameter->move_rate /* sic -- yeah what an explanation! */
         && best_turn < turns /*+ game.info.min_dist_bw_cities*/) {
       break;
@@ -861,7 +1156,12 @@ static struct cityresult *settler_map_iterate(struct ai_type *ait,
 
   pf_map_destroy(pfm);
 
-  if (best) {
+  if (best_tile) {
+    /* Only the best spot is worth the full result. */
+    best = city_desirability(ait, pplayer, punit, best_tile);
+    fc_assert_ret_val(best != NULL, NULL);
+    best->result = best_result;
+
     log_debug("settler map search (final): (%d,%d) %d", TILE_XY(best->tile),
               best->result);
   } else {
@@ -1215,6 +1515,8 @@ void dai_auto_settler_free(struct ai_plr *ai)
     if (ai->settler->tdc_hash) {
       tile_data_cache_hash_destroy(ai->settler->tdc_hash);
     }
+    free(ai->settler->sites.tiles);
+    free(ai->settler->sites.player.gov_centers);
     free(ai->settler);
   }
   ai->settler = NULL;
@@ -35,6 +35,7 @@
 
 /* common/aicore */
 #include "citymap.h"
+#include "pf_regions.h"
 #include "pf_tools.h"
 
 /* server */
@@ -391,7 +392,6 @@ bool dai_unit_goto_constrained(struct ai_type *ait, struct unit *punit,
                                struct pf_parameter *parameter)
 {
   bool alive = TRUE;
-  struct pf_map *pfm;
   struct pf_path *path;
 
   UNIT_LOG(LOG_DEBUG, punit, "constrained goto to %d,%d", TILE_XY(ptile));
@@ -418,8 +418,9 @@ bool dai_unit_goto_constrained(struct ai_type *ait, struct unit *punit,
     return TRUE;
   }
 
-  pfm = pf_map_new(parameter);
-  path = pf_map_path(pfm, ptile);
+  /* Distant destinations are searched through the path finding regions
+   * first, not to iterate most of the map. */
+  path = pf_regions_path(parameter, ptile);
 
   if (path) {
     dai_log_path(punit, path, parameter);
@@ -430,7 +431,6 @@ bool dai_unit_goto_constrained(struct ai_type *ait, struct unit *punit,
   }
 
   pf_path_destroy(path);
-  pf_map_destroy(pfm);
 
   return alive;
 }
@@ -112,6 +112,10 @@ static enum tai_abort_msg_class tai_check_messages(void)
     case TAI_MSG_FIRST_ACTIVITIES:
       fc_allocate_mutex(&game.server.mutexes.city_list);
 
+      /* The main thread goes on meanwhile: leave the global caches alone,
+       * and run any jobs on this thread. */
+      fc_thread_background_begin();
+
       initialize_infrastructure_cache(msg->plr);
 
       /* Use _safe iterate in case the main thread
@@ -130,6 +134,8 @@ static enum tai_abort_msg_class tai_check_messages(void)
           break;
         }
       } city_list_iterate_safe_end;
+
+      fc_thread_background_end();
       fc_release_mutex(&game.server.mutexes.city_list);
       break;
     case TAI_MSG_PHASE_FINISHED:
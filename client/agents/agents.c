@@ -20,14 +20,17 @@
 
 /* utility */
 #include "capability.h"
+#include "genhash.h"
 #include "log.h"
 #include "mem.h"
 #include "timing.h"
 
 /* client */
 #include "client_main.h"
+#include "options.h"
 
 /* include */
+#include "gui_main_g.h"
 #include "mapctrl_g.h"
 
 /* agents */
@@ -61,10 +64,18 @@ struct call {
     TYPED_LIST_ITERATE(struct call, calllist, pcall)
 #define call_list_iterate_end  LIST_ITERATE_END
 
-#define call_list_both_iterate(calllist, plink, pcall) \
-    TYPED_LIST_BOTH_ITERATE(struct call_list_link, struct call, \
-                            calllist, plink, pcall)
-#define call_list_both_iterate_end  LIST_BOTH_ITERATE_END
+static genhash_val_t call_hash_val(const struct call *pcall);
+static bool calls_are_equal(const struct call *pcall1,
+                            const struct call *pcall2);
+
+/* 'struct call_hash' and related functions. The keys and the data are the
+ * same calls, owned by the lists of outstanding calls. */
+#define SPECHASH_TAG call
+#define SPECHASH_KEY_TYPE struct call *
+#define SPECHASH_DATA_TYPE struct call *
+#define SPECHASH_KEY_VAL call_hash_val
+#define SPECHASH_KEY_COMP calls_are_equal
+#include "spechash.h"
 
 /*
  * Main data structure. Contains all registered agents and all
@@ -74,18 +85,40 @@ static struct {
   int entries_used;
   struct my_agent {
     struct agent agent;
+    /* The outstanding calls of the agents of this level. */
+    struct call_list *calls;
     int first_outstanding_request_id, last_outstanding_request_id;
     struct {
       struct timer *network_wall_timer;
       int wait_at_network, wait_at_network_requests;
     } stats;
   } entries[MAX_AGENTS];
-  struct call_list *calls;
+  /* The outstanding calls in order of execution: one list per agent
+   * level, sorted by level, each one in the order the calls came. */
+  int levels_used;
+  struct {
+    int level;
+    struct call_list *calls;
+  } levels[MAX_AGENTS];
+  /* All the outstanding calls, to discard duplicates. */
+  struct call_hash *pending;
 } agents;
 
 static bool initialized = FALSE;
 static int frozen_level;
 static bool currently_running = FALSE;
+static bool batched_calls_scheduled = FALSE;
+
+/****************************************************************************
+  Hash function for the outstanding calls.
+****************************************************************************/
+static genhash_val_t call_hash_val(const struct call *pcall)
+{
+  return ((genhash_val_t) (pcall->agent - agents.entries)
+          ^ ((genhash_val_t) pcall->type << 4)
+          ^ ((genhash_val_t) pcall->cb_type << 6)
+          ^ ((genhash_val_t) pcall->arg << 9));
+}
 
 /****************************************************************************
   Return TRUE iff the two agent calls are equal.
@@ -93,31 +126,15 @@ static bool currently_running = FALSE;
 static bool calls_are_equal(const struct call *pcall1,
 			    const struct call *pcall2)
 {
-  if (pcall1->agent != pcall2->agent) {
-    return FALSE;
-  }
-
-  if (pcall1->type != pcall2->type && pcall1->cb_type != pcall2->cb_type) {
-    return FALSE;
-  }
-
-  switch (pcall1->type) {
-  case OCT_UNIT:
-  case OCT_CITY:
-  case OCT_TILE:
-    return (pcall1->arg == pcall2->arg);
-  case OCT_NEW_TURN:
-    return TRUE;
-  }
-
-  log_error("Unsupported call type %d.", pcall1->type);
-  return FALSE;
+  return (pcall1->agent == pcall2->agent
+          && pcall1->type == pcall2->type
+          && pcall1->cb_type == pcall2->cb_type
+          && pcall1->arg == pcall2->arg);
 }
 
 /***********************************************************************
-  If the call described by the given arguments isn't contained in
-  agents.calls list, add the call to this list.
-  Maintains the list in a sorted order.
+  If the call described by the given arguments isn't outstanding yet,
+  add it at the end of the calls of the agent's level.
 ***********************************************************************/
 static void enqueue_call(struct my_agent *agent,
 			 enum oct type,
@@ -127,7 +144,6 @@ static void enqueue_call(struct my_agent *agent,
   struct call *pcall2;
   int arg = 0;
   const struct tile *ptile;
-  bool added = FALSE;
 
   va_start(ap, cb_type);
 
@@ -157,29 +173,15 @@ static void enqueue_call(struct my_agent *agent,
   pcall2->cb_type = cb_type;
   pcall2->arg = arg;
 
-  /* Ensure list is sorted so that calls to agents with lower levels
-   * come first, since that's how we'll want to pop them */
-  call_list_both_iterate(agents.calls, plink, pcall) {
-    if (calls_are_equal(pcall, pcall2)) {
-      /* Already got one like this, discard duplicate. */
-      free(pcall2);
-      return;
-    }
-    if (pcall->agent->agent.level - pcall2->agent->agent.level > 0) {
-      /* Found a level greater than ours. Can assume that calls_are_equal()
-       * will never be true from here on, since list is sorted by level and
-       * unequal levels => unequal agents => !calls_are_equal().
-       * Insert into list here. */
-      call_list_insert_before(agents.calls, pcall2, plink);
-      added = TRUE;
-      break;
-    }
-  } call_list_both_iterate_end;
-
-  if (!added) {
-    call_list_append(agents.calls, pcall2);
+  if (call_hash_lookup(agents.pending, pcall2, NULL)) {
+    /* Already got one like this, discard duplicate. */
+    free(pcall2);
+    return;
   }
 
+  call_list_append(agent->calls, pcall2);
+  call_hash_insert(agents.pending, pcall2, pcall2);
+
   log_todo_lists("A: adding call");
 
   /* agents_busy() may have changed */
@@ -187,22 +189,27 @@ static void enqueue_call(struct my_agent *agent,
 }
 
 /***********************************************************************
-  Return an outstanding call. The call is removed from the agents.calls
-  list. Returns NULL if there no more outstanding calls.
+  Return an outstanding call, the oldest one of the lowest level. The
+  call is removed from the outstanding calls. Returns NULL if there no
+  more outstanding calls.
 ***********************************************************************/
 static struct call *remove_and_return_a_call(void)
 {
-  struct call *result;
+  int i;
 
-  if (call_list_size(agents.calls) == 0) {
-    return NULL;
-  }
+  for (i = 0; i < agents.levels_used; i++) {
+    struct call *result = call_list_front(agents.levels[i].calls);
+
+    if (NULL != result) {
+      call_list_pop_front(agents.levels[i].calls);
+      call_hash_remove(agents.pending, result);
 
-  result = call_list_front(agents.calls);
-  call_list_pop_front(agents.calls);
+      log_todo_lists("A: removed call");
+      return result;
+    }
+  }
 
-  log_todo_lists("A: removed call");
-  return result;
+  return NULL;
 }
 
 /***********************************************************************
@@ -263,6 +270,18 @@ static void call_handle_methods(void)
   update_turn_done_button_state();
 }
 
+/***********************************************************************
+ Idle callback executing the calls collected while the dispatching was
+ frozen. See thaw().
+***********************************************************************/
+static void handle_batched_calls(void *data)
+{
+  batched_calls_scheduled = FALSE;
+  if (initialized && C_S_RUNNING == client_state()) {
+    call_handle_methods();
+  }
+}
+
 /***********************************************************************
  Increase the frozen_level by one.
 ***********************************************************************/
@@ -278,7 +297,10 @@ static void freeze(void)
 
 /***********************************************************************
  Decrease the frozen_level by one. If the dispatching is not frozen
- anymore (frozen_level == 0) all outstanding calls are executed.
+ anymore (frozen_level == 0) all outstanding calls are executed. With
+ the agents_batch_calls option, they are executed once the client is
+ idle, so all the packets which arrived together are handled in a
+ single pass of the agents.
 ***********************************************************************/
 static void thaw(void)
 {
@@ -286,7 +308,13 @@ static void thaw(void)
   frozen_level--;
   fc_assert(frozen_level >= 0);
   if (0 == frozen_level && C_S_RUNNING == client_state()) {
-    call_handle_methods();
+    if (!agents_batch_calls) {
+      call_handle_methods();
+    } else if (!batched_calls_scheduled
+               && 0 < call_hash_size(agents.pending)) {
+      batched_calls_scheduled = TRUE;
+      add_idle_callback(handle_batched_calls, NULL);
+    }
   }
 }
 
@@ -332,7 +360,8 @@ static bool is_outstanding_request(struct my_agent *agent)
 void agents_init(void)
 {
   agents.entries_used = 0;
-  agents.calls = call_list_new();
+  agents.levels_used = 0;
+  agents.pending = call_hash_new();
 
   /* Add init calls of agents here */
   cma_init();
@@ -369,7 +398,10 @@ void agents_free(void)
 
     timer_destroy(agent->stats.network_wall_timer);
   }
-  call_list_destroy(agents.calls);
+  for (i = 0; i < agents.levels_used; i++) {
+    call_list_destroy(agents.levels[i].calls);
+  }
+  call_hash_destroy(agents.pending);
 }
 
 /***********************************************************************
@@ -378,12 +410,28 @@ void agents_free(void)
 void register_agent(const struct agent *agent)
 {
   struct my_agent *priv_agent = &agents.entries[agents.entries_used];
+  int i;
 
   fc_assert_ret(agents.entries_used < MAX_AGENTS);
   fc_assert_ret(agent->level > 0);
 
   memcpy(&priv_agent->agent, agent, sizeof(struct agent));
 
+  /* Find the list of calls of the agent's level, or insert it. */
+  for (i = 0; i < agents.levels_used; i++) {
+    if (agents.levels[i].level >= agent->level) {
+      break;
+    }
+  }
+  if (i == agents.levels_used || agents.levels[i].level != agent->level) {
+    memmove(&agents.levels[i + 1], &agents.levels[i],
+            (agents.levels_used - i) * sizeof(agents.levels[0]));
+    agents.levels[i].level = agent->level;
+    agents.levels[i].calls = call_list_new();
+    agents.levels_used++;
+  }
+  priv_agent->calls = agents.levels[i].calls;
+
   priv_agent->first_outstanding_request_id = 0;
   priv_agent->last_outstanding_request_id = 0;
 
@@ -804,7 +852,7 @@ bool agents_busy(void)
     return FALSE;
   }
 
-  if (call_list_size(agents.calls) > 0 || frozen_level > 0
+  if (call_hash_size(agents.pending) > 0 || frozen_level > 0
       || currently_running) {
     return TRUE;
   }
@@ -21,6 +21,7 @@
 #endif
 
 /* utility */
+#include "capability.h"
 #include "fcintl.h"
 #include "log.h"
 #include "mem.h"
@@ -40,6 +41,7 @@
 
 /* client */
 #include "attribute.h"
+#include "citydlg_common.h"
 #include "client_main.h"
 #include "climisc.h"
 #include "packhand.h"
@@ -157,43 +159,19 @@ static struct city *check_city(int city_id, struct cm_parameter *parameter)
 }  
 
 /****************************************************************************
- Change the actual city setting to the given result. Returns TRUE iff
- the actual data matches the calculated one.
+ Send the requests which change the city to the given result one worker
+ or specialist at a time, for servers which can't take the whole
+ arrangement at once. Sets the ids of the first and last request sent.
 *****************************************************************************/
-static bool apply_result_on_server(struct city *pcity,
-                                   const struct cm_result *result)
+static void apply_result_in_steps(struct city *pcity,
+                                  const struct cm_result *result,
+                                  int *first_request_id,
+                                  int *last_request_id)
 {
-  int first_request_id = 0, last_request_id = 0, i;
+  int i;
   int city_radius_sq = city_map_radius_sq_get(pcity);
-  struct cm_result *current_state = cm_result_new(pcity);;
-  bool success;
   struct tile *pcenter = city_tile(pcity);
 
-  fc_assert_ret_val(result->found_a_valid, FALSE);
-  cm_result_from_main_map(current_state, pcity);
-
-  if (my_results_are_equal(current_state, result)
-      && !ALWAYS_APPLY_AT_SERVER) {
-    stats.apply_result_ignored++;
-    return TRUE;
-  }
-
-  /* Do checks */
-  if (city_size_get(pcity) != cm_result_citizens(result)) {
-    log_error("apply_result_on_server(city %d=\"%s\") bad result!",
-              pcity->id, city_name(pcity));
-    cm_print_city(pcity);
-    cm_print_result(result);
-    return FALSE;
-  }
-
-  stats.apply_result_applied++;
-
-  log_apply_result("apply_result_on_server(city %d=\"%s\")",
-                   pcity->id, city_name(pcity));
-
-  connection_do_buffer(&client.conn);
-
   /* Remove all surplus workers */
   city_tile_iterate_skip_free_worked(city_radius_sq, pcenter, ptile, index,
                                      x, y) {
@@ -201,10 +179,10 @@ static bool apply_result_on_server(struct city *pcity,
         && !result->worker_positions[index]) {
       log_apply_result("Removing worker at {%d,%d}.", x, y);
 
-      last_request_id =
+      *last_request_id =
         dsend_packet_city_make_specialist(&client.conn, pcity->id, x, y);
-      if (first_request_id == 0) {
-        first_request_id = last_request_id;
+      if (*first_request_id == 0) {
+        *first_request_id = *last_request_id;
       }
     }
   } city_tile_iterate_skip_free_worked_end;
@@ -218,10 +196,10 @@ static bool apply_result_on_server(struct city *pcity,
     for (i = 0; i < pcity->specialists[sp] - result->specialists[sp]; i++) {
       log_apply_result("Change specialist from %d to %d.",
                        sp, DEFAULT_SPECIALIST);
-      last_request_id = city_change_specialist(pcity,
+      *last_request_id = city_change_specialist(pcity,
 					       sp, DEFAULT_SPECIALIST);
-      if (first_request_id == 0) {
-	first_request_id = last_request_id;
+      if (*first_request_id == 0) {
+	*first_request_id = *last_request_id;
       }
     }
   } specialist_type_iterate_end;
@@ -238,10 +216,10 @@ static bool apply_result_on_server(struct city *pcity,
       log_apply_result("Putting worker at {%d,%d}.", x, y);
       fc_assert_action(city_can_work_tile(pcity, ptile), break);
 
-      last_request_id =
+      *last_request_id =
         dsend_packet_city_make_worker(&client.conn, pcity->id, x, y);
-      if (first_request_id == 0) {
-	first_request_id = last_request_id;
+      if (*first_request_id == 0) {
+	*first_request_id = *last_request_id;
       }
     }
   } city_tile_iterate_skip_free_worked_end;
@@ -256,13 +234,59 @@ static bool apply_result_on_server(struct city *pcity,
     for (i = 0; i < result->specialists[sp] - pcity->specialists[sp]; i++) {
       log_apply_result("Changing specialist from %d to %d.",
                        DEFAULT_SPECIALIST, sp);
-      last_request_id = city_change_specialist(pcity,
+      *last_request_id = city_change_specialist(pcity,
 					       DEFAULT_SPECIALIST, sp);
-      if (first_request_id == 0) {
-	first_request_id = last_request_id;
+      if (*first_request_id == 0) {
+	*first_request_id = *last_request_id;
       }
     }
   } specialist_type_iterate_end;
+}
+
+/****************************************************************************
+ Change the actual city setting to the given result. Returns TRUE iff
+ the actual data matches the calculated one.
+*****************************************************************************/
+static bool apply_result_on_server(struct city *pcity,
+                                   const struct cm_result *result)
+{
+  int first_request_id = 0, last_request_id = 0;
+  struct cm_result *current_state = cm_result_new(pcity);;
+  bool success;
+
+  fc_assert_ret_val(result->found_a_valid, FALSE);
+  cm_result_from_main_map(current_state, pcity);
+
+  if (my_results_are_equal(current_state, result)
+      && !ALWAYS_APPLY_AT_SERVER) {
+    stats.apply_result_ignored++;
+    return TRUE;
+  }
+
+  /* Do checks */
+  if (city_size_get(pcity) != cm_result_citizens(result)) {
+    log_error("apply_result_on_server(city %d=\"%s\") bad result!",
+              pcity->id, city_name(pcity));
+    cm_print_city(pcity);
+    cm_print_result(result);
+    return FALSE;
+  }
+
+  stats.apply_result_applied++;
+
+  log_apply_result("apply_result_on_server(city %d=\"%s\")",
+                   pcity->id, city_name(pcity));
+
+  connection_do_buffer(&client.conn);
+
+  if (has_capability("city_arrange", client.conn.capability)) {
+    /* The server checks and sets the whole arrangement at once. */
+    first_request_id = last_request_id =
+      city_arrange_workers(pcity, result);
+  } else {
+    apply_result_in_steps(pcity, result, &first_request_id,
+                          &last_request_id);
+  }
 
   if (last_request_id == 0 || ALWAYS_APPLY_AT_SERVER) {
       /*
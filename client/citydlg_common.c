@@ -26,6 +26,9 @@
 #include "specialist.h"
 #include "unitlist.h"
 
+/* common/aicore */
+#include "cm.h"
+
 /* client/include */
 #include "citydlg_g.h"
 #include "mapview_g.h"
@@ -1075,6 +1078,32 @@ int city_toggle_worker(struct city *pcity, int city_x, int city_y)
   }
 }
 
+/**************************************************************************
+  Tell the server to set all workers and specialists of the city as in
+  the given result, in a single request.  Return the request ID.
+**************************************************************************/
+int city_arrange_workers(struct city *pcity, const struct cm_result *result)
+{
+  struct packet_city_arrange_workers packet;
+
+  packet.city_id = pcity->id;
+  packet.city_radius_sq = result->city_radius_sq;
+
+  packet.specialists_size = specialist_count();
+  specialist_type_iterate(sp) {
+    packet.specialists[sp] = result->specialists[sp];
+  } specialist_type_iterate_end;
+
+  packet.workers_count = 0;
+  city_map_iterate(result->city_radius_sq, cindex, x, y) {
+    if (!is_free_worked_index(cindex) && result->worker_positions[cindex]) {
+      packet.workers[packet.workers_count++] = cindex;
+    }
+  } city_map_iterate_end;
+
+  return send_packet_city_arrange_workers(&client.conn, &packet);
+}
+
 /**************************************************************************
   Tell the server to rename the city.  Return the request ID.
 **************************************************************************/
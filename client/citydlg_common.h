@@ -26,6 +26,7 @@ extern "C" {
 #include "city.h"
 
 struct canvas;
+struct cm_result;
 struct worklist;
 
 int get_citydlg_canvas_width(void);
@@ -80,6 +81,7 @@ int city_buy_production(struct city *pcity);
 int city_change_specialist(struct city *pcity, Specialist_type_id from,
                            Specialist_type_id to);
 int city_toggle_worker(struct city *pcity, int city_x, int city_y);
+int city_arrange_workers(struct city *pcity, const struct cm_result *result);
 int city_rename(struct city *pcity, const char *name);
 
 #ifdef __cplusplus
@@ -90,6 +90,7 @@ int smooth_move_unit_msec = 30;
 int smooth_center_slide_msec = 200;
 int smooth_combat_step_msec = 10;
 bool ai_manual_turn_done = TRUE;
+bool agents_batch_calls = TRUE;
 bool auto_center_on_unit = TRUE;
 bool auto_center_on_combat = FALSE;
 bool auto_center_each_turn = TRUE;
@@ -1981,6 +1982,14 @@ static struct client_option client_options[] = {
                      "press the Turn Done button manually when watching "
                      "an AI player."),
                   COC_INTERFACE, GUI_STUB, TRUE, NULL),
+  GEN_BOOL_OPTION(agents_batch_calls,
+                  N_("Batch the updates of the city governor"),
+                  N_("If this option is enabled, the city governor and "
+                     "the other client agents handle all the changes "
+                     "received together from the server in one pass, "
+                     "instead of once per network read.  This makes the "
+                     "start of turns faster with many governed cities."),
+                  COC_INTERFACE, GUI_STUB, TRUE, NULL),
   GEN_BOOL_OPTION(auto_center_on_unit, N_("Auto center on units"),
                   N_("Set this option to have the active unit centered "
                      "automatically when the unit focus changes."),
@@ -67,6 +67,7 @@ extern int smooth_move_unit_msec;
 extern int smooth_center_slide_msec;
 extern int smooth_combat_step_msec;
 extern bool ai_manual_turn_done;
+extern bool agents_batch_calls;
 extern bool auto_center_on_unit;
 extern bool auto_center_on_combat;
 extern bool auto_center_each_turn;
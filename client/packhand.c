@@ -29,6 +29,7 @@
 /* common */
 #include "capstr.h"
 #include "citizens.h"
+#include "cityindex.h"
 #include "events.h"
 #include "game.h"
 #include "government.h"
@@ -596,6 +597,7 @@ void handle_city_info(const struct packet_city_info *packet)
       ptile = pcenter;
       pcity->owner = powner;
       pcity->original = powner;
+      cityindex_add(pcity);
     } else if (city_owner(pcity) != powner) {
       /* Remember what were the worked tiles.  The server won't
        * send to us again. */
@@ -1002,6 +1004,7 @@ void handle_city_short_info(const struct packet_city_short_info *packet)
       ptile = pcenter;
       pcity->owner = powner;
       pcity->original = powner;
+      cityindex_add(pcity);
 
       whole_map_iterate(ptile) {
         if (ptile->worked == pcity) {
@@ -1922,6 +1925,7 @@ void handle_game_info(const struct packet_game_info *pinfo)
   }
 
   game.info = *pinfo;
+  requirement_cache_invalidate();
 
   if (!has_capability("illness_ranges", client.conn.capability)) {
     /* Fill current values from the old-format values sent by older server. */
@@ -2169,6 +2173,7 @@ void handle_player_info(const struct packet_player_info *pinfo)
   for (i = 0; i < B_LAST; i++) {
     pplayer->wonders[i] = pinfo->wonders[i];
   }
+  requirement_cache_invalidate();
 
   /* We need to set ai.control before read_player_info_techs */
   if (pplayer->ai_controlled != pinfo->ai)  {
@@ -2899,6 +2904,49 @@ void handle_tile_info(const struct packet_tile_info *packet)
   }
 }
 
+/****************************************************************************
+  Packet tile_info_block handler: the tiles are handled as if they came
+  in their own tile_info packets.
+****************************************************************************/
+void handle_tile_info_block(const struct packet_tile_info_block *packet)
+{
+  struct packet_tile_info info;
+  int tile = packet->first;
+  int i, j;
+
+  info.spec_sprite[0] = '\0';
+  info.label[0] = '\0';
+
+  for (i = 0; i < packet->runs; i++) {
+    info.known = packet->known[i];
+    info.continent = packet->continent[i];
+    info.owner = packet->owner[i];
+    info.worked = packet->worked[i];
+    info.terrain = packet->terrain[i];
+    info.resource = packet->resource[i];
+    tile_special_type_iterate(spe) {
+      info.special[spe] = ((packet->special[i] >> spe) & 1);
+    } tile_special_type_iterate_end;
+    BV_CLR_ALL(info.bases);
+    for (j = 0; j < MAX_BASE_TYPES; j++) {
+      if ((((unsigned) packet->bases[i]) >> j) & 1) {
+        BV_SET(info.bases, j);
+      }
+    }
+    BV_CLR_ALL(info.roads);
+    for (j = 0; j < MAX_ROAD_TYPES; j++) {
+      if ((packet->roads[i] >> j) & 1) {
+        BV_SET(info.roads, j);
+      }
+    }
+
+    for (j = 0; j < packet->length[i]; j++) {
+      info.tile = tile++;
+      handle_tile_info(&info);
+    }
+  }
+}
+
 /****************************************************************************
   Received packet containing info about current scenario
 ****************************************************************************/
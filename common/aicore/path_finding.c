@@ -88,6 +88,8 @@ struct pf_map {
   /* Private data. */
   struct tile *tile;          /* The current position (aka iterator). */
   struct pf_parameter params; /* Initial parameters. */
+  const struct dbv *area;     /* The tiles which may be iterated, or NULL
+                               * for the whole map. See pf_map_new_area(). */
 };
 
 /* Down-cast macro. */
@@ -95,6 +97,15 @@ struct pf_map {
 
 /* ========================== Common functions =========================== */
 
+/****************************************************************************
+  Returns whether the tile is in the area the map is restricted to.
+****************************************************************************/
+static inline bool pf_map_in_area(const struct pf_map *pfm,
+                                  const struct tile *ptile)
+{
+  return (NULL == pfm->area || dbv_isset(pfm->area, tile_index(ptile)));
+}
+
 /****************************************************************************
   Return the number of "moves" started with.
 
@@ -280,6 +291,9 @@ static void pf_normal_node_init(struct pf_normal_map *pfnm,
     /* The default. */
     node->behavior = TB_NORMAL;
   }
+  if (!pf_map_in_area(PF_MAP(pfnm), ptile)) {
+    node->behavior = TB_IGNORE;
+  }
 
   if (NULL != params->get_zoc) {
     struct city *pcity = tile_city(ptile);
@@ -797,6 +811,7 @@ static struct pf_map *pf_normal_map_new(const struct pf_parameter *parameter)
 
   /* Initialise the iterator. */
   base_map->tile = params->start_tile;
+  base_map->area = NULL;
 
   /* Initialise starting node. */
   node = pfnm->lattice + tile_index(params->start_tile);
@@ -909,6 +924,9 @@ static void pf_danger_node_init(struct pf_danger_map *pfdm,
     /* The default. */
     node->behavior = TB_NORMAL;
   }
+  if (!pf_map_in_area(PF_MAP(pfdm), ptile)) {
+    node->behavior = TB_IGNORE;
+  }
 
   if (NULL != params->get_zoc) {
     struct city *pcity = tile_city(ptile);
@@ -1656,6 +1674,7 @@ static struct pf_map *pf_danger_map_new(const struct pf_parameter *parameter)
 
   /* Initialise the iterator. */
   base_map->tile = params->start_tile;
+  base_map->area = NULL;
 
   /* Initialise starting node. */
   node = pfdm->lattice + tile_index(params->start_tile);
@@ -1798,6 +1817,9 @@ static void pf_fuel_node_init(struct pf_fuel_map *pffm,
     /* The default. */
     node->behavior = TB_NORMAL;
   }
+  if (!pf_map_in_area(PF_MAP(pffm), ptile)) {
+    node->behavior = TB_IGNORE;
+  }
 
   if (NULL != params->get_zoc) {
     struct city *pcity = tile_city(ptile);
@@ -2787,6 +2809,7 @@ static struct pf_map *pf_fuel_map_new(const struct pf_parameter *parameter)
 
   /* Initialise the iterator. */
   base_map->tile = params->start_tile;
+  base_map->area = NULL;
 
   /* Initialise starting node. */
   node = pffm->lattice + tile_index(params->start_tile);
@@ -2833,6 +2856,25 @@ struct pf_map *pf_map_new(const struct pf_parameter *parameter)
   return pf_normal_map_new(parameter);
 }
 
+/****************************************************************************
+  Same as pf_map_new(), but the map only iterates the tiles set in 'area',
+  a bit vector of MAP_INDEX_SIZE bits indexed by tile index. The other
+  tiles are treated like TB_IGNORE ones. 'area' is not copied, it must stay
+  valid and unchanged until the map is destroyed.
+****************************************************************************/
+struct pf_map *pf_map_new_area(const struct pf_parameter *parameter,
+                               const struct dbv *area)
+{
+  struct pf_map *pfm = pf_map_new(parameter);
+
+  fc_assert(dbv_bits((struct dbv *) area) == MAP_INDEX_SIZE);
+  /* The start node is initialized already, so the start tile is
+   * iterated even if it is not in the area. */
+  pfm->area = area;
+
+  return pfm;
+}
+
 /****************************************************************************
   After usage the map must be destroyed.
 ****************************************************************************/
@@ -420,6 +420,9 @@ struct pf_reverse_map;
 /* Create and free. */
 struct pf_map *pf_map_new(const struct pf_parameter *parameter)
                fc__warn_unused_result;
+struct pf_map *pf_map_new_area(const struct pf_parameter *parameter,
+                               const struct dbv *area)
+               fc__warn_unused_result;
 void pf_map_destroy(struct pf_map *pfm);
 
 /* Method A) functions. */
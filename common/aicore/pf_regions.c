@@ -0,0 +1,568 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <fc_config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+/* utility */
+#include "bitvector.h"
+#include "log.h"
+#include "mem.h"
+#include "shared.h"
+
+/* common */
+#include "game.h"
+#include "map.h"
+#include "movement.h"
+#include "tile.h"
+#include "unittype.h"
+
+#include "pf_regions.h"
+
+/* For explanations on how to use this module, see "pf_regions.h". */
+
+#define SPECPQ_TAG pf_region
+#define SPECPQ_DATA_TYPE int
+#define SPECPQ_PRIORITY_TYPE int
+#include "specpq.h"
+#define INITIAL_QUEUE_SIZE 100
+
+/* The size of the blocks, in native positions. */
+#define PF_REGION_SIZE 8
+/* The paths to nearer tiles are searched on the whole map. */
+#define PF_REGIONS_MIN_DIST (2 * PF_REGION_SIZE)
+/* The highest move cost counted for a tile. */
+#define PF_REGION_MAX_MC (3 * SINGLE_MOVE)
+
+/* A move from a region to a tile of another block. */
+struct pf_region_link {
+  int region;
+  int tile;
+};
+
+struct pf_region_info {
+  int center;           /* The tile of the region nearest to its middle. */
+  int move_cost;        /* The average cost of the cheapest move from each
+                         * of its tiles. */
+};
+
+struct pf_region_block {
+  bool dirty;           /* Whether the regions and the links must be
+                         * found again. */
+  int num_links;
+  struct pf_region_link *links;
+};
+
+struct pf_region_layer {
+  int *root;            /* For each tile, the index of the first tile of
+                         * its region, or -1 if the unit class cannot
+                         * enter the tile. */
+  struct pf_region_info *info; /* Indexed by the first tiles of the
+                                * regions. */
+  struct pf_region_block *blocks;
+};
+
+static struct {
+  bool enabled;
+  int size;             /* The MAP_INDEX_SIZE the layers are made for. */
+  int xblocks, yblocks;
+  struct pf_region_layer *layers[UCL_LAST];
+
+  /* The buffers of pf_regions_route(), kept between the searches. The
+   * entries of 'cost' and 'done' are reset after each search, only for
+   * the regions listed in 'touched'. */
+  int *cost;            /* Indexed by region, -1 if not reached. */
+  int *parent;          /* Indexed by region. */
+  bool *done;           /* Indexed by region. */
+  int *touched;
+  int *route;           /* The regions of the last route found. */
+  int num_route;
+  struct dbv area;      /* The tiles around the last route found. */
+} pf_regions;
+
+/****************************************************************************
+  Turn the region layer on or off. Turning it off frees the layers.
+****************************************************************************/
+void pf_regions_enable(bool enable)
+{
+  int num_blocks = pf_regions.xblocks * pf_regions.yblocks;
+  int i, j;
+
+  for (i = 0; i < UCL_LAST; i++) {
+    struct pf_region_layer *layer = pf_regions.layers[i];
+
+    if (NULL != layer) {
+      for (j = 0; j < num_blocks; j++) {
+        free(layer->blocks[j].links);
+      }
+      free(layer->blocks);
+      free(layer->info);
+      free(layer->root);
+      FC_FREE(pf_regions.layers[i]);
+    }
+  }
+  FC_FREE(pf_regions.cost);
+  FC_FREE(pf_regions.parent);
+  FC_FREE(pf_regions.done);
+  FC_FREE(pf_regions.touched);
+  FC_FREE(pf_regions.route);
+  dbv_free(&pf_regions.area);
+  pf_regions.size = 0;
+  pf_regions.enabled = enable;
+}
+
+/****************************************************************************
+  Returns the index of the block of the tile.
+****************************************************************************/
+static inline int pf_region_block(const struct tile *ptile)
+{
+  int nat_x, nat_y;
+
+  index_to_native_pos(&nat_x, &nat_y, tile_index(ptile));
+  return ((nat_y / PF_REGION_SIZE) * pf_regions.xblocks
+          + nat_x / PF_REGION_SIZE);
+}
+
+/****************************************************************************
+  Returns whether the region of the tile is to be found: whether the unit
+  class can enter it.
+****************************************************************************/
+static inline bool pf_region_open(const struct unit_class *pclass,
+                                  const struct tile *ptile)
+{
+  return (is_native_tile_to_class(pclass, ptile)
+          || NULL != tile_city(ptile));
+}
+
+/****************************************************************************
+  Mark the regions of the tile, and the links to it, to be found again.
+  Must be called when the terrain, the roads, the bases or the city of the
+  tile change, and with NULL when the map is freed, to free the layers.
+****************************************************************************/
+void pf_regions_tile_changed(const struct tile *ptile)
+{
+  int tindex, block, i;
+
+  if (NULL == ptile) {
+    pf_regions_enable(pf_regions.enabled);
+    return;
+  }
+
+  tindex = tile_index(ptile);
+  if (pf_regions.size != MAP_INDEX_SIZE
+      || 0 > tindex || tindex >= MAP_INDEX_SIZE
+      || ptile != map.tiles + tindex) {
+    /* No layer for this map, or a virtual tile. */
+    return;
+  }
+
+  block = pf_region_block(ptile);
+  for (i = 0; i < UCL_LAST; i++) {
+    struct pf_region_layer *layer = pf_regions.layers[i];
+
+    if (NULL != layer) {
+      layer->blocks[block].dirty = TRUE;
+      adjc_iterate(ptile, adjc_tile) {
+        layer->blocks[pf_region_block(adjc_tile)].dirty = TRUE;
+      } adjc_iterate_end;
+    }
+  }
+}
+
+/****************************************************************************
+  Returns the region layer of the unit class, making it if needed.
+****************************************************************************/
+static struct pf_region_layer *pf_regions_layer(const struct unit_class
+                                                *pclass)
+{
+  struct pf_region_layer *layer;
+  int num_blocks, i;
+
+  if (pf_regions.size != MAP_INDEX_SIZE) {
+    pf_regions_enable(TRUE);
+    pf_regions.size = MAP_INDEX_SIZE;
+    pf_regions.xblocks = (map.xsize + PF_REGION_SIZE - 1) / PF_REGION_SIZE;
+    pf_regions.yblocks = (map.ysize + PF_REGION_SIZE - 1) / PF_REGION_SIZE;
+
+    pf_regions.cost = fc_malloc(MAP_INDEX_SIZE * sizeof(*pf_regions.cost));
+    pf_regions.parent = fc_malloc(MAP_INDEX_SIZE
+                                  * sizeof(*pf_regions.parent));
+    pf_regions.done = fc_calloc(MAP_INDEX_SIZE, sizeof(*pf_regions.done));
+    pf_regions.touched = fc_malloc(MAP_INDEX_SIZE
+                                   * sizeof(*pf_regions.touched));
+    pf_regions.route = fc_malloc(MAP_INDEX_SIZE
+                                 * sizeof(*pf_regions.route));
+    pf_regions.num_route = 0;
+    for (i = 0; i < MAP_INDEX_SIZE; i++) {
+      pf_regions.cost[i] = -1;
+    }
+    dbv_init(&pf_regions.area, MAP_INDEX_SIZE);
+  }
+
+  layer = pf_regions.layers[uclass_index(pclass)];
+  if (NULL == layer) {
+    num_blocks = pf_regions.xblocks * pf_regions.yblocks;
+    layer = fc_malloc(sizeof(*layer));
+    layer->root = fc_malloc(MAP_INDEX_SIZE * sizeof(*layer->root));
+    layer->info = fc_malloc(MAP_INDEX_SIZE * sizeof(*layer->info));
+    layer->blocks = fc_calloc(num_blocks, sizeof(*layer->blocks));
+    for (i = 0; i < num_blocks; i++) {
+      layer->blocks[i].dirty = TRUE;
+    }
+    pf_regions.layers[uclass_index(pclass)] = layer;
+  }
+
+  return layer;
+}
+
+/****************************************************************************
+  Get the native positions of the block: from (*x0, *y0) included to
+  (*x1, *y1) excluded.
+****************************************************************************/
+static void pf_region_block_bounds(int block, int *x0, int *y0,
+                                   int *x1, int *y1)
+{
+  *x0 = (block % pf_regions.xblocks) * PF_REGION_SIZE;
+  *y0 = (block / pf_regions.xblocks) * PF_REGION_SIZE;
+  *x1 = MIN(*x0 + PF_REGION_SIZE, map.xsize);
+  *y1 = MIN(*y0 + PF_REGION_SIZE, map.ysize);
+}
+
+/****************************************************************************
+  Find the center and the average move cost of the region of the block
+  starting at the tile 'root'.
+****************************************************************************/
+static void pf_region_info_update(struct pf_region_layer *layer,
+                                  const struct unit_class *pclass,
+                                  int block, int root)
+{
+  struct pf_region_info *pinfo = layer->info + root;
+  int x0, y0, x1, y1, x, y;
+  int num = 0, sum_x = 0, sum_y = 0, sum_cost = 0, best_dist = FC_INFINITY;
+
+  pf_region_block_bounds(block, &x0, &y0, &x1, &y1);
+  for (y = y0; y < y1; y++) {
+    for (x = x0; x < x1; x++) {
+      struct tile *ptile = native_pos_to_tile(x, y);
+      int move_cost = PF_REGION_MAX_MC;
+
+      if (layer->root[tile_index(ptile)] != root) {
+        continue;
+      }
+
+      adjc_iterate(ptile, adjc_tile) {
+        if (pf_region_open(pclass, adjc_tile)) {
+          move_cost = MIN(move_cost,
+                          map_move_cost(NULL, pclass, ptile, adjc_tile));
+        }
+      } adjc_iterate_end;
+
+      num++;
+      sum_x += x;
+      sum_y += y;
+      sum_cost += CLIP(1, move_cost, PF_REGION_MAX_MC);
+    }
+  }
+
+  pinfo->move_cost = sum_cost / num;
+  for (y = y0; y < y1; y++) {
+    for (x = x0; x < x1; x++) {
+      int tindex = native_pos_to_index(x, y);
+      int dist = (abs(x * num - sum_x) + abs(y * num - sum_y));
+
+      if (layer->root[tindex] == root && dist < best_dist) {
+        pinfo->center = tindex;
+        best_dist = dist;
+      }
+    }
+  }
+}
+
+/****************************************************************************
+  Find the regions of the block: the sets of its tiles connected by moves
+  between tiles the unit class can enter, without leaving the block. Then
+  find the links from them to the other blocks.
+****************************************************************************/
+static void pf_region_block_update(struct pf_region_layer *layer,
+                                   const struct unit_class *pclass,
+                                   int block)
+{
+  struct pf_region_block *pblock = layer->blocks + block;
+  struct pf_region_link links[PF_REGION_SIZE * PF_REGION_SIZE * 8];
+  int stack[PF_REGION_SIZE * PF_REGION_SIZE];
+  int num_links = 0;
+  int x0, y0, x1, y1, x, y;
+
+  pf_region_block_bounds(block, &x0, &y0, &x1, &y1);
+
+  /* -2 marks the tiles of which the region is not found yet. */
+  for (y = y0; y < y1; y++) {
+    for (x = x0; x < x1; x++) {
+      struct tile *ptile = native_pos_to_tile(x, y);
+
+      layer->root[tile_index(ptile)] = (pf_region_open(pclass, ptile)
+                                        ? -2 : -1);
+    }
+  }
+
+  for (y = y0; y < y1; y++) {
+    for (x = x0; x < x1; x++) {
+      int root = native_pos_to_index(x, y);
+      int num = 0;
+
+      if (-2 != layer->root[root]) {
+        continue;
+      }
+
+      layer->root[root] = root;
+      stack[num++] = root;
+      while (0 < num) {
+        adjc_iterate(index_to_tile(stack[--num]), adjc_tile) {
+          int adjc_index = tile_index(adjc_tile);
+
+          if (pf_region_block(adjc_tile) == block
+              && -2 == layer->root[adjc_index]) {
+            layer->root[adjc_index] = root;
+            stack[num++] = adjc_index;
+          }
+        } adjc_iterate_end;
+      }
+      pf_region_info_update(layer, pclass, block, root);
+    }
+  }
+
+  for (y = y0; y < y1; y++) {
+    for (x = x0; x < x1; x++) {
+      struct tile *ptile = native_pos_to_tile(x, y);
+      int root = layer->root[tile_index(ptile)];
+
+      if (0 > root) {
+        continue;
+      }
+
+      adjc_iterate(ptile, adjc_tile) {
+        if (pf_region_block(adjc_tile) != block
+            && pf_region_open(pclass, adjc_tile)) {
+          links[num_links].region = root;
+          links[num_links].tile = tile_index(adjc_tile);
+          num_links++;
+        }
+      } adjc_iterate_end;
+    }
+  }
+
+  FC_FREE(pblock->links);
+  pblock->num_links = num_links;
+  if (0 < num_links) {
+    pblock->links = fc_malloc(num_links * sizeof(*pblock->links));
+    memcpy(pblock->links, links, num_links * sizeof(*pblock->links));
+  }
+  pblock->dirty = FALSE;
+}
+
+/****************************************************************************
+  Returns the region of the tile: the index of its first tile, or -1 if
+  the unit class cannot enter the tile.
+****************************************************************************/
+static int pf_region_root(struct pf_region_layer *layer,
+                          const struct unit_class *pclass,
+                          const struct tile *ptile)
+{
+  int block = pf_region_block(ptile);
+
+  if (layer->blocks[block].dirty) {
+    pf_region_block_update(layer, pclass, block);
+  }
+
+  return layer->root[tile_index(ptile)];
+}
+
+/****************************************************************************
+  Add the tiles of the block and of the blocks around it to the area, or
+  remove them from it.
+****************************************************************************/
+static void pf_region_area_set(struct dbv *area, int block, bool add)
+{
+  int bx = block % pf_regions.xblocks;
+  int by = block / pf_regions.xblocks;
+  int dx, dy, x0, y0, x1, y1, x, y;
+
+  for (dy = -1; dy <= 1; dy++) {
+    int ay = by + dy;
+
+    if (current_topo_has_flag(TF_WRAPY)) {
+      ay = FC_WRAP(ay, pf_regions.yblocks);
+    } else if (0 > ay || ay >= pf_regions.yblocks) {
+      continue;
+    }
+    for (dx = -1; dx <= 1; dx++) {
+      int ax = bx + dx;
+
+      if (current_topo_has_flag(TF_WRAPX)) {
+        ax = FC_WRAP(ax, pf_regions.xblocks);
+      } else if (0 > ax || ax >= pf_regions.xblocks) {
+        continue;
+      }
+
+      pf_region_block_bounds(ay * pf_regions.xblocks + ax,
+                             &x0, &y0, &x1, &y1);
+      for (y = y0; y < y1; y++) {
+        for (x = x0; x < x1; x++) {
+          if (add) {
+            dbv_set(area, native_pos_to_index(x, y));
+          } else {
+            dbv_clr(area, native_pos_to_index(x, y));
+          }
+        }
+      }
+    }
+  }
+}
+
+/****************************************************************************
+  Search the cheapest route over the regions from the region 'src' to the
+  region 'dest', and add the blocks around it to pf_regions.area. The cost
+  of a step to an adjacent region is the distance between their centers
+  times their average move cost. Returns FALSE if there is no such route.
+****************************************************************************/
+static bool pf_regions_route(struct pf_region_layer *layer,
+                             const struct unit_class *pclass,
+                             int src, int dest)
+{
+  struct pf_region_pq *queue = pf_region_pq_new(INITIAL_QUEUE_SIZE);
+  int *cost = pf_regions.cost;
+  int *parent = pf_regions.parent;
+  bool *done = pf_regions.done;
+  int num_touched = 0;
+  bool found = FALSE;
+  int region, i;
+
+  cost[src] = 0;
+  parent[src] = -1;
+  pf_regions.touched[num_touched++] = src;
+  pf_region_pq_insert(queue, src, 0);
+  while (pf_region_pq_remove(queue, &region)) {
+    const struct pf_region_block *pblock
+      = layer->blocks + pf_region_block(index_to_tile(region));
+    const struct pf_region_info *pinfo = layer->info + region;
+
+    if (done[region]) {
+      continue;
+    }
+    done[region] = TRUE;
+    if (region == dest) {
+      found = TRUE;
+      break;
+    }
+
+    for (i = 0; i < pblock->num_links; i++) {
+      const struct pf_region_link *plink = pblock->links + i;
+      const struct pf_region_info *adjc_info;
+      int adjc_region, new_cost;
+
+      if (plink->region != region) {
+        continue;
+      }
+      adjc_region = pf_region_root(layer, pclass, index_to_tile(plink->tile));
+      if (0 > adjc_region || done[adjc_region]) {
+        continue;
+      }
+      adjc_info = layer->info + adjc_region;
+
+      new_cost = (cost[region]
+                  + MAX(1, real_map_distance(index_to_tile(pinfo->center),
+                                             index_to_tile(adjc_info->center)))
+                  * (pinfo->move_cost + adjc_info->move_cost) / 2);
+      if (0 > cost[adjc_region]) {
+        pf_regions.touched[num_touched++] = adjc_region;
+      }
+      if (0 > cost[adjc_region] || new_cost < cost[adjc_region]) {
+        cost[adjc_region] = new_cost;
+        parent[adjc_region] = region;
+        pf_region_pq_insert(queue, adjc_region, -new_cost);
+      }
+    }
+  }
+
+  pf_regions.num_route = 0;
+  if (found) {
+    for (region = dest; 0 <= region; region = parent[region]) {
+      pf_regions.route[pf_regions.num_route++] = region;
+      pf_region_area_set(&pf_regions.area,
+                         pf_region_block(index_to_tile(region)), TRUE);
+    }
+  }
+
+  for (i = 0; i < num_touched; i++) {
+    cost[pf_regions.touched[i]] = -1;
+    done[pf_regions.touched[i]] = FALSE;
+  }
+  pf_region_pq_destroy(queue);
+
+  return found;
+}
+
+/****************************************************************************
+  Returns the path to 'ptile' found by pf_map_path() on a map made from
+  'parameter', or NULL if 'ptile' cannot be reached.
+
+  When the region layer is on and 'ptile' is distant, the path is first
+  searched only in the blocks around the route over the regions, so most
+  of the map is not iterated. The path found this way may be a bit longer
+  than the best one. If there is no such path (e.g. the unit must use a
+  transport), the whole map is searched. Parameters without omniscience
+  always search the whole map, not to use what the player doesn't know
+  when choosing the route.
+****************************************************************************/
+struct pf_path *pf_regions_path(const struct pf_parameter *parameter,
+                                struct tile *ptile)
+{
+  struct pf_map *pfm;
+  struct pf_path *path = NULL;
+
+  if (pf_regions.enabled
+      && parameter->omniscience
+      && NULL == parameter->get_costs
+      && real_map_distance(parameter->start_tile, ptile)
+         >= PF_REGIONS_MIN_DIST) {
+    const struct unit_class *pclass = parameter->uclass;
+    struct pf_region_layer *layer = pf_regions_layer(pclass);
+    int src = pf_region_root(layer, pclass, parameter->start_tile);
+    int dest = pf_region_root(layer, pclass, ptile);
+    int i;
+
+    if (0 <= src && 0 <= dest && pf_regions_route(layer, pclass, src, dest)) {
+      pfm = pf_map_new_area(parameter, &pf_regions.area);
+      path = pf_map_path(pfm, ptile);
+      pf_map_destroy(pfm);
+
+      for (i = 0; i < pf_regions.num_route; i++) {
+        pf_region_area_set(&pf_regions.area,
+                           pf_region_block(index_to_tile(pf_regions.route[i])),
+                           FALSE);
+      }
+    }
+  }
+
+  if (NULL == path) {
+    pfm = pf_map_new(parameter);
+    path = pf_map_path(pfm, ptile);
+    pf_map_destroy(pfm);
+  }
+
+  return path;
+}
@@ -0,0 +1,48 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+#ifndef FC__PF_REGIONS_H
+#define FC__PF_REGIONS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* common/aicore */
+#include "path_finding.h"
+
+/*
+ * The region layer is a coarse graph over the map, used to speed up the
+ * searches of paths to distant tiles. The map is cut into square blocks
+ * of native positions, and each block into regions: the sets of its
+ * tiles which are connected by moves on native tiles (or cities) of a
+ * given unit class. A search first looks for a route over the regions,
+ * then searches the real path only in the blocks around that route.
+ *
+ * The layer must be turned on by pf_regions_enable(), and then be told
+ * about every change of the tiles through pf_regions_tile_changed(), which
+ * the server sets as game.callbacks.tile_changed. It is updated lazily
+ * when searching, so it is not thread safe.
+ */
+
+void pf_regions_enable(bool enable);
+void pf_regions_tile_changed(const struct tile *ptile);
+
+struct pf_path *pf_regions_path(const struct pf_parameter *parameter,
+                                struct tile *ptile)
+                fc__warn_unused_result;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FC__PF_REGIONS_H */
@@ -29,6 +29,7 @@
 /* common */
 #include "ai.h"
 #include "citizens.h"
+#include "cityindex.h"
 #include "effects.h"
 #include "game.h"
 #include "government.h"
@@ -1468,11 +1469,9 @@ enum city_build_result city_build_here_test(const struct tile *ptile,
 
   /* citymindist minimum is 1, meaning adjacent is okay */
   citymindist = game.info.citymindist;
-  square_iterate(ptile, citymindist - 1, ptile1) {
-    if (tile_city(ptile1)) {
-      return CB_NO_MIN_DIST;
-    }
-  } square_iterate_end;
+  if (cityindex_any_in_range(ptile, citymindist - 1)) {
+    return CB_NO_MIN_DIST;
+  }
 
   return CB_OK;
 }
@@ -1925,12 +1924,11 @@ bool is_unit_near_a_friendly_city(const struct unit *punit)
 bool is_friendly_city_near(const struct player *owner,
                            const struct tile *ptile)
 {
-  square_iterate(ptile, 3, ptile1) {
-    struct city *pcity = tile_city(ptile1);
-    if (pcity && pplayers_allied(owner, city_owner(pcity))) {
+  cityindex_range_iterate(ptile, 3, pcity) {
+    if (pplayers_allied(owner, city_owner(pcity))) {
       return TRUE;
     }
-  } square_iterate_end;
+  } cityindex_range_iterate_end;
 
   return FALSE;
 }
@@ -1942,13 +1940,13 @@ bool is_friendly_city_near(const struct player *owner,
 bool city_exists_within_max_city_map(const struct tile *ptile,
                                      bool may_be_on_center)
 {
-  city_tile_iterate(CITY_MAP_MAX_RADIUS_SQ, ptile, ptile1) {
-    if (may_be_on_center || !same_pos(ptile, ptile1)) {
-      if (tile_city(ptile1)) {
-        return TRUE;
-      }
+  cityindex_range_iterate(ptile, CITY_MAP_MAX_RADIUS, pcity) {
+    if ((may_be_on_center || !same_pos(ptile, city_tile(pcity)))
+        && sq_map_distance(ptile, city_tile(pcity))
+           <= CITY_MAP_MAX_RADIUS_SQ) {
+      return TRUE;
     }
-  } city_tile_iterate_end;
+  } cityindex_range_iterate_end;
 
   return FALSE;
 }
@@ -2180,8 +2178,9 @@ void add_building_output(const struct city *pcity, int *output)
 }
 
 /****************************************************************************
-  This function sets all the values in the pcity->bonus[] array.
-  Called near the beginning of city_refresh_from_main_map().
+  This function sets all the values in the pcity->bonus[] and
+  pcity->happy_bonus[] arrays. Called near the beginning of
+  city_refresh_from_main_map().
 
   It doesn't depend on anything else in the refresh and doesn't change
   as workers are moved around, but does change when buildings are built,
@@ -2192,6 +2191,18 @@ static inline void set_city_bonuses(struct city *pcity)
   output_type_iterate(o) {
     pcity->bonus[o] = get_final_city_output_bonus(pcity, o);
   } output_type_iterate_end;
+
+  pcity->happy_bonus[HAPPY_BONUS_MAKE_CONTENT]
+    = get_city_bonus(pcity, EFT_MAKE_CONTENT);
+  pcity->happy_bonus[HAPPY_BONUS_ENEMY_UNHAPPY_PCT]
+    = game.info.citizen_nationality
+      ? get_city_bonus(pcity, EFT_ENEMY_CITIZEN_UNHAPPY_PCT) : 0;
+  pcity->happy_bonus[HAPPY_BONUS_MAKE_HAPPY]
+    = get_city_bonus(pcity, EFT_MAKE_HAPPY);
+  pcity->happy_bonus[HAPPY_BONUS_NO_UNHAPPY]
+    = get_city_bonus(pcity, EFT_NO_UNHAPPY);
+  pcity->happy_bonus[HAPPY_BONUS_FORCE_CONTENT]
+    = get_city_bonus(pcity, EFT_FORCE_CONTENT);
 }
 
 /****************************************************************************
@@ -2264,6 +2275,26 @@ static void happy_copy(struct city *pcity, enum citizen_feeling i)
   }
 }
 
+/**************************************************************************
+  Move as many citizens from 'from' to 'to' as the budget allows, each move
+  costing 'cost' from the budget. This is the same as moving them one by
+  one while the budget is at least 'cost' and 'from' is not empty.
+**************************************************************************/
+static inline void citizens_convert(citizens *from, citizens *to,
+                                    int *budget, int cost)
+{
+  int num;
+
+  if (*budget < cost) {
+    return;
+  }
+
+  num = (cost > 0 ? MIN(*from, *budget / cost) : *from);
+  *from -= num;
+  *to += num;
+  *budget -= num * cost;
+}
+
 /**************************************************************************
   Create content, unhappy and angry citizens.
 **************************************************************************/
@@ -2314,25 +2345,13 @@ static inline void citizen_luxury_happy(struct city *pcity, int *luxuries)
   citizens *unhappy = &pcity->feel[CITIZEN_UNHAPPY][FEELING_LUXURY];
   citizens *angry = &pcity->feel[CITIZEN_ANGRY][FEELING_LUXURY];
 
-  while (*luxuries >= game.info.happy_cost && *angry > 0) {
-    /* Upgrade angry to unhappy: costs HAPPY_COST each. */
-    (*angry)--;
-    (*unhappy)++;
-    *luxuries -= game.info.happy_cost;
-  }
-  while (*luxuries >= game.info.happy_cost && *content > 0) {
-    /* Upgrade content to happy: costs HAPPY_COST each. */
-    (*content)--;
-    (*happy)++;
-    *luxuries -= game.info.happy_cost;
-  }
-  while (*luxuries >= 2 * game.info.happy_cost && *unhappy > 0) {
-    /* Upgrade unhappy to happy.  Note this is a 2-level upgrade with
-     * double the cost. */
-    (*unhappy)--;
-    (*happy)++;
-    *luxuries -= 2 * game.info.happy_cost;
-  }
+  /* Upgrade angry to unhappy: costs HAPPY_COST each. */
+  citizens_convert(angry, unhappy, luxuries, game.info.happy_cost);
+  /* Upgrade content to happy: costs HAPPY_COST each. */
+  citizens_convert(content, happy, luxuries, game.info.happy_cost);
+  /* Upgrade unhappy to happy.  Note this is a 2-level upgrade with
+   * double the cost. */
+  citizens_convert(unhappy, happy, luxuries, 2 * game.info.happy_cost);
   if (*luxuries >= game.info.happy_cost && *unhappy > 0) {
     /* Upgrade unhappy to content: costs HAPPY_COST each. */
     (*unhappy)--;
@@ -2359,20 +2378,12 @@ static inline void citizen_content_buildings(struct city *pcity)
   citizens *content = &pcity->feel[CITIZEN_CONTENT][FEELING_EFFECT];
   citizens *unhappy = &pcity->feel[CITIZEN_UNHAPPY][FEELING_EFFECT];
   citizens *angry = &pcity->feel[CITIZEN_ANGRY][FEELING_EFFECT];
-  int faces = get_city_bonus(pcity, EFT_MAKE_CONTENT);
+  int faces = pcity->happy_bonus[HAPPY_BONUS_MAKE_CONTENT];
 
   /* make people content (but not happy):
      get rid of angry first, then make unhappy content. */
-  while (faces > 0 && *angry > 0) {
-    (*angry)--;
-    (*unhappy)++;
-    faces--;
-  }
-  while (faces > 0 && *unhappy > 0) {
-    (*unhappy)--;
-    (*content)++;
-    faces--;
-  }
+  citizens_convert(angry, unhappy, &faces, 1);
+  citizens_convert(unhappy, content, &faces, 1);
 }
 
 /**************************************************************************
@@ -2385,7 +2396,7 @@ static inline void citizen_happiness_nationality(struct city *pcity)
   citizens *unhappy = &pcity->feel[CITIZEN_UNHAPPY][FEELING_NATIONALITY];
 
   if (game.info.citizen_nationality) {
-    int pct = get_city_bonus(pcity, EFT_ENEMY_CITIZEN_UNHAPPY_PCT);
+    int pct = pcity->happy_bonus[HAPPY_BONUS_ENEMY_UNHAPPY_PCT];
 
     if (pct > 0) {
       int enemies = 0;
@@ -2402,21 +2413,9 @@ static inline void citizen_happiness_nationality(struct city *pcity)
 
       /* First make content => unhappy, then happy => unhappy,
        * then happy => content. No-one becomes angry. */
-      while (unhappy_inc > 0 && *content > 0) {
-        (*content)--;
-        (*unhappy)++;
-        unhappy_inc--;
-      }
-      while (unhappy_inc > 1 && *happy > 0) {
-        (*happy)--;
-        (*unhappy)++;
-        unhappy_inc -= 2;
-      }
-      while (unhappy_inc > 0 && *happy > 0) {
-        (*happy)--;
-        (*content)++;
-        unhappy_inc--;
-      }
+      citizens_convert(content, unhappy, &unhappy_inc, 1);
+      citizens_convert(happy, unhappy, &unhappy_inc, 2);
+      citizens_convert(happy, content, &unhappy_inc, 1);
     }
   }
 }
@@ -2433,40 +2432,20 @@ static inline void citizen_happy_units(struct city *pcity)
   citizens *content = &pcity->feel[CITIZEN_CONTENT][FEELING_MARTIAL];
   citizens *unhappy = &pcity->feel[CITIZEN_UNHAPPY][FEELING_MARTIAL];
   citizens *angry = &pcity->feel[CITIZEN_ANGRY][FEELING_MARTIAL];
-  citizens  amt = pcity->martial_law;
+  int amt = pcity->martial_law;
 
   /* Pacify discontent citizens through martial law.  First convert
    * angry => unhappy, then unhappy => content. */
-  while (amt > 0 && *angry > 0) {
-    (*angry)--;
-    (*unhappy)++;
-    amt--;
-  }
-  while (amt > 0 && *unhappy > 0) {
-    (*unhappy)--;
-    (*content)++;
-    amt--;
-  }
+  citizens_convert(angry, unhappy, &amt, 1);
+  citizens_convert(unhappy, content, &amt, 1);
 
   /* Now make citizens unhappier because of military units away from home.
    * First make content => unhappy, then happy => unhappy,
    * then happy => content. */
   amt = pcity->unit_happy_upkeep;
-  while (amt > 0 && *content > 0) {
-    (*content)--;
-    (*unhappy)++;
-    amt--;
-  }
-  while (amt > 1 && *happy > 0) {
-    (*happy)--;
-    (*unhappy)++;
-    amt -= 2;
-  }
-  while (amt > 0 && *happy > 0) {
-    (*happy)--;
-    (*content)++;
-    amt--;
-  }
+  citizens_convert(content, unhappy, &amt, 1);
+  citizens_convert(happy, unhappy, &amt, 2);
+  citizens_convert(happy, content, &amt, 1);
   /* Any remaining unhappiness is lost since angry citizens aren't created
    * here. */
   /* FIXME: Why not? - Per */
@@ -2481,42 +2460,26 @@ static inline void citizen_happy_wonders(struct city *pcity)
   citizens *content = &pcity->feel[CITIZEN_CONTENT][FEELING_FINAL];
   citizens *unhappy = &pcity->feel[CITIZEN_UNHAPPY][FEELING_FINAL];
   citizens *angry = &pcity->feel[CITIZEN_ANGRY][FEELING_FINAL];
-  int bonus = get_city_bonus(pcity, EFT_MAKE_HAPPY);
+  int bonus = pcity->happy_bonus[HAPPY_BONUS_MAKE_HAPPY];
 
   /* First create happy citizens from content, then from unhappy
    * citizens; we cannot help angry citizens here. */
-  while (bonus > 0 && *content > 0) {
-    (*content)--;
-    (*happy)++;
-    bonus--;
-  }
-  while (bonus > 1 && *unhappy > 0) {
-    (*unhappy)--;
-    (*happy)++;
-    bonus -= 2;
-  }
+  citizens_convert(content, happy, &bonus, 1);
+  citizens_convert(unhappy, happy, &bonus, 2);
   /* The rest falls through and lets unhappy people become content. */
 
-  if (get_city_bonus(pcity, EFT_NO_UNHAPPY) > 0) {
+  if (pcity->happy_bonus[HAPPY_BONUS_NO_UNHAPPY] > 0) {
     *content += *unhappy + *angry;
     *unhappy = 0;
     *angry = 0;
     return;
   }
 
-  bonus += get_city_bonus(pcity, EFT_FORCE_CONTENT);
+  bonus += pcity->happy_bonus[HAPPY_BONUS_FORCE_CONTENT];
 
   /* get rid of angry first, then make unhappy content */
-  while (bonus > 0 && *angry > 0) {
-    (*angry)--;
-    (*unhappy)++;
-    bonus--;
-  }
-  while (bonus > 0 && *unhappy > 0) {
-    (*unhappy)--;
-    (*content)++;
-    bonus--;
-  }
+  citizens_convert(angry, unhappy, &bonus, 1);
+  citizens_convert(unhappy, content, &bonus, 1);
 }
 
 /**************************************************************************
@@ -2904,8 +2867,8 @@ static inline void city_support(struct city *pcity)
 /**************************************************************************
   Refreshes the internal cached data in the city structure.
 
-  !full_refresh will not update tile_cache[] or bonus[].  These two
-  values do not need to be recalculated for AI CMA testing.
+  !full_refresh will not update tile_cache[], bonus[] or happy_bonus[].
+  These values do not need to be recalculated for AI CMA testing.
 
   'workers_map' is an boolean array which defines the placement of the
   workers within the city map. It uses the tile index and its size is
@@ -3174,31 +3137,27 @@ void city_styles_free(void)
 }
 
 /**************************************************************************
-  Create virtual skeleton for a city.
-  Values are mostly sane defaults.
+  Fill pcity, which belongs to the caller (typically it is on the stack),
+  as a virtual skeleton of a city. Values are mostly sane defaults.
 
-  Always tile_set_owner(ptile, pplayer) sometime after this!
+  Unlike create_city_virtual() nothing is allocated and the AIs are not
+  told about the city: it has no unit lists nor AI data, and it is simply
+  dropped instead of destroyed. This is meant for "what if" evaluations of
+  the outputs of a city, which may then run on any thread.
 **************************************************************************/
-struct city *create_city_virtual(struct player *pplayer,
-                                 struct tile *ptile, const char *name)
+void city_virtual_init(struct city *pcity, struct player *pplayer,
+                       struct tile *ptile, const char *name)
 {
   int i;
 
-  /* Make sure that contents of city structure are correctly initialized,
-   * if you ever allocate it by some other mean than fc_calloc() */
-  struct city *pcity = fc_calloc(1, sizeof(*pcity));
+  memset(pcity, 0, sizeof(*pcity));
 
-  fc_assert_ret_val(NULL != name, NULL);        /* No unnamed cities! */
   sz_strlcpy(pcity->name, name);
 
   pcity->tile = ptile;
-  fc_assert_ret_val(NULL != pplayer, NULL);     /* No unowned cities! */
   pcity->owner = pplayer;
   pcity->original = pplayer;
 
-  /* City structure was allocated with fc_calloc(), so contents are initially
-   * zero. There is no need to initialize it a second time. */
-
   /* Now set some usefull default values. */
   city_size_set(pcity, 1);
   city_population_set(pcity, 100);
@@ -3226,13 +3185,33 @@ struct city *create_city_virtual(struct player *pplayer,
   /* Set up the worklist */
   worklist_init(&pcity->worklist);
 
-  pcity->units_supported = unit_list_new();
-
   if (is_server()) {
     pcity->server.mgr_score_calc_turn = -1; /* -1 = never */
 
     worker_task_init(&pcity->server.task_req);
+  }
+}
 
+/**************************************************************************
+  Create virtual skeleton for a city.
+  Values are mostly sane defaults.
+
+  Always tile_set_owner(ptile, pplayer) sometime after this!
+**************************************************************************/
+struct city *create_city_virtual(struct player *pplayer,
+                                 struct tile *ptile, const char *name)
+{
+  struct city *pcity;
+
+  fc_assert_ret_val(NULL != name, NULL);        /* No unnamed cities! */
+  fc_assert_ret_val(NULL != pplayer, NULL);     /* No unowned cities! */
+
+  pcity = fc_malloc(sizeof(*pcity));
+  city_virtual_init(pcity, pplayer, ptile, name);
+
+  pcity->units_supported = unit_list_new();
+
+  if (is_server()) {
     CALL_FUNC_EACH_AI(city_alloc, pcity);
     CALL_PLR_AI_FUNC(city_got, pplayer, pplayer, pcity);
   } else {
@@ -3240,8 +3219,8 @@ struct city *create_city_virtual(struct player *pplayer,
         unit_list_new_full(unit_virtual_destroy);
     pcity->client.info_units_present =
         unit_list_new_full(unit_virtual_destroy);
-    /* collecting_info_units_supported set by fc_calloc().
-     * collecting_info_units_present set by fc_calloc(). */
+    /* collecting_info_units_supported set by city_virtual_init().
+     * collecting_info_units_present set by city_virtual_init(). */
   }
 
   return pcity;
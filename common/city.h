@@ -74,6 +74,8 @@ BV_DEFINE(bv_city_options, CITYO_LAST); /* Used in the network protocol. */
 
 /* Maximum diameter of the workable city area. */
 #define CITY_MAP_MAX_SIZE (CITY_MAP_MAX_RADIUS * 2 + 1)
+/* Upper bound of the number of tiles in the workable city area. */
+#define CITY_MAP_MAX_TILES (CITY_MAP_MAX_SIZE * CITY_MAP_MAX_SIZE)
 
 #define INCITE_IMPOSSIBLE_COST (1000 * 1000 * 1000)
 
@@ -266,6 +268,17 @@ enum citizen_feeling {
   FEELING_LAST
 };
 
+/* Happiness effects of a city, cached in pcity->happy_bonus[]. Not part
+ * of network protocol. */
+enum city_happy_bonus {
+  HAPPY_BONUS_MAKE_CONTENT,
+  HAPPY_BONUS_ENEMY_UNHAPPY_PCT,
+  HAPPY_BONUS_MAKE_HAPPY,
+  HAPPY_BONUS_NO_UNHAPPY,
+  HAPPY_BONUS_FORCE_CONTENT,
+  HAPPY_BONUS_LAST
+};
+
 /* Ways city output can be lost. Not currently part of network protocol. */
 enum output_loss {
   OLOSS_WASTE,  /* regular corruption or waste */
@@ -339,6 +352,7 @@ struct city {
 
   /* Cached values for CPU savings. */
   int bonus[O_LAST];
+  int happy_bonus[HAPPY_BONUS_LAST];
 
   /* the physics */
   int food_stock;
@@ -405,6 +419,12 @@ struct city {
       /* the city map is synced with the client. */
       bool synced;
 
+      /* Set while the city is in the queue of city infos to send once
+       * sending cities is no longer suppressed; info_broadcast if the
+       * info goes to everyone seeing the city, not only the owner. */
+      bool info_queued;
+      bool info_broadcast;
+
       bool debug;                   /* not saved */
 
       struct adv_city *adv;
@@ -691,6 +711,8 @@ int get_final_city_output_bonus(const struct city *pcity, Output_type_id otype);
 bool city_built_last_turn(const struct city *pcity);
 
 /* city creation / destruction */
+void city_virtual_init(struct city *pcity, struct player *pplayer,
+                       struct tile *ptile, const char *name);
 struct city *create_city_virtual(struct player *pplayer,
 				 struct tile *ptile, const char *name);
 void destroy_city_virtual(struct city *pcity);
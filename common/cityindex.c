@@ -0,0 +1,401 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <fc_config.h>
+#endif
+
+/* utility */
+#include "log.h"
+#include "mem.h"
+#include "shared.h"
+
+/* common */
+#include "city.h"
+#include "map.h"
+#include "player.h"
+
+#include "cityindex.h"
+
+/* The cells are squares of native positions. */
+#define CITYINDEX_CELL_SIZE 8
+
+static struct {
+  int xsize, ysize;             /* Native size of the map */
+  int cell_xsize, cell_ysize;   /* Number of cells on each axis */
+  struct city_list **cells;
+  int num_cities;
+} cindex = { 0, 0, 0, 0, NULL, 0 };
+
+struct cityindex_range_iter {
+  struct iterator vtable;
+  const struct tile *center;
+  int dist;
+  int col_first, num_cols;
+  int row_first, num_rows;
+  int col, row;                 /* Current cell, counted from the first */
+  const struct city_list_link *link;
+};
+
+#define CITYINDEX_RANGE_ITER(p) ((struct cityindex_range_iter *) (p))
+
+/**************************************************************************
+  Allocate the cells for the current map.
+**************************************************************************/
+static void cityindex_alloc(void)
+{
+  int i;
+
+  cindex.xsize = map.xsize;
+  cindex.ysize = map.ysize;
+  cindex.cell_xsize = (map.xsize + CITYINDEX_CELL_SIZE - 1)
+                      / CITYINDEX_CELL_SIZE;
+  cindex.cell_ysize = (map.ysize + CITYINDEX_CELL_SIZE - 1)
+                      / CITYINDEX_CELL_SIZE;
+  cindex.cells = fc_malloc(cindex.cell_xsize * cindex.cell_ysize
+                           * sizeof(*cindex.cells));
+  for (i = 0; i < cindex.cell_xsize * cindex.cell_ysize; i++) {
+    cindex.cells[i] = city_list_new();
+  }
+  cindex.num_cities = 0;
+}
+
+/**************************************************************************
+  Free the city index. The cities themselves are not touched.
+**************************************************************************/
+void cityindex_free(void)
+{
+  int i;
+
+  if (cindex.cells == NULL) {
+    return;
+  }
+
+  for (i = 0; i < cindex.cell_xsize * cindex.cell_ysize; i++) {
+    city_list_destroy(cindex.cells[i]);
+  }
+  free(cindex.cells);
+  cindex.cells = NULL;
+  cindex.num_cities = 0;
+}
+
+/**************************************************************************
+  Return the list of the cell holding the tile.
+**************************************************************************/
+static struct city_list *cityindex_cell(const struct tile *ptile)
+{
+  int nat_x, nat_y;
+
+  index_to_native_pos(&nat_x, &nat_y, tile_index(ptile));
+
+  return cindex.cells[(nat_y / CITYINDEX_CELL_SIZE) * cindex.cell_xsize
+                      + nat_x / CITYINDEX_CELL_SIZE];
+}
+
+/**************************************************************************
+  Add the city to the index. Cities without a tile are ignored.
+**************************************************************************/
+void cityindex_add(struct city *pcity)
+{
+  const struct tile *ptile = city_tile(pcity);
+
+  if (ptile == NULL) {
+    return;
+  }
+
+  if (cindex.cells != NULL
+      && (cindex.xsize != map.xsize || cindex.ysize != map.ysize)) {
+    /* The map has changed since the index was made. */
+    fc_assert(cindex.num_cities == 0);
+    cityindex_free();
+  }
+  if (cindex.cells == NULL) {
+    cityindex_alloc();
+  }
+
+  city_list_append(cityindex_cell(ptile), pcity);
+  cindex.num_cities++;
+}
+
+/**************************************************************************
+  Remove the city from the index.
+**************************************************************************/
+void cityindex_remove(struct city *pcity)
+{
+  const struct tile *ptile = city_tile(pcity);
+
+  if (ptile == NULL || cindex.cells == NULL) {
+    return;
+  }
+
+  if (city_list_remove(cityindex_cell(ptile), pcity)) {
+    cindex.num_cities--;
+  }
+}
+
+/**************************************************************************
+  Find the cells covering the native coordinates 'from' to 'to' on an
+  axis of the given size. Sets the first cell and returns the number of
+  cells; the cells follow each other, wrapping around if 'wrap' is set.
+**************************************************************************/
+static int cityindex_span(int from, int to, int size, int num_cells,
+                          bool wrap, int *first)
+{
+  int pos, len, count;
+
+  if (!wrap) {
+    from = MAX(from, 0);
+    to = MIN(to, size - 1);
+    if (from > to) {
+      *first = 0;
+      return 0;
+    }
+    *first = from / CITYINDEX_CELL_SIZE;
+    return to / CITYINDEX_CELL_SIZE - *first + 1;
+  }
+
+  if (to - from + 1 >= size) {
+    *first = 0;
+    return num_cells;
+  }
+
+  /* The last cell may be smaller than the others, so walk the span. */
+  len = to - from + 1;
+  pos = FC_WRAP(from, size);
+  *first = pos / CITYINDEX_CELL_SIZE;
+  count = 0;
+  while (len > 0 && count < num_cells) {
+    int step = MIN(CITYINDEX_CELL_SIZE - pos % CITYINDEX_CELL_SIZE,
+                   size - pos);
+
+    len -= step;
+    pos += step;
+    if (pos >= size) {
+      pos = 0;
+    }
+    count++;
+  }
+
+  return count;
+}
+
+/**************************************************************************
+  Return the list of the current cell of the iterator.
+**************************************************************************/
+static struct city_list *
+cityindex_range_iter_cell(const struct cityindex_range_iter *it)
+{
+  int col = (it->col_first + it->col) % cindex.cell_xsize;
+  int row = (it->row_first + it->row) % cindex.cell_ysize;
+
+  return cindex.cells[row * cindex.cell_xsize + col];
+}
+
+/**************************************************************************
+  Move the iterator on to the first city within the distance, starting
+  with the current link.
+**************************************************************************/
+static void cityindex_range_iter_find(struct cityindex_range_iter *it)
+{
+  while (TRUE) {
+    for (; it->link != NULL; it->link = city_list_link_next(it->link)) {
+      if (real_map_distance(it->center,
+                            city_tile(city_list_link_data(it->link)))
+          <= it->dist) {
+        return;
+      }
+    }
+
+    if (++it->col >= it->num_cols) {
+      it->col = 0;
+      if (++it->row >= it->num_rows) {
+        return;
+      }
+    }
+    it->link = city_list_head(cityindex_range_iter_cell(it));
+  }
+}
+
+/**************************************************************************
+  Implementation of iterator 'sizeof' function.
+**************************************************************************/
+size_t cityindex_range_iter_sizeof(void)
+{
+  return sizeof(struct cityindex_range_iter);
+}
+
+/**************************************************************************
+  Implementation of iterator 'next' function.
+**************************************************************************/
+static void cityindex_range_iter_next(struct iterator *iter)
+{
+  struct cityindex_range_iter *it = CITYINDEX_RANGE_ITER(iter);
+
+  it->link = city_list_link_next(it->link);
+  cityindex_range_iter_find(it);
+}
+
+/**************************************************************************
+  Implementation of iterator 'get' function.
+**************************************************************************/
+static void *cityindex_range_iter_get(const struct iterator *iter)
+{
+  return city_list_link_data(CITYINDEX_RANGE_ITER(iter)->link);
+}
+
+/**************************************************************************
+  Implementation of iterator 'valid' function.
+**************************************************************************/
+static bool cityindex_range_iter_valid(const struct iterator *iter)
+{
+  return CITYINDEX_RANGE_ITER(iter)->link != NULL;
+}
+
+/**************************************************************************
+  Initialize an iterator over the cities within the real distance 'dist'
+  of 'ptile'.
+**************************************************************************/
+struct iterator *cityindex_range_iter_init(struct cityindex_range_iter *it,
+                                           const struct tile *ptile,
+                                           int dist)
+{
+  int nat_x, nat_y, dx, dy;
+
+  if (cindex.cells == NULL || ptile == NULL || dist < 0) {
+    return invalid_iter_init(ITERATOR(it));
+  }
+
+  it->vtable.next = cityindex_range_iter_next;
+  it->vtable.get = cityindex_range_iter_get;
+  it->vtable.valid = cityindex_range_iter_valid;
+  it->center = ptile;
+  it->dist = dist;
+
+  /* The native positions covering the square around the tile. On an
+   * isometric map a step in map coordinates moves by up to two native
+   * rows, and by a half native column that may round either way. */
+  if (MAP_IS_ISOMETRIC) {
+    dx = dist + 1;
+    dy = 2 * dist;
+  } else {
+    dx = dist;
+    dy = dist;
+  }
+  index_to_native_pos(&nat_x, &nat_y, tile_index(ptile));
+  it->num_cols = cityindex_span(nat_x - dx, nat_x + dx, cindex.xsize,
+                                cindex.cell_xsize,
+                                current_topo_has_flag(TF_WRAPX),
+                                &it->col_first);
+  it->num_rows = cityindex_span(nat_y - dy, nat_y + dy, cindex.ysize,
+                                cindex.cell_ysize,
+                                current_topo_has_flag(TF_WRAPY),
+                                &it->row_first);
+  it->col = 0;
+  it->row = 0;
+
+  if (it->num_cols == 0 || it->num_rows == 0) {
+    it->link = NULL;
+    return ITERATOR(it);
+  }
+
+  it->link = city_list_head(cityindex_range_iter_cell(it));
+  cityindex_range_iter_find(it);
+
+  return ITERATOR(it);
+}
+
+/**************************************************************************
+  Return TRUE iff there is a city within the real distance 'dist' of
+  'ptile'.
+**************************************************************************/
+bool cityindex_any_in_range(const struct tile *ptile, int dist)
+{
+  struct cityindex_range_iter it;
+
+  return iterator_valid(cityindex_range_iter_init(&it, ptile, dist));
+}
+
+/**************************************************************************
+  Return TRUE if 'pcity1' comes before 'pcity2' when iterating over the
+  players and their lists of cities.
+**************************************************************************/
+static bool cityindex_city_before(const struct city *pcity1,
+                                  const struct city *pcity2)
+{
+  const struct player *pplayer1 = city_owner(pcity1);
+  const struct player *pplayer2 = city_owner(pcity2);
+
+  if (pplayer1 != pplayer2) {
+    return player_index(pplayer1) < player_index(pplayer2);
+  }
+
+  city_list_iterate(pplayer1->cities, pcity) {
+    if (pcity == pcity1) {
+      return TRUE;
+    }
+    if (pcity == pcity2) {
+      return FALSE;
+    }
+  } city_list_iterate_end;
+
+  return pcity1->id < pcity2->id;
+}
+
+/**************************************************************************
+  Return the city closest to 'ptile' (by real distance) for which 'filter'
+  returns TRUE, or NULL if there is none. A NULL 'filter' accepts every
+  city. Among the cities at the same distance, the first one in the order
+  of the players and of their lists of cities is returned, as a search
+  over all the cities would do.
+
+  The search looks in squares of growing size, until the best city found
+  lies inside the square.
+**************************************************************************/
+struct city *cityindex_closest(const struct tile *ptile,
+                               bool (*filter) (const struct city *pcity,
+                                               const void *data),
+                               const void *data)
+{
+  struct city *best_city = NULL;
+  int best_dist = -1;
+  int max_dist = map.xsize + map.ysize;
+  int radius;
+
+  if (cindex.cells == NULL || cindex.num_cities == 0) {
+    return NULL;
+  }
+
+  for (radius = CITYINDEX_CELL_SIZE; ; radius *= 2) {
+    cityindex_range_iterate(ptile, radius, pcity) {
+      int dist;
+
+      if (filter != NULL && !filter(pcity, data)) {
+        continue;
+      }
+
+      dist = real_map_distance(ptile, city_tile(pcity));
+      if (best_city == NULL || dist < best_dist
+          || (dist == best_dist && pcity != best_city
+              && cityindex_city_before(pcity, best_city))) {
+        best_city = pcity;
+        best_dist = dist;
+      }
+    } cityindex_range_iterate_end;
+
+    if ((best_city != NULL && best_dist <= radius) || radius >= max_dist) {
+      break;
+    }
+  }
+
+  return best_city;
+}
@@ -0,0 +1,65 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+#ifndef FC__CITYINDEX_H
+#define FC__CITYINDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* utility */
+#include "iterator.h"
+
+/* common */
+#include "fc_types.h"
+
+/*
+ * The city index buckets the cities by their position on the map, so
+ * that the cities near a tile are found without looking at every tile
+ * around it, nor at every city of the game.
+ *
+ * The cities are added and removed together with their registration in
+ * the idex; a city which gets its tile later (the invisible cities of the
+ * client) must be added by hand with cityindex_add().
+ */
+
+void cityindex_add(struct city *pcity);
+void cityindex_remove(struct city *pcity);
+void cityindex_free(void);
+
+bool cityindex_any_in_range(const struct tile *ptile, int dist);
+struct city *cityindex_closest(const struct tile *ptile,
+                               bool (*filter) (const struct city *pcity,
+                                               const void *data),
+                               const void *data);
+
+struct cityindex_range_iter;
+size_t cityindex_range_iter_sizeof(void);
+struct iterator *cityindex_range_iter_init(struct cityindex_range_iter *it,
+                                           const struct tile *ptile,
+                                           int dist);
+
+/* Iterate over the cities within the real distance 'dist' of 'ptile',
+ * that is the cities on the tiles square_iterate() would give. The
+ * order of the cities is unspecified. */
+#define cityindex_range_iterate(ptile, dist, pcity)                         \
+  generic_iterate(struct cityindex_range_iter, struct city *, pcity,        \
+                  cityindex_range_iter_sizeof, cityindex_range_iter_init,   \
+                  ptile, dist)
+#define cityindex_range_iterate_end generic_iterate_end
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FC__CITYINDEX_H */
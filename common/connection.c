@@ -528,6 +528,7 @@ void free_compression_queue(struct connection *pc)
 {
 #ifdef USE_COMPRESSION
   byte_vector_free(&pc->compression.queue);
+  byte_vector_free(&pc->compression.out);
 #endif
 }
 
@@ -598,9 +599,12 @@ void connection_common_init(struct connection *pconn)
   pconn->statistics.bytes_send = 0;
 
   init_packet_hashs(pconn);
+  pconn->recording = NULL;
+  pconn->flush_pending = NULL;
 
 #ifdef USE_COMPRESSION
   byte_vector_init(&pconn->compression.queue);
+  byte_vector_init(&pconn->compression.out);
   pconn->compression.frozen_level = 0;
 #endif
 }
@@ -42,6 +42,8 @@ extern "C" {
 #include "fc_types.h"
 
 struct genhash;
+struct packet_stream;
+struct tile_info_block;
 struct timer_list;
 struct conn_pattern_list;
 
@@ -91,6 +93,8 @@ enum auth_status {
   AS_FAILED,
   AS_REQUESTING_NEW_PASS,
   AS_REQUESTING_OLD_PASS,
+  AS_LOADING_USER,              /* waiting on the database */
+  AS_SAVING_USER,               /* waiting on the database */
   AS_ESTABLISHED
 };
 
@@ -228,6 +232,12 @@ struct connection {
         struct player *playing;
         bool observer;
       } delegation;
+
+      /* The tile info block being filled, and the tiles whose last info
+       * went in a block instead of a PACKET_TILE_INFO. See maphand.c. */
+      struct tile_info_block *tile_block;
+      struct dbv tiles_in_blocks;
+      bool tile_blocks;         /* has_capability("tile_blocks") */
     } server;
   };
 
@@ -247,17 +257,30 @@ struct connection {
   void (*outgoing_packet_notify) (struct connection * pc,
 				  int packet_type, int size,
 				  int request_id);
+
+  /*
+   * If not NULL, called before anything is sent to the connection, the
+   * packets of packet_stream_send() included, so that data held back for
+   * the connection goes first. It must be set to NULL before that data is
+   * sent.
+   */
+  void (*flush_pending) (struct connection * pc);
   struct {
     struct genhash **sent;
     struct genhash **received;
     int *variant;
   } phs;
 
+  /* If not NULL, the packets sent to this connection are recorded in
+   * this stream too. See packet_stream_record_start(). */
+  struct packet_stream *recording;
+
 #ifdef USE_COMPRESSION
   struct {
     int frozen_level;
 
     struct byte_vector queue;
+    struct byte_vector out;     /* Kept between the flushes of 'queue'. */
   } compression;
 #endif
   struct {
@@ -287,6 +287,7 @@ static void game_defaults(void)
     /* game.num_impr_types = 0 here */
     game.info.great_wonder_owners[i] = WONDER_NOT_OWNED;
   }
+  requirement_cache_invalidate();
   game.info.globalwarming    = 0;
   game.info.global_warming   = GAME_DEFAULT_GLOBAL_WARMING;
   game.info.gold             = GAME_DEFAULT_GOLD;
@@ -395,6 +396,7 @@ static void game_defaults(void)
     game.server.save_compress_type = GAME_DEFAULT_COMPRESS_TYPE;
     sz_strlcpy(game.server.save_name, GAME_DEFAULT_SAVE_NAME);
     game.server.save_nturns       = GAME_DEFAULT_SAVETURNS;
+    game.server.save_deltas       = GAME_DEFAULT_SAVEDELTAS;
     game.server.save_options.save_known = TRUE;
     game.server.save_options.save_private_map = TRUE;
     game.server.save_options.save_random = TRUE;
@@ -417,6 +419,8 @@ static void game_defaults(void)
     game.server.timeoutintinc     = GAME_DEFAULT_TIMEOUTINTINC;
     game.server.turnblock         = GAME_DEFAULT_TURNBLOCK;
     game.server.unitwaittime      = GAME_DEFAULT_UNITWAITTIME;
+    game.server.worker_threads    = GAME_DEFAULT_WORKER_THREADS;
+    game.server.mapimg_background = GAME_DEFAULT_MAPIMG_BACKGROUND;
     game.server.plr_colors        = NULL;
   } else {
     /* Client side takes care of itself in client_main() */
@@ -574,6 +578,7 @@ void initialize_globals(void)
       } city_built_iterate_end;
     } city_list_iterate_end;
   } players_iterate_end;
+  requirement_cache_invalidate();
 }
 
 /***************************************************************
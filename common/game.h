@@ -156,6 +156,7 @@ struct civ_game {
       int save_compress_level;
       enum fz_method save_compress_type;
       int save_nturns;
+      int save_deltas;
       unsigned autosaves; /* FIXME: char would be enough, but current settings.c code wants to
                              write sizeof(unsigned) bytes */
       bool savepalace;
@@ -173,6 +174,8 @@ struct civ_game {
       int unitwaittime;   /* minimal time between two movements of a unit */
       int upgrade_veteran_loss;
       bool vision_reveal_tiles;
+      int worker_threads;
+      bool mapimg_background;
 
       bool debug[DEBUG_LAST];
       int timeoutint;     /* increase timeout every N turns... */
@@ -232,6 +235,7 @@ struct civ_game {
 
       struct {
         fc_mutex city_list;
+        fc_mutex infrastructure_cache;
       } mutexes;
 
       int first_timeout;
@@ -241,6 +245,9 @@ struct civ_game {
   struct {
     /* Function to be called in game_remove_unit when a unit is deleted. */
     void (*unit_deallocate)(int unit_id);
+    /* Function to be called when the terrain, the extras or the city of a
+     * tile change, and with NULL when the map is freed. */
+    void (*tile_changed)(const struct tile *ptile);
   } callbacks;
 };
 
@@ -550,6 +557,16 @@ extern struct civ_game game;
 #define GAME_MIN_SAVETURNS           1
 #define GAME_MAX_SAVETURNS           200
 
+#define GAME_DEFAULT_SAVEDELTAS      0
+#define GAME_MIN_SAVEDELTAS          0
+#define GAME_MAX_SAVEDELTAS          100
+
+#define GAME_DEFAULT_WORKER_THREADS  1
+#define GAME_MIN_WORKER_THREADS      1
+#define GAME_MAX_WORKER_THREADS      64
+
+#define GAME_DEFAULT_MAPIMG_BACKGROUND FALSE
+
 #define GAME_DEFAULT_AUTOSAVES       (1 << AS_TURN | 1 << AS_GAME_OVER | 1 << AS_QUITIDLE | 1 << AS_INTERRUPT)
 
 #define GAME_DEFAULT_SKILL_LEVEL 3      /* easy */
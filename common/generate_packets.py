@@ -1485,6 +1485,25 @@ def get_packet_has_game_info_flag(packets):
   }
 }
 
+'''
+    return intro+body+extro
+
+# Returns a code fragment which is the implementation of the
+# packet_struct_size() function.
+def get_packet_struct_size(packets):
+    intro='''size_t packet_struct_size(enum packet_type type)
+{
+  switch (type) {
+
+'''
+    body=""
+    for p in packets:
+        body=body+'  case %(type)s:\n    return sizeof(struct %(name)s);\n\n'%p.__dict__
+    extro='''  default:
+    return 0;
+  }
+}
+
 '''
     return intro+body+extro
 
@@ -1669,6 +1688,7 @@ static int stats_total_sent;
     output_c.write(get_get_packet_helper(packets))
     output_c.write(get_packet_name(packets))
     output_c.write(get_packet_has_game_info_flag(packets))
+    output_c.write(get_packet_struct_size(packets))
 
     # write hash, cmp, send, receive
     for p in packets:
@@ -34,6 +34,7 @@
 
 /* common */
 #include "city.h"
+#include "cityindex.h"
 #include "unit.h"
 
 #include "idex.h"
@@ -82,11 +83,13 @@ void idex_free(void)
 
   unit_hash_destroy(idex_unit_hash);
   idex_unit_hash = NULL;
+
+  cityindex_free();
 }
 
 /**************************************************************************
-   Register a city into idex, with current pcity->id.
-   Call this when pcity created.
+   Register a city into idex, with current pcity->id, and into the city
+   index. Call this when pcity created.
 ***************************************************************************/
 void idex_register_city(struct city *pcity)
 {
@@ -97,6 +100,7 @@ void idex_register_city(struct city *pcity)
                     "IDEX: city collision: new %d %p %s, old %d %p %s",
                     pcity->id, (void *) pcity, city_name(pcity),
                     old->id, (void *) old, city_name(old));
+  cityindex_add(pcity);
 }
 
 /**************************************************************************
@@ -115,13 +119,14 @@ void idex_register_unit(struct unit *punit)
 }
 
 /**************************************************************************
-   Remove a city from idex, with current pcity->id.
-   Call this when pcity deleted.
+   Remove a city from idex, with current pcity->id, and from the city
+   index. Call this when pcity deleted.
 ***************************************************************************/
 void idex_unregister_city(struct city *pcity)
 {
   struct city *old;
 
+  cityindex_remove(pcity);
   city_hash_remove_full(idex_city_hash, pcity->id, NULL, &old);
   fc_assert_ret_msg(NULL != old,
                     "IDEX: city unreg missing: %d %p %s",
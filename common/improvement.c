@@ -542,6 +542,7 @@ void wonder_built(const struct city *pcity, const struct impr_type *pimprove)
   if (is_great_wonder(pimprove)) {
     game.info.great_wonder_owners[index] = player_number(pplayer);
   }
+  requirement_cache_invalidate();
 }
 
 /**************************************************************************
@@ -560,6 +561,7 @@ void wonder_destroyed(const struct city *pcity,
   pplayer = city_owner(pcity);
   fc_assert_ret(pplayer->wonders[index] == pcity->id);
   pplayer->wonders[index] = WONDER_LOST;
+  requirement_cache_invalidate();
 
   if (is_great_wonder(pimprove)) {
     fc_assert_ret(game.info.great_wonder_owners[index]
@@ -154,13 +154,14 @@ bv_roads get_tile_pillageable_road_set(const struct tile *ptile, int *pcount)
   road_type_iterate(proad) {
     if (tile_has_road(ptile, proad)) {
       if (proad->pillageable) {
-        struct tile *roadless = tile_virtual_new(ptile);
+        struct tile roadless;
         bool dependency = FALSE;
 
-        tile_remove_road(roadless, proad);
+        tile_virtual_init(&roadless, ptile);
+        tile_remove_road(&roadless, proad);
         road_type_iterate(pdependant) {
           if (tile_has_road(ptile, pdependant)) {
-            if (!are_reqs_active(NULL, NULL, NULL, roadless,
+            if (!are_reqs_active(NULL, NULL, NULL, &roadless,
                                  NULL, NULL, NULL,
                                  &pdependant->reqs, RPT_POSSIBLE)) {
               dependency = TRUE;
@@ -169,8 +170,6 @@ bv_roads get_tile_pillageable_road_set(const struct tile *ptile, int *pcount)
           }
         } road_type_iterate_end;
 
-        tile_virtual_destroy(roadless);
-
         if (!dependency) {
           BV_SET(rspresent, road_index(proad));
           count++;
@@ -548,6 +547,10 @@ void map_allocate(void)
 ***************************************************************/
 void map_free(void)
 {
+  if (game.callbacks.tile_changed) {
+    (game.callbacks.tile_changed)(NULL);
+  }
+
   if (map.tiles) {
     /* it is possible that map_init was called but not map_allocate */
 
@@ -872,6 +875,17 @@ static bool restrict_infra(const struct player *pplayer, const struct tile *t1,
   return FALSE;
 }
 
+/****************************************************************************
+  Tell game.callbacks.tile_changed that the tile changed. Must be called
+  when the terrain, the roads, the bases or the city of the tile change.
+****************************************************************************/
+void map_tile_changed(const struct tile *ptile)
+{
+  if (game.callbacks.tile_changed) {
+    (game.callbacks.tile_changed)(ptile);
+  }
+}
+
 /***************************************************************
   Are two tiles adjacent to each other.
 ***************************************************************/
@@ -385,6 +385,8 @@ static inline int map_move_cost(const struct player *pplayer,
   return tile_move_cost_ptrs(NULL, pclass, pplayer, src_tile, dst_tile);
 }
 
+void map_tile_changed(const struct tile *ptile);
+
 bool is_safe_ocean(const struct tile *ptile);
 bv_special get_tile_infrastructure_set(const struct tile *ptile,
 					  int *count);
@@ -21,14 +21,20 @@
   #include <wand/MagickWand.h>
 #endif /* HAVE_MAPIMG_MAGICKWAND */
 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif /* HAVE_LIBZ */
+
 /* utility */
 #include "astring.h"
 #include "bitvector.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "shared.h"
 #include "string_vector.h"
+#include "support.h"
 #include "timing.h"
 
 /* common */
@@ -382,9 +388,37 @@ struct img {
     int x;
     int y;
   } imgsize; /* image size */
+  struct {
+    int min;
+    int max;
+  } rows; /* image rows [min, max) this image may draw to */
   const struct rgbcolor **map;
 };
 
+/* Don't split images with less rows than this per thread. */
+#define IMG_BAND_MIN_ROWS 64
+
+/* An image converted to RGB values, which can be written by the built-in
+ * ppm and png writers without looking at the game state any more. */
+struct img_rgb {
+  char filename[MAX_LEN_PATH];
+  enum imageformat format;
+  struct strvec *comments; /* image comments, one per line */
+  int xsize, ysize; /* image size, without zoom */
+  int zoom;
+  unsigned char *data; /* xsize * ysize RGB triplets */
+  bool saved; /* set by img_rgb_save() */
+};
+
+#define SPECLIST_TAG img_rgb
+#define SPECLIST_TYPE struct img_rgb
+#include "speclist.h"
+
+#define img_rgb_list_iterate(img_rgb_list, prgb) \
+  TYPED_LIST_ITERATE(struct img_rgb, img_rgb_list, prgb)
+#define img_rgb_list_iterate_end \
+  LIST_ITERATE_END
+
 static struct img *img_new(struct mapdef *mapdef, int topo, int xsize, int ysize);
 static void img_destroy(struct img *pimg);
 static inline void img_set_pixel(struct img *pimg, const int index,
@@ -396,9 +430,14 @@ static void img_plot(struct img *pimg, int x, int y,
                      const struct rgbcolor *pcolor, const bv_pixel pixel);
 static void img_plot_tile(struct img *pimg, const struct tile *ptile,
                           const struct rgbcolor *pcolor, const bv_pixel pixel);
+static void img_fullname(const char *mapimgfile, const char *path,
+                         char *fullname, size_t fullname_len);
 static bool img_save(const struct img *pimg, const char *mapimgfile,
                      const char *path);
-static bool img_save_ppm(const struct img *pimg, const char *mapimgfile);
+static bool img_save_builtin(const struct img *pimg, const char *mapimgfile);
+static bool img_save_or_queue(const struct img *pimg, const char *mapimgfile,
+                              const char *path,
+                              struct img_rgb_list *images);
 #ifdef HAVE_MAPIMG_MAGICKWAND
 static bool img_save_magickwand(const struct img *pimg,
                                 const char *mapimgfile);
@@ -406,6 +445,19 @@ static bool img_save_magickwand(const struct img *pimg,
 static bool img_filename(const char *mapimgfile, enum imageformat format,
                          char *filename, size_t filename_len);
 static void img_createmap(struct img *pimg);
+static void img_createmap_rows(struct img *pimg);
+
+static struct img_rgb *img_rgb_new(const struct img *pimg,
+                                   const char *filename);
+static void img_rgb_destroy(struct img_rgb *prgb);
+static bool img_rgb_save(struct img_rgb *prgb);
+static bool img_rgb_save_ppm(const struct img_rgb *prgb);
+#ifdef HAVE_LIBZ
+static bool img_rgb_save_png(const struct img_rgb *prgb);
+#endif /* HAVE_LIBZ */
+
+static void img_writer_start(struct img_rgb_list *images);
+static void img_writer_wait(void);
 
 /* == image toolkits == */
 typedef bool (*img_save_func)(const struct img *pimg,
@@ -422,10 +474,17 @@ struct toolkit {
 #define GEN_TOOLKIT(_tool, _format_default, _formats, _save_func, _help)    \
   {_tool, _format_default, _formats, _save_func, _help},
 
+/* Formats written by the built-in writer of the 'ppm' toolkit. */
+#ifdef HAVE_LIBZ
+#define IMG_BUILTIN_FORMATS (IMGFORMAT_PPM + IMGFORMAT_PNG)
+#else
+#define IMG_BUILTIN_FORMATS IMGFORMAT_PPM
+#endif /* HAVE_LIBZ */
+
 static struct toolkit img_toolkits[] = {
-  GEN_TOOLKIT(IMGTOOL_PPM, IMGFORMAT_PPM, IMGFORMAT_PPM,
-              img_save_ppm,
-              N_("Standard ppm files"))
+  GEN_TOOLKIT(IMGTOOL_PPM, IMGFORMAT_PPM, IMG_BUILTIN_FORMATS,
+              img_save_builtin,
+              N_("Built-in writer for ppm and png files"))
 #ifdef HAVE_MAPIMG_MAGICKWAND
   GEN_TOOLKIT(IMGTOOL_MAGICKWAND, IMGFORMAT_GIF,
               IMGFORMAT_GIF + IMGFORMAT_PNG + IMGFORMAT_PPM + IMGFORMAT_JPG,
@@ -485,6 +544,15 @@ static struct {
   mapimg_tile_player_func mapimg_tile_unit;
   mapimg_plrcolor_count_func mapimg_plrcolor_count;
   mapimg_plrcolor_get_func mapimg_plrcolor_get;
+
+  int num_threads; /* threads used to draw an image */
+
+  /* Thread writing images created by mapimg_create_background(). */
+  struct {
+    fc_thread thread;
+    bool running;
+    struct img_rgb_list *images;
+  } writer;
 } mapimg = { .init = FALSE };
 
 /*
@@ -527,6 +595,10 @@ void mapimg_init(mapimg_tile_known_func mapimg_tile_known,
   fc_assert_ret(mapimg_plrcolor_get != NULL);
   mapimg.mapimg_plrcolor_get = mapimg_plrcolor_get;
 
+  mapimg.num_threads = 1;
+  mapimg.writer.running = FALSE;
+  mapimg.writer.images = NULL;
+
   mapimg.init = TRUE;
 }
 
@@ -556,6 +628,7 @@ void mapimg_free(void)
     return;
   }
 
+  img_writer_wait();
   mapimg_reset();
   mapdef_list_destroy(mapimg.mapdef);
 
@@ -1312,12 +1385,15 @@ bool mapimg_id2str(int id, char *str, size_t str_len)
   <basename as used for savegames>-<mapstr>.<mapext> where <mapstr>
   contains the map definition and <mapext> the selected image extension.
   If 'force' is FALSE, the image is only created if game.info.turn is a
-  multiple of the map setting turns.
+  multiple of the map setting turns. If 'background' is TRUE, the images
+  of the built-in toolkit are written by a background thread.
 ****************************************************************************/
-bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
-                   const char *path)
+static bool mapimg_create_real(struct mapdef *pmapdef, bool force,
+                               const char *savename, const char *path,
+                               bool background)
 {
   struct img *pimg;
+  struct img_rgb_list *images = NULL;
   char mapimgfile[MAX_LEN_PATH];
   bool ret = TRUE;
 #ifdef DEBUG
@@ -1354,6 +1430,10 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
   timer_start(timer_user);
 #endif
 
+  if (background) {
+    images = img_rgb_list_new();
+  }
+
   /* create map */
   switch (pmapdef->player.show) {
   case SHOW_PLRNAME: /* display player given by name */
@@ -1366,7 +1446,7 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
 
     pimg = img_new(pmapdef, CURRENT_TOPOLOGY, map.xsize, map.ysize);
     img_createmap(pimg);
-    if (!img_save(pimg, mapimgfile, path)) {
+    if (!img_save_or_queue(pimg, mapimgfile, path, images)) {
       ret = FALSE;
     }
     img_destroy(pimg);
@@ -1389,7 +1469,7 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
 
       pimg = img_new(pmapdef, CURRENT_TOPOLOGY, map.xsize, map.ysize);
       img_createmap(pimg);
-      if (!img_save(pimg, mapimgfile, path)) {
+      if (!img_save_or_queue(pimg, mapimgfile, path, images)) {
         ret = FALSE;
       }
       img_destroy(pimg);
@@ -1401,6 +1481,14 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
     break;
   }
 
+  if (images != NULL) {
+    if (img_rgb_list_size(images) > 0) {
+      img_writer_start(images);
+    } else {
+      img_rgb_list_destroy(images);
+    }
+  }
+
 #ifdef DEBUG
   log_debug("Image generation time: %g seconds (%g apparent)",
             timer_read_seconds(timer_cpu),
@@ -1413,6 +1501,35 @@ bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
   return ret;
 }
 
+/****************************************************************************
+  Create the map image(s) of the definition. The images are written when
+  this function returns.
+****************************************************************************/
+bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
+                   const char *path)
+{
+  return mapimg_create_real(pmapdef, force, savename, path, FALSE);
+}
+
+/****************************************************************************
+  Same as mapimg_create(), but images created by the built-in toolkit are
+  only drawn before returning; the files are written by a background
+  thread. Errors of the background thread are only logged.
+****************************************************************************/
+bool mapimg_create_background(struct mapdef *pmapdef, bool force,
+                              const char *savename, const char *path)
+{
+  return mapimg_create_real(pmapdef, force, savename, path, TRUE);
+}
+
+/****************************************************************************
+  Set the number of threads used to draw one map image.
+****************************************************************************/
+void mapimg_set_threads(int num_threads)
+{
+  mapimg.num_threads = MAX(1, num_threads);
+}
+
 /****************************************************************************
   Create images which shows all map colors (playercolor, terrain colors). One
   image is created for each supported toolkit and image format. The filename
@@ -1925,6 +2042,9 @@ static struct img *img_new(struct mapdef *mapdef, int topo, int xsize, int ysize
     pimg->base_coor = base_coor_rect;
   }
 
+  pimg->rows.min = 0;
+  pimg->rows.max = pimg->imgsize.y;
+
   /* Here the map image is saved as an array of RGB color values. */
   pimg->map = fc_calloc(pimg->imgsize.x * pimg->imgsize.y,
                         sizeof(*pimg->map));
@@ -1989,8 +2109,14 @@ static void img_plot(struct img *pimg, int x, int y,
 
   for (i = 0; i < NUM_PIXEL; i++) {
     if (BV_ISSET(pixel, i)) {
-      index = img_index(base_x + pimg->tileshape->x[i],
-                        base_y + pimg->tileshape->y[i], pimg);
+      int y_pixel = base_y + pimg->tileshape->y[i];
+
+      if (y_pixel < pimg->rows.min || y_pixel >= pimg->rows.max) {
+        /* Drawn by another part of the image; see img_createmap(). */
+        continue;
+      }
+
+      index = img_index(base_x + pimg->tileshape->x[i], y_pixel, pimg);
       img_set_pixel(pimg, index, pcolor);
     }
   }
@@ -2010,7 +2136,29 @@ static void img_plot_tile(struct img *pimg, const struct tile *ptile,
 }
 
 /****************************************************************************
-  Save an image as ppm file.
+  Build the name of the image file (without format extension) from the
+  savegame based name and the save path. The save path is created if
+  needed.
+****************************************************************************/
+static void img_fullname(const char *mapimgfile, const char *path,
+                         char *fullname, size_t fullname_len)
+{
+  if (!path_is_absolute(mapimgfile) && path != NULL) {
+    make_dir(path);
+
+    fc_strlcpy(fullname, path, fullname_len);
+    if (fullname[0] != '\0') {
+      fc_strlcat(fullname, "/", fullname_len);
+    }
+  } else {
+    fullname[0] = '\0';
+  }
+
+  fc_strlcat(fullname, mapimgfile, fullname_len);
+}
+
+/****************************************************************************
+  Save an image with the toolkit of its map definition.
 ****************************************************************************/
 static bool img_save(const struct img *pimg, const char *mapimgfile,
                      const char *path)
@@ -2024,22 +2172,38 @@ static bool img_save(const struct img *pimg, const char *mapimgfile,
     return FALSE;
   }
 
-  if (!path_is_absolute(mapimgfile) && path != NULL) {
-    make_dir(path);
+  img_fullname(mapimgfile, path, tmpname, sizeof(tmpname));
 
-    sz_strlcpy(tmpname, path);
-    if (tmpname[0] != '\0') {
-      sz_strlcat(tmpname, "/");
-    }
-  } else {
-    tmpname[0] = '\0';
+  MAPIMG_ASSERT_RET_VAL(toolkit->img_save, FALSE);
+
+  return toolkit->img_save(pimg, tmpname);
+}
+
+/****************************************************************************
+  Save an image, or if 'images' is not NULL and the image is written by the
+  built-in toolkit, add its RGB values to 'images' to write it later.
+****************************************************************************/
+static bool img_save_or_queue(const struct img *pimg, const char *mapimgfile,
+                              const char *path,
+                              struct img_rgb_list *images)
+{
+  char tmpname[600];
+  char filename[MAX_LEN_PATH];
+
+  if (images == NULL || pimg->def->tool != IMGTOOL_PPM) {
+    return img_save(pimg, mapimgfile, path);
   }
 
-  sz_strlcat(tmpname, mapimgfile);
+  img_fullname(mapimgfile, path, tmpname, sizeof(tmpname));
+  if (!img_filename(tmpname, pimg->def->format, filename,
+                    sizeof(filename))) {
+    MAPIMG_LOG(_("error generating the file name"));
+    return FALSE;
+  }
 
-  MAPIMG_ASSERT_RET_VAL(toolkit->img_save, FALSE);
+  img_rgb_list_append(images, img_rgb_new(pimg, filename));
 
-  return toolkit->img_save(pimg, tmpname);
+  return TRUE;
 }
 
 /****************************************************************************
@@ -2275,79 +2439,402 @@ static bool img_save_magickwand(const struct img *pimg,
 #endif /* HAVE_MAPIMG_MAGICKWAND */
 
 /****************************************************************************
-  Save an image as ppm file (toolkit: ppm).
+  Save an image as ppm or png file (toolkit: ppm).
 ****************************************************************************/
-static bool img_save_ppm(const struct img *pimg, const char *mapimgfile)
+static bool img_save_builtin(const struct img *pimg, const char *mapimgfile)
 {
-  char ppmname[MAX_LEN_PATH];
-  FILE *fp;
-  int x, y, xxx, yyy, index;
-  const struct rgbcolor *pcolor;
+  char filename[MAX_LEN_PATH];
+  struct img_rgb *prgb;
+  bool ret;
 
-  if (pimg->def->format != IMGFORMAT_PPM) {
-    MAPIMG_LOG(_("the ppm toolkit can only create images in the ppm "
-                 "format"));
+  if (!(IMG_BUILTIN_FORMATS & pimg->def->format)) {
+    MAPIMG_LOG(_("the ppm toolkit can not create images in the %s "
+                 "format"), imageformat_name(pimg->def->format));
     return FALSE;
   }
 
-  if (!img_filename(mapimgfile, IMGFORMAT_PPM, ppmname, sizeof(ppmname))) {
+  if (!img_filename(mapimgfile, pimg->def->format, filename,
+                    sizeof(filename))) {
     MAPIMG_LOG(_("error generating the file name"));
     return FALSE;
   }
 
-  fp = fopen(ppmname, "w");
-  if (!fp) {
-    MAPIMG_LOG(_("could not open file: %s"), ppmname);
-    return FALSE;
+  prgb = img_rgb_new(pimg, filename);
+  ret = img_rgb_save(prgb);
+  if (ret) {
+    log_verbose("Map image saved as '%s'.", filename);
+  } else {
+    MAPIMG_LOG(_("could not write file: %s"), filename);
   }
+  img_rgb_destroy(prgb);
 
-  fprintf(fp, "P3\n");
-  fprintf(fp, "# version:2\n");
-  fprintf(fp, "# map definition: %s\n", pimg->def->maparg);
+  return ret;
+}
+
+/****************************************************************************
+  Convert the image to RGB values to be written to 'filename'.
+****************************************************************************/
+static struct img_rgb *img_rgb_new(const struct img *pimg,
+                                   const char *filename)
+{
+  struct img_rgb *prgb = fc_malloc(sizeof(*prgb));
+  const struct rgbcolor *background = imgcolor_special(IMGCOLOR_BACKGROUND);
+  char comment[MAX_LEN_MAPDEF + 32];
+  int i;
+
+  sz_strlcpy(prgb->filename, filename);
+  prgb->format = pimg->def->format;
+  prgb->xsize = pimg->imgsize.x;
+  prgb->ysize = pimg->imgsize.y;
+  prgb->zoom = pimg->def->zoom;
+  prgb->saved = FALSE;
+
+  prgb->comments = strvec_new();
+  strvec_append(prgb->comments, "version:2");
+  fc_snprintf(comment, sizeof(comment), "map definition: %s",
+              pimg->def->maparg);
+  strvec_append(prgb->comments, comment);
 
   if (pimg->def->colortest) {
-    fprintf(fp, "# color test\n");
+    strvec_append(prgb->comments, "color test");
   } else if (BV_ISSET_ANY(pimg->def->player.checked_plrbv)) {
     players_iterate(pplayer) {
       if (!BV_ISSET(pimg->def->player.checked_plrbv, player_index(pplayer))) {
         continue;
       }
 
-      pcolor = imgcolor_player(player_index(pplayer));
-      fprintf(fp, "# %s\n", img_playerstr(pplayer));
+      strvec_append(prgb->comments, img_playerstr(pplayer));
     } players_iterate_end;
   } else {
-    fprintf(fp, "# no players\n");
+    strvec_append(prgb->comments, "no players");
+  }
+
+  prgb->data = fc_malloc(3 * prgb->xsize * prgb->ysize);
+  for (i = 0; i < prgb->xsize * prgb->ysize; i++) {
+    const struct rgbcolor *pcolor = pimg->map[i];
+
+    if (pcolor == NULL) {
+      pcolor = background;
+    }
+
+    prgb->data[3 * i] = pcolor->r;
+    prgb->data[3 * i + 1] = pcolor->g;
+    prgb->data[3 * i + 2] = pcolor->b;
+  }
+
+  return prgb;
+}
+
+/****************************************************************************
+  Free the RGB values of an image.
+****************************************************************************/
+static void img_rgb_destroy(struct img_rgb *prgb)
+{
+  strvec_destroy(prgb->comments);
+  free(prgb->data);
+  free(prgb);
+}
+
+/****************************************************************************
+  Fill 'row' with the zoomed RGB values of the image row y.
+****************************************************************************/
+static void img_rgb_row(const struct img_rgb *prgb, int y,
+                        unsigned char *row)
+{
+  const unsigned char *src = prgb->data + 3 * prgb->xsize * y;
+  int x, xxx;
+
+  for (x = 0; x < prgb->xsize; x++, src += 3) {
+    for (xxx = 0; xxx < prgb->zoom; xxx++) {
+      *row++ = src[0];
+      *row++ = src[1];
+      *row++ = src[2];
+    }
+  }
+}
+
+/****************************************************************************
+  Write the image file. This does not use the game state and logs nothing,
+  so it can be run by a background thread. The result is also saved in
+  prgb->saved.
+****************************************************************************/
+static bool img_rgb_save(struct img_rgb *prgb)
+{
+  switch (prgb->format) {
+  case IMGFORMAT_PPM:
+    prgb->saved = img_rgb_save_ppm(prgb);
+    break;
+#ifdef HAVE_LIBZ
+  case IMGFORMAT_PNG:
+    prgb->saved = img_rgb_save_png(prgb);
+    break;
+#endif /* HAVE_LIBZ */
+  default:
+    prgb->saved = FALSE;
+    break;
+  }
+
+  return prgb->saved;
+}
+
+/****************************************************************************
+  Write the image as plain (ASCII) ppm file, one row at a time.
+****************************************************************************/
+static bool img_rgb_save_ppm(const struct img_rgb *prgb)
+{
+  const size_t row_len = 3 * prgb->xsize * prgb->zoom;
+  /* "255 255 255\n" for each pixel of the row. */
+  const size_t text_size = 12 * prgb->xsize * prgb->zoom + 1;
+  unsigned char *row;
+  char *text;
+  FILE *fp;
+  bool ok = TRUE;
+  int y, yyy;
+
+  fp = fc_fopen(prgb->filename, "w");
+  if (!fp) {
+    return FALSE;
   }
 
-  fprintf(fp, "%d %d\n", pimg->imgsize.x * pimg->def->zoom,
-          pimg->imgsize.y * pimg->def->zoom);
+  fprintf(fp, "P3\n");
+  strvec_iterate(prgb->comments, comment) {
+    fprintf(fp, "# %s\n", comment);
+  } strvec_iterate_end;
+  fprintf(fp, "%d %d\n", prgb->xsize * prgb->zoom,
+          prgb->ysize * prgb->zoom);
   fprintf(fp, "255\n");
 
-  /* y coordinate */
-  for (y = 0; y < pimg->imgsize.y; y++) {
-    /* zoom for y */
-    for (yyy = 0; yyy < pimg->def->zoom; yyy++) {
-      /* x coordinate */
-      for (x = 0; x < pimg->imgsize.x; x++) {
-        index = img_index(x, y, pimg);
-        pcolor = pimg->map[index];
+  row = fc_malloc(row_len);
+  text = fc_malloc(text_size);
+  for (y = 0; ok && y < prgb->ysize; y++) {
+    size_t text_len = 0;
+    size_t i;
 
-        /* zoom for x */
-        for (xxx = 0; xxx < pimg->def->zoom; xxx++) {
-          if (pcolor == NULL) {
-            pcolor = imgcolor_special(IMGCOLOR_BACKGROUND);
-          }
-          fprintf(fp, "%d %d %d\n", pcolor->r, pcolor->g, pcolor->b);
+    img_rgb_row(prgb, y, row);
+    for (i = 0; i < row_len; i += 3) {
+      text_len += fc_snprintf(text + text_len, text_size - text_len,
+                              "%d %d %d\n", row[i], row[i + 1], row[i + 2]);
+    }
+    for (yyy = 0; ok && yyy < prgb->zoom; yyy++) {
+      ok = (fwrite(text, 1, text_len, fp) == text_len);
+    }
+  }
+  free(text);
+  free(row);
+
+  if (fclose(fp) != 0) {
+    ok = FALSE;
+  }
+
+  return ok;
+}
+
+#ifdef HAVE_LIBZ
+/* Size of the compressed data chunks of png files. */
+#define IMG_PNG_CHUNK_SIZE 65536
+
+/****************************************************************************
+  Store a 32 bit value in network byte order.
+****************************************************************************/
+static void img_png_put32(unsigned char *buf, unsigned long value)
+{
+  buf[0] = (value >> 24) & 0xff;
+  buf[1] = (value >> 16) & 0xff;
+  buf[2] = (value >> 8) & 0xff;
+  buf[3] = value & 0xff;
+}
+
+/****************************************************************************
+  Write one png chunk.
+****************************************************************************/
+static bool img_png_chunk(FILE *fp, const char *type,
+                          const unsigned char *data, size_t len)
+{
+  unsigned char head[8], crc[4];
+  uLong sum;
+
+  img_png_put32(head, len);
+  memcpy(head + 4, type, 4);
+  sum = crc32(0L, head + 4, 4);
+  if (len > 0) {
+    sum = crc32(sum, data, len);
+  }
+  img_png_put32(crc, sum);
+
+  return (fwrite(head, 1, sizeof(head), fp) == sizeof(head)
+          && (len == 0 || fwrite(data, 1, len, fp) == len)
+          && fwrite(crc, 1, sizeof(crc), fp) == sizeof(crc));
+}
+
+/****************************************************************************
+  Write the image as png file. The rows are compressed one at a time and
+  written out whenever a data chunk is full.
+****************************************************************************/
+static bool img_rgb_save_png(const struct img_rgb *prgb)
+{
+  static const unsigned char signature[8] = {
+    137, 'P', 'N', 'G', '\r', '\n', 26, '\n'
+  };
+  /* keyword, compression flag and method, empty language tag and
+   * translated keyword of the comment chunk */
+  static const char text_head[] = "Comment\0\0\0\0\0";
+  const size_t row_len = 1 + 3 * prgb->xsize * prgb->zoom;
+  unsigned char header[13];
+  unsigned char *row, *out, *text;
+  size_t text_len;
+  z_stream zs;
+  FILE *fp;
+  bool ok;
+  int y, yyy, zret;
+
+  fp = fc_fopen(prgb->filename, "wb");
+  if (!fp) {
+    return FALSE;
+  }
+
+  /* 8 bit RGB, not interlaced. */
+  img_png_put32(header, prgb->xsize * prgb->zoom);
+  img_png_put32(header + 4, prgb->ysize * prgb->zoom);
+  header[8] = 8;
+  header[9] = 2;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = 0;
+  ok = (fwrite(signature, 1, sizeof(signature), fp) == sizeof(signature)
+        && img_png_chunk(fp, "IHDR", header, sizeof(header)));
+
+  /* The comments, one per line, as UTF-8 text chunk. */
+  text_len = sizeof(text_head) - 1;
+  strvec_iterate(prgb->comments, comment) {
+    text_len += strlen(comment) + 1;
+  } strvec_iterate_end;
+  text = fc_malloc(text_len);
+  memcpy(text, text_head, sizeof(text_head) - 1);
+  text_len = sizeof(text_head) - 1;
+  strvec_iterate(prgb->comments, comment) {
+    if (text_len > sizeof(text_head) - 1) {
+      text[text_len++] = '\n';
+    }
+    memcpy(text + text_len, comment, strlen(comment));
+    text_len += strlen(comment);
+  } strvec_iterate_end;
+  ok = ok && img_png_chunk(fp, "iTXt", text, text_len);
+  free(text);
+
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    fclose(fp);
+    return FALSE;
+  }
+
+  row = fc_malloc(row_len);
+  out = fc_malloc(IMG_PNG_CHUNK_SIZE);
+  zs.next_out = out;
+  zs.avail_out = IMG_PNG_CHUNK_SIZE;
+
+  /* Each row starts with its filter type; 0 is 'none'. */
+  row[0] = 0;
+  for (y = 0; ok && y < prgb->ysize; y++) {
+    img_rgb_row(prgb, y, row + 1);
+    for (yyy = 0; ok && yyy < prgb->zoom; yyy++) {
+      zs.next_in = row;
+      zs.avail_in = row_len;
+      while (ok && zs.avail_in > 0) {
+        ok = (deflate(&zs, Z_NO_FLUSH) == Z_OK);
+        if (ok && zs.avail_out == 0) {
+          ok = img_png_chunk(fp, "IDAT", out, IMG_PNG_CHUNK_SIZE);
+          zs.next_out = out;
+          zs.avail_out = IMG_PNG_CHUNK_SIZE;
         }
       }
     }
   }
 
-  log_verbose("Map image saved as '%s'.", ppmname);
-  fclose(fp);
+  zret = Z_OK;
+  while (ok && zret != Z_STREAM_END) {
+    zret = deflate(&zs, Z_FINISH);
+    ok = (zret == Z_OK || zret == Z_STREAM_END);
+    if (ok && (zs.avail_out == 0 || zret == Z_STREAM_END)) {
+      ok = img_png_chunk(fp, "IDAT", out,
+                         IMG_PNG_CHUNK_SIZE - zs.avail_out);
+      zs.next_out = out;
+      zs.avail_out = IMG_PNG_CHUNK_SIZE;
+    }
+  }
+  deflateEnd(&zs);
+  free(row);
+  free(out);
 
-  return TRUE;
+  ok = ok && img_png_chunk(fp, "IEND", NULL, 0);
+
+  if (fclose(fp) != 0) {
+    ok = FALSE;
+  }
+
+  return ok;
+}
+#endif /* HAVE_LIBZ */
+
+/****************************************************************************
+  Main function of the background writer thread.
+****************************************************************************/
+static void img_writer_main(void *arg)
+{
+  struct img_rgb_list *images = arg;
+
+  img_rgb_list_iterate(images, prgb) {
+    img_rgb_save(prgb);
+  } img_rgb_list_iterate_end;
+}
+
+/****************************************************************************
+  Log the result for the images written by the background writer and free
+  them.
+****************************************************************************/
+static void img_writer_report(void)
+{
+  img_rgb_list_iterate(mapimg.writer.images, prgb) {
+    if (prgb->saved) {
+      log_verbose("Map image saved as '%s'.", prgb->filename);
+    } else {
+      log_error("Could not write map image '%s'.", prgb->filename);
+    }
+    img_rgb_destroy(prgb);
+  } img_rgb_list_iterate_end;
+
+  img_rgb_list_destroy(mapimg.writer.images);
+  mapimg.writer.images = NULL;
+}
+
+/****************************************************************************
+  Wait until the background writer has written its images.
+****************************************************************************/
+static void img_writer_wait(void)
+{
+  if (mapimg.writer.running) {
+    fc_thread_wait(&mapimg.writer.thread);
+    mapimg.writer.running = FALSE;
+    img_writer_report();
+  }
+}
+
+/****************************************************************************
+  Let the background writer write the images and free the list. The images
+  given by an earlier call are written first. If no thread can be started,
+  the images are written before returning.
+****************************************************************************/
+static void img_writer_start(struct img_rgb_list *images)
+{
+  img_writer_wait();
+
+  mapimg.writer.images = images;
+  if (fc_thread_start(&mapimg.writer.thread, img_writer_main,
+                      images) == 0) {
+    mapimg.writer.running = TRUE;
+  } else {
+    img_writer_main(images);
+    img_writer_report();
+  }
 }
 
 /****************************************************************************
@@ -2380,11 +2867,47 @@ static const char *img_playerstr(const struct player *pplayer)
   return buf;
 }
 
+/****************************************************************************
+  Return the number of bands of rows img_createmap() splits the image into.
+****************************************************************************/
+static int img_createmap_bands(const struct img *pimg)
+{
+  return MAX(1, MIN(mapimg.num_threads,
+                    pimg->imgsize.y / IMG_BAND_MIN_ROWS));
+}
+
+/****************************************************************************
+  Helper for img_createmap(): draws one band of image rows.
+****************************************************************************/
+static void img_createmap_job(int index, void *data)
+{
+  const struct img *pimg = data;
+  int num_bands = img_createmap_bands(pimg);
+  struct img band = *pimg;
+
+  band.rows.min = pimg->imgsize.y * index / num_bands;
+  band.rows.max = pimg->imgsize.y * (index + 1) / num_bands;
+  img_createmap_rows(&band);
+}
+
 /****************************************************************************
   Create the map considering the options (terrain, player(s), cities,
   units, borders, known, fogofwar, ...).
 ****************************************************************************/
 static void img_createmap(struct img *pimg)
+{
+  int num_bands = img_createmap_bands(pimg);
+
+  /* Each band of rows is drawn from all the tiles covering it, in the
+   * same order as a single band, so the image does not depend on the
+   * number of threads. */
+  fc_thread_run_jobs(num_bands, num_bands, img_createmap_job, pimg);
+}
+
+/****************************************************************************
+  Draw the rows pimg->rows of the map image. Only reads the game state.
+****************************************************************************/
+static void img_createmap_rows(struct img *pimg)
 {
   const struct rgbcolor *pcolor;
   bv_pixel pixel;
@@ -2396,6 +2919,15 @@ static void img_createmap(struct img *pimg)
   bool plr_knowledge = pimg->def->layers[MAPIMG_LAYER_KNOWLEDGE];
 
   whole_map_iterate(ptile) {
+    int x, y, base_x, base_y;
+
+    index_to_map_pos(&x, &y, tile_index(ptile));
+    pimg->base_coor(pimg, &base_x, &base_y, x, y);
+    if (base_y >= pimg->rows.max || base_y + 2 * TILE_SIZE <= pimg->rows.min) {
+      /* No pixel of this tile is within the rows to draw. */
+      continue;
+    }
+
     if (bvplayers_count(pimg->def) == 1) {
       /* only one player; get player id for 'known' and 'fogofwar' */
       players_iterate(aplayer) {
@@ -31,6 +31,9 @@
     mapimg_id2str()     Convert the map image definition to a string. Usefull
                         to save the definitions.
     mapimg_create()     ...
+    mapimg_create_background()  Same as mapimg_create(), but the files of
+                        the built-in toolkit are written by a background
+                        thread.
     mapimg_colortest()  ...
 
     These functions return TRUE on success and FALSE on error. In the later
@@ -125,6 +128,9 @@ bool mapimg_show(int id, char *str, size_t str_len, bool detail);
 bool mapimg_id2str(int id, char *str, size_t str_len);
 bool mapimg_create(struct mapdef *pmapdef, bool force, const char *savename,
                    const char *path);
+bool mapimg_create_background(struct mapdef *pmapdef, bool force,
+                              const char *savename, const char *path);
+void mapimg_set_threads(int num_threads);
 bool mapimg_colortest(const char *savename, const char *path);
 
 struct mapdef *mapimg_isvalid(int id);
@@ -37,6 +37,7 @@
 /* utility */
 #include "capability.h"
 #include "fcintl.h"
+#include "genhash.h"
 #include "log.h"
 #include "mem.h"
 #include "support.h"
@@ -76,6 +77,10 @@
  */
 #define PACKET_SIZE_STATISTICS 0
 
+static void packet_stream_add(struct packet_stream *pstream,
+                              const unsigned char *data, int len,
+                              enum packet_type packet_type);
+
 #ifdef USE_COMPRESSION
 static int stat_size_alone = 0;
 static int stat_size_uncompressed = 0;
@@ -100,73 +105,95 @@ static inline int get_compression_level(void)
   return level;
 }
 
+/* Room needed by compress_packets() to compress 'size' bytes. */
+#define COMPRESSED_PACKETS_BOUND(size) (12 + 1.001 * (size) + 6)
+
 /****************************************************************************
-  Send all waiting data. Return TRUE on success.
+  Put the packets 'data' in the form they are sent to the network: one
+  compressed (maybe jumbo) packet, or the packets themselves if compressing
+  would enlarge them. 'out' must have room for
+  COMPRESSED_PACKETS_BOUND(size) bytes. The number of bytes written to
+  'out' is put in 'out_size'. Returns TRUE on success.
 ****************************************************************************/
-static bool conn_compression_flush(struct connection *pconn)
+static bool compress_packets(const unsigned char *data, size_t size,
+                             unsigned char *out, size_t *out_size)
 {
   int compression_level = get_compression_level();
-  uLongf compressed_size = 12 + 1.001 * pconn->compression.queue.size;
+  uLongf compressed_size = 12 + 1.001 * size;
   int error;
-  Bytef compressed[compressed_size];
   bool jumbo;
   unsigned long compressed_packet_len;
 
-  error = compress2(compressed, &compressed_size,
-                    pconn->compression.queue.p,
-                    pconn->compression.queue.size,
+  /* Compress after the room of the longest (jumbo) header; the data is
+   * moved next to the header once its length is known. */
+  error = compress2(out + 6, &compressed_size, data, size,
                     compression_level);
   fc_assert_ret_val(error == Z_OK, FALSE);
 
-  /* Compression signalling currently assumes a 2-byte packet length; if that
-   * changes, the protocol should probably be changed */
-  fc_assert_ret_val(data_type_size(pconn->packet_header.length) == 2, FALSE);
-
   /* Include normal length field in decision */
   jumbo = (compressed_size+2 >= JUMBO_BORDER);
 
   compressed_packet_len = compressed_size + (jumbo ? 6 : 2);
-  if (compressed_packet_len < pconn->compression.queue.size) {
+  if (compressed_packet_len < size) {
     struct data_out dout;
 
     log_compress("COMPRESS: compressed %lu bytes to %ld (level %d)",
-                 (unsigned long) pconn->compression.queue.size,
-                 compressed_size, compression_level);
-    stat_size_uncompressed += pconn->compression.queue.size;
+                 (unsigned long) size, compressed_size, compression_level);
+    stat_size_uncompressed += size;
     stat_size_compressed += compressed_size;
 
     if (!jumbo) {
-      unsigned char header[2];
       FC_STATIC_ASSERT(COMPRESSION_BORDER > MAX_LEN_PACKET,
                        uncompressed_compressed_packet_len_overlap);
 
       log_compress("COMPRESS: sending %ld as normal", compressed_size);
 
-      dio_output_init(&dout, header, sizeof(header));
+      dio_output_init(&dout, out, 2);
       dio_put_uint16(&dout, 2 + compressed_size + COMPRESSION_BORDER);
-      connection_send_data(pconn, header, sizeof(header));
-      connection_send_data(pconn, compressed, compressed_size);
     } else {
-      unsigned char header[6];
       FC_STATIC_ASSERT(JUMBO_SIZE >= JUMBO_BORDER+COMPRESSION_BORDER,
                        compressed_normal_jumbo_packet_len_overlap);
 
       log_compress("COMPRESS: sending %ld as jumbo", compressed_size);
-      dio_output_init(&dout, header, sizeof(header));
+      dio_output_init(&dout, out, 6);
       dio_put_uint16(&dout, JUMBO_SIZE);
       dio_put_uint32(&dout, 6 + compressed_size);
-      connection_send_data(pconn, header, sizeof(header));
-      connection_send_data(pconn, compressed, compressed_size);
     }
+    memmove(out + compressed_packet_len - compressed_size, out + 6,
+            compressed_size);
+    *out_size = compressed_packet_len;
   } else {
     log_compress("COMPRESS: would enlarge %lu bytes to %ld; "
                  "sending uncompressed",
-                 (unsigned long) pconn->compression.queue.size,
-                 compressed_packet_len);
-    connection_send_data(pconn, pconn->compression.queue.p,
-                         pconn->compression.queue.size);
-    stat_size_no_compression += pconn->compression.queue.size;
+                 (unsigned long) size, compressed_packet_len);
+    memcpy(out, data, size);
+    stat_size_no_compression += size;
+    *out_size = size;
+  }
+
+  return TRUE;
+}
+
+/****************************************************************************
+  Send all waiting data. Return TRUE on success.
+****************************************************************************/
+static bool conn_compression_flush(struct connection *pconn)
+{
+  struct byte_vector *out = &pconn->compression.out;
+  size_t out_size;
+
+  /* Compression signalling currently assumes a 2-byte packet length; if that
+   * changes, the protocol should probably be changed */
+  fc_assert_ret_val(data_type_size(pconn->packet_header.length) == 2, FALSE);
+
+  byte_vector_reserve(out,
+                      COMPRESSED_PACKETS_BOUND(pconn->compression.queue.size));
+  if (!compress_packets(pconn->compression.queue.p,
+                        pconn->compression.queue.size, out->p, &out_size)) {
+    return FALSE;
   }
+  connection_send_data(pconn, out->p, out_size);
+
   return pconn->used;
 }
 #endif /* USE_COMPRESSION */
@@ -213,10 +240,18 @@ int send_packet_data(struct connection *pc, unsigned char *data, int len,
     log_packet("sending request %d", result);
   }
 
+  if (pc->flush_pending) {
+    pc->flush_pending(pc);
+  }
+
   if (pc->outgoing_packet_notify) {
     pc->outgoing_packet_notify(pc, packet_type, len, result);
   }
 
+  if (NULL != pc->recording) {
+    packet_stream_add(pc->recording, data, len, packet_type);
+  }
+
 #ifdef USE_COMPRESSION
   if (TRUE) {
     int size = len;
@@ -351,6 +386,246 @@ int send_packet_data(struct connection *pc, unsigned char *data, int len,
   return result;
 }
 
+/* Packets of a stream are compressed in chunks of this many bytes at
+ * most, like the compression queue of a connection. */
+#define PACKET_STREAM_CHUNK_SIZE (MAX_LEN_BUFFER / 2)
+
+/* A part of a packet stream, in the form it is sent to the network. */
+struct packet_stream_chunk {
+  unsigned char *data;
+  size_t size;
+};
+
+struct packet_stream {
+  char capability[MAX_LEN_CAPSTR];
+  bool valid;
+
+  /* Whether no packet of each type had been sent to the recorded
+   * connection before the recording started, and whether some were sent
+   * during the recording. */
+  bool fresh[PACKET_LAST];
+  bool sent[PACKET_LAST];
+  /* The delta state of the recorded connection after the stream. */
+  struct genhash *delta[PACKET_LAST];
+
+  struct byte_vector queue;     /* Packets not yet put in a chunk. */
+  int num_chunks;
+  struct packet_stream_chunk *chunks;
+};
+
+/**************************************************************************
+  Return a copy of the delta state 'phash' of the packets of type 'type'.
+**************************************************************************/
+static struct genhash *packet_delta_copy(const struct genhash *phash,
+                                         enum packet_type type)
+{
+  struct genhash *pcopy = genhash_copy_empty(phash);
+  size_t size = packet_struct_size(type);
+
+  /* The packets are both the keys and the data of the table. */
+  genhash_values_iterate(phash, ppacket) {
+    void *copy = fc_malloc(size);
+
+    memcpy(copy, ppacket, size);
+    genhash_insert(pcopy, copy, copy);
+  } genhash_values_iterate_end;
+
+  return pcopy;
+}
+
+/**************************************************************************
+  Put the queued packets of the stream in a new chunk.
+**************************************************************************/
+static void packet_stream_flush(struct packet_stream *pstream)
+{
+  struct packet_stream_chunk *pchunk;
+  size_t size = byte_vector_size(&pstream->queue);
+
+  if (0 == size) {
+    return;
+  }
+
+  pstream->chunks = fc_realloc(pstream->chunks, (pstream->num_chunks + 1)
+                               * sizeof(*pstream->chunks));
+  pchunk = pstream->chunks + pstream->num_chunks++;
+
+#ifdef USE_COMPRESSION
+  pchunk->data = fc_malloc(COMPRESSED_PACKETS_BOUND(size));
+  if (!compress_packets(pstream->queue.p, size, pchunk->data,
+                        &pchunk->size)) {
+    pstream->valid = FALSE;
+  }
+#else  /* USE_COMPRESSION */
+  pchunk->data = fc_malloc(size);
+  memcpy(pchunk->data, pstream->queue.p, size);
+  pchunk->size = size;
+#endif /* USE_COMPRESSION */
+
+  byte_vector_reserve(&pstream->queue, 0);
+}
+
+/**************************************************************************
+  Add a packet to the stream being recorded.
+**************************************************************************/
+static void packet_stream_add(struct packet_stream *pstream,
+                              const unsigned char *data, int len,
+                              enum packet_type packet_type)
+{
+  size_t old_size = byte_vector_size(&pstream->queue);
+
+  pstream->sent[packet_type] = TRUE;
+
+  if (PACKET_STREAM_CHUNK_SIZE < old_size + len) {
+    packet_stream_flush(pstream);
+    old_size = 0;
+  }
+
+  byte_vector_reserve(&pstream->queue, old_size + len);
+  memcpy(pstream->queue.p + old_size, data, len);
+}
+
+/**************************************************************************
+  Start recording the packets sent to the connection, until
+  packet_stream_record_stop() is called.
+**************************************************************************/
+void packet_stream_record_start(struct connection *pconn)
+{
+  struct packet_stream *pstream = fc_calloc(1, sizeof(*pstream));
+  int i;
+
+  fc_assert_ret(NULL == pconn->recording);
+
+  sz_strlcpy(pstream->capability, pconn->capability);
+  pstream->valid = TRUE;
+  for (i = 0; i < PACKET_LAST; i++) {
+    pstream->fresh[i] = (NULL == pconn->phs.sent[i]
+                         || 0 == genhash_size(pconn->phs.sent[i]));
+  }
+  byte_vector_init(&pstream->queue);
+
+  pconn->recording = pstream;
+}
+
+/**************************************************************************
+  Stop recording the packets sent to the connection, and return the
+  stream of the packets sent since packet_stream_record_start(). Returns
+  NULL if the stream cannot be sent again: when some of its packets were
+  encoded against packets sent to the connection before the recording.
+**************************************************************************/
+struct packet_stream *packet_stream_record_stop(struct connection *pconn)
+{
+  struct packet_stream *pstream = pconn->recording;
+  int i;
+
+  fc_assert_ret_val(NULL != pstream, NULL);
+  pconn->recording = NULL;
+
+  packet_stream_flush(pstream);
+  byte_vector_free(&pstream->queue);
+
+  for (i = 0; i < PACKET_LAST && pstream->valid; i++) {
+    if (!pstream->sent[i]) {
+      continue;
+    }
+
+    if (!pstream->fresh[i]) {
+      /* These packets may be encoded against older ones. */
+      pstream->valid = FALSE;
+    } else if (NULL != pconn->phs.sent[i]
+               && 0 < genhash_size(pconn->phs.sent[i])) {
+      pstream->delta[i] = packet_delta_copy(pconn->phs.sent[i], i);
+    }
+  }
+
+  if (!pstream->valid) {
+    packet_stream_destroy(pstream);
+    return NULL;
+  }
+
+  return pstream;
+}
+
+/**************************************************************************
+  Send the recorded stream to the connection, as if its packets were sent
+  again. Returns FALSE, sending nothing, if the stream does not fit the
+  connection: if it has another capability string, or if packets of the
+  same types as in the stream were already sent to it.
+**************************************************************************/
+bool packet_stream_send(const struct packet_stream *pstream,
+                        struct connection *pconn)
+{
+  int i;
+
+  if (0 != strcmp(pstream->capability, pconn->capability)) {
+    return FALSE;
+  }
+  for (i = 0; i < PACKET_LAST; i++) {
+    if (NULL != pstream->delta[i] && NULL != pconn->phs.sent[i]
+        && 0 < genhash_size(pconn->phs.sent[i])) {
+      return FALSE;
+    }
+  }
+
+  if (pconn->flush_pending) {
+    pconn->flush_pending(pconn);
+  }
+
+#ifdef USE_COMPRESSION
+  if (conn_compression_frozen(pconn)
+      && 0 < byte_vector_size(&pconn->compression.queue)) {
+    /* Keep the order of the packets. */
+    if (!conn_compression_flush(pconn)) {
+      return TRUE;
+    }
+    byte_vector_reserve(&pconn->compression.queue, 0);
+  }
+#endif /* USE_COMPRESSION */
+
+  for (i = 0; i < PACKET_LAST; i++) {
+    if (NULL != pstream->delta[i]) {
+      if (NULL != pconn->phs.sent[i]) {
+        genhash_destroy(pconn->phs.sent[i]);
+      }
+      pconn->phs.sent[i] = packet_delta_copy(pstream->delta[i], i);
+    }
+  }
+
+  for (i = 0; i < pstream->num_chunks; i++) {
+    connection_send_data(pconn, pstream->chunks[i].data,
+                         pstream->chunks[i].size);
+  }
+
+  return TRUE;
+}
+
+/**************************************************************************
+  Return the capability string of the connection the stream was recorded
+  on. The stream can only be sent to connections with the same one.
+**************************************************************************/
+const char *packet_stream_capability(const struct packet_stream *pstream)
+{
+  return pstream->capability;
+}
+
+/**************************************************************************
+  Free a packet stream.
+**************************************************************************/
+void packet_stream_destroy(struct packet_stream *pstream)
+{
+  int i;
+
+  for (i = 0; i < PACKET_LAST; i++) {
+    if (NULL != pstream->delta[i]) {
+      genhash_destroy(pstream->delta[i]);
+    }
+  }
+  for (i = 0; i < pstream->num_chunks; i++) {
+    free(pstream->chunks[i].data);
+  }
+  free(pstream->chunks);
+  free(pstream);
+}
+
 /**************************************************************************
   Read and return a packet from the connection 'pc'. The type of the
   packet is written in 'ptype'. On error, the connection is closed and
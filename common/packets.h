@@ -39,6 +39,9 @@ struct data_in;
 /* Used in network protocol. */
 #define MAX_LEN_MSG             1536
 #define MAX_LEN_ROUTE		2000	  /* MAX_LEN_PACKET/2 - header */
+/* Runs of tiles in a PACKET_TILE_INFO_BLOCK; 15 bytes each must fit in
+ * MAX_LEN_PACKET. */
+#define MAX_TILE_INFO_BLOCK     200
 
 /* The size of opaque (void *) data sent in the network packet.  To avoid
  * fragmentation issues, this SHOULD NOT be larger than the standard
@@ -97,6 +100,18 @@ void generic_handle_player_attribute_chunk(struct player *pplayer,
 					   *chunk);
 const char *packet_name(enum packet_type type);
 bool packet_has_game_info_flag(enum packet_type type);
+size_t packet_struct_size(enum packet_type type);
+
+/* A recorded stream of packets, which can be sent again to other
+ * connections without encoding the packets again. */
+struct packet_stream;
+
+void packet_stream_record_start(struct connection *pconn);
+struct packet_stream *packet_stream_record_stop(struct connection *pconn);
+bool packet_stream_send(const struct packet_stream *pstream,
+                        struct connection *pconn);
+const char *packet_stream_capability(const struct packet_stream *pstream);
+void packet_stream_destroy(struct packet_stream *pstream);
 
 void packet_header_init(struct packet_header *packet_header);
 void post_send_packet_server_join_reply(struct connection *pconn,
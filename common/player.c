@@ -592,6 +592,7 @@ static void player_defaults(struct player *pplayer)
   for (i = 0; i < B_LAST; i++) {
     pplayer->wonders[i] = WONDER_NOT_BUILT;
   }
+  requirement_cache_invalidate();
 
   pplayer->attribute_block.data = NULL;
   pplayer->attribute_block.length = 0;
@@ -790,6 +791,26 @@ struct player *player_by_number(const int player_id)
   return (NULL != pslot ? player_slot_get_player(pslot) : NULL);
 }
 
+/**************************************************************************
+  Return the lowest player index not below 'index' that is set in the
+  bitvector, or MAX_NUM_PLAYER_SLOTS if there is none. Whole bytes without
+  any player are skipped at once.
+**************************************************************************/
+int player_bv_next(const bv_player *pbv, int index)
+{
+  while (index < MAX_NUM_PLAYER_SLOTS) {
+    if (0 == (index & 7) && 0 == pbv->vec[_BV_BYTE_INDEX(index)]) {
+      index += 8;
+    } else if (BV_ISSET(*pbv, index)) {
+      return index;
+    } else {
+      index++;
+    }
+  }
+
+  return MAX_NUM_PLAYER_SLOTS;
+}
+
 /****************************************************************************
   Set the player's nation to the given nation (may be NULL).  Returns TRUE
   iff there was a change.
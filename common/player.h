@@ -318,6 +318,7 @@ int player_count(void);
 int player_index(const struct player *pplayer);
 int player_number(const struct player *pplayer);
 struct player *player_by_number(const int player_id);
+int player_bv_next(const bv_player *pbv, int index);
 
 const char *player_name(const struct player *pplayer);
 struct player *player_by_name(const char *name);
@@ -432,6 +433,19 @@ bool gives_shared_vision(const struct player *me, const struct player *them);
     }                                                                       \
   } player_slots_iterate_end;
 
+/* iterate over the players whose index is set in the bv_player _bv */
+#define players_in_bv_iterate(_bv, _pplayer)                                \
+{                                                                           \
+  int _pindex##_pplayer = player_bv_next(&(_bv), 0);                        \
+  for (; _pindex##_pplayer < MAX_NUM_PLAYER_SLOTS;                          \
+       _pindex##_pplayer = player_bv_next(&(_bv), _pindex##_pplayer + 1)) { \
+    struct player *_pplayer = player_by_number(_pindex##_pplayer);          \
+    if (_pplayer != NULL) {
+#define players_in_bv_iterate_end                                           \
+    }                                                                       \
+  }                                                                         \
+}
+
 /* iterate over all players, which are used at the moment and are alive */
 #define players_iterate_alive(_pplayer)                                     \
   players_iterate(_pplayer) {                                                \
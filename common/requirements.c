@@ -14,8 +14,12 @@
 #include <fc_config.h>
 #endif
 
+#include <limits.h>
+#include <string.h>
+
 /* utility */
 #include "fcintl.h"
+#include "fcthread.h"
 #include "game.h"
 #include "log.h"
 #include "support.h"
@@ -30,6 +34,23 @@
 
 #include "requirements.h"
 
+/* Cache of the evaluations of requirements which only depend on the target
+ * player and on global game state. There is one row per player slot and one
+ * for the world range; the columns are the buildings followed by the tech
+ * flags, each once without and once with 'survives'. An entry holds the
+ * generation it was computed in, shifted left by two bits, and the result.
+ * Entries from earlier generations are stale.
+ *
+ * The cache is not synchronized: only the main thread may use it. While
+ * fc_thread_run_jobs() runs jobs on several threads, which all may
+ * evaluate requirements, the cache is neither read nor written. */
+#define REQ_CACHE_WORLD MAX_NUM_PLAYER_SLOTS
+#define REQ_CACHE_COLUMNS (2 * (B_LAST + TF_COUNT))
+#define REQ_CACHE_GENERATION_MAX (UINT_MAX >> 2)
+
+static unsigned int req_cache[REQ_CACHE_WORLD + 1][REQ_CACHE_COLUMNS];
+static unsigned int req_cache_generation = 1;
+
 /**************************************************************************
   Parse requirement type (kind) and value strings into a universal
   structure.  Passing in a NULL type is considered VUT_NONE (not an error).
@@ -1513,6 +1534,77 @@ static enum fc_tristate is_citytile_in_range(const struct tile *target_tile,
   }
 }
 
+/****************************************************************************
+  Forget all cached requirement evaluations. Must be called whenever the
+  wonders, the known techs or the players themselves change. Only the
+  main thread may call it.
+****************************************************************************/
+void requirement_cache_invalidate(void)
+{
+  if (++req_cache_generation > REQ_CACHE_GENERATION_MAX) {
+    memset(req_cache, 0, sizeof(req_cache));
+    req_cache_generation = 1;
+  }
+}
+
+/****************************************************************************
+  Return the cache entry of the requirement for the target player, or NULL
+  if the evaluation at this range is not cached. column is the index of the
+  requirement source among the cached ones.
+****************************************************************************/
+static unsigned int *req_cache_entry(const struct player *target_player,
+                                     const struct requirement *req,
+                                     int column)
+{
+  int row;
+
+  if (fc_thread_jobs_running()) {
+    /* Possibly not on the main thread. */
+    return NULL;
+  }
+
+  switch (req->range) {
+  case REQ_RANGE_WORLD:
+    row = REQ_CACHE_WORLD;
+    break;
+  case REQ_RANGE_PLAYER:
+    if (NULL == target_player) {
+      return NULL;
+    }
+    row = player_index(target_player);
+    break;
+  default:
+    return NULL;
+  }
+
+  return &req_cache[row][2 * column + (req->survives ? 1 : 0)];
+}
+
+/****************************************************************************
+  If the cache entry is from the current generation, put its result into
+  eval and return TRUE.
+****************************************************************************/
+static bool req_cache_lookup(const unsigned int *entry,
+                             enum fc_tristate *eval)
+{
+  if (NULL != entry && (*entry >> 2) == req_cache_generation) {
+    *eval = *entry & 0x3;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/****************************************************************************
+  Store the result of an evaluation in the cache entry, if there is one.
+****************************************************************************/
+static void req_cache_store(unsigned int *entry, enum fc_tristate eval)
+{
+  if (NULL != entry) {
+    *entry = (req_cache_generation << 2) | eval;
+  }
+}
+
 /****************************************************************************
   Checks the requirement to see if it is active on the given target.
 
@@ -1535,6 +1627,7 @@ bool is_req_active(const struct player *target_player,
                    const enum   req_problem_type prob_type)
 {
   enum fc_tristate eval = TRI_NO;
+  unsigned int *cached;
 
   /* Note the target may actually not exist.  In particular, effects that
    * have a VUT_SPECIAL, VUT_RESOURCE, or VUT_TERRAIN may often be passed
@@ -1550,8 +1643,13 @@ bool is_req_active(const struct player *target_player,
                             advance_number(req->source.value.advance));
     break;
  case VUT_TECHFLAG:
-    eval = is_techflag_in_range(target_player, req->range,
-                                req->source.value.techflag);
+    cached = req_cache_entry(target_player, req,
+                             B_LAST + req->source.value.techflag);
+    if (!req_cache_lookup(cached, &eval)) {
+      eval = is_techflag_in_range(target_player, req->range,
+                                  req->source.value.techflag);
+      req_cache_store(cached, eval);
+    }
     break;
   case VUT_GOVERNMENT:
     /* The requirement is filled if the player is using the government. */
@@ -1562,10 +1660,15 @@ bool is_req_active(const struct player *target_player,
     }
     break;
   case VUT_IMPROVEMENT:
-    eval = is_building_in_range(target_player, target_city,
-                                target_building,
-                                req->range, req->survives,
-                                req->source.value.building);
+    cached = req_cache_entry(target_player, req,
+                             improvement_index(req->source.value.building));
+    if (!req_cache_lookup(cached, &eval)) {
+      eval = is_building_in_range(target_player, target_city,
+                                  target_building,
+                                  req->range, req->survives,
+                                  req->source.value.building);
+      req_cache_store(cached, eval);
+    }
     break;
   case VUT_SPECIAL:
     eval = is_special_in_range(target_tile, target_city,
@@ -112,6 +112,8 @@ bool are_reqs_active(const struct player *target_player,
 
 bool is_req_unchanging(const struct requirement *req);
 
+void requirement_cache_invalidate(void);
+
 /* General universal functions. */
 int universal_number(const struct universal *source);
 
@@ -483,6 +483,9 @@ void team_add_player(struct player *pplayer, struct team *pteam)
   /* Put the player on the new team. */
   pplayer->team = pteam;
   player_list_append(pteam->plrlist, pplayer);
+
+  /* With pooled research, the known techs come from the team. */
+  requirement_cache_invalidate();
 }
 
 /****************************************************************************
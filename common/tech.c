@@ -158,6 +158,7 @@ enum tech_state player_invention_set(struct player *pplayer,
   if (value == TECH_KNOWN) {
     game.info.global_advances[tech] = TRUE;
   }
+  requirement_cache_invalidate();
   return old;
 }
 
@@ -428,6 +429,7 @@ void player_research_update(struct player *pplayer)
       }
     } advance_index_iterate_end;
   }
+  requirement_cache_invalidate();
 }
 
 /**************************************************************************
@@ -15,6 +15,8 @@
 #include <fc_config.h>
 #endif
 
+#include <string.h>
+
 /* utility */
 #include "bitvector.h"
 #include "log.h"
@@ -103,7 +105,12 @@ struct city *tile_worked(const struct tile *ptile)
 ****************************************************************************/
 void tile_set_worked(struct tile *ptile, struct city *pcity)
 {
+  bool had_city = (NULL != tile_city(ptile));
+
   ptile->worked = pcity;
+  if (had_city != (NULL != tile_city(ptile))) {
+    map_tile_changed(ptile);
+  }
 }
 
 #ifndef tile_terrain
@@ -151,6 +158,7 @@ void tile_set_terrain(struct tile *ptile, struct terrain *pterrain)
   } else {
     BV_CLR(ptile->special, S_RESOURCE_VALID);
   }
+  map_tile_changed(ptile);
 }
 
 /****************************************************************************
@@ -239,6 +247,7 @@ void tile_set_bases(struct tile *ptile, bv_bases bases)
     return;
   }
   ptile->bases = bases;
+  map_tile_changed(ptile);
 }
 
 /****************************************************************************
@@ -248,6 +257,7 @@ void tile_set_bases(struct tile *ptile, bv_bases bases)
 void tile_add_base(struct tile *ptile, const struct base_type *pbase)
 {
   BV_SET(ptile->bases, base_index(pbase));
+  map_tile_changed(ptile);
 }
 
 /****************************************************************************
@@ -256,6 +266,7 @@ void tile_add_base(struct tile *ptile, const struct base_type *pbase)
 void tile_remove_base(struct tile *ptile, const struct base_type *pbase)
 {
   BV_CLR(ptile->bases, base_index(pbase));
+  map_tile_changed(ptile);
 }
 
 /****************************************************************************
@@ -915,6 +926,7 @@ void tile_add_road(struct tile *ptile, const struct road_type *proad)
 {
   if (proad != NULL) {
     BV_SET(ptile->roads, road_index(proad));
+    map_tile_changed(ptile);
   }
 }
 
@@ -925,20 +937,22 @@ void tile_remove_road(struct tile *ptile, const struct road_type *proad)
 {
   if (proad != NULL) {
     BV_CLR(ptile->roads, road_index(proad));
+    map_tile_changed(ptile);
   }
 }
 
 /****************************************************************************
-  Returns a virtual tile. If ptile is given, the properties of this tile are
-  copied, else it is completely blank (except for the unit list
-  vtile->units, which is created for you). Be sure to call tile_virtual_free
-  on it when it is no longer needed.
+  Fill vtile, which belongs to the caller (typically it is on the stack),
+  as a virtual tile. If ptile is given, the properties of this tile are
+  copied, else it is completely blank. Unlike tile_virtual_new() nothing
+  is allocated: vtile has no unit list and must not get units nor a
+  virtual city, and it is simply dropped instead of destroyed. This is
+  meant for "what if" evaluations of a changed tile, which neither touch
+  the real tile nor the allocator, so they may run on any thread.
 ****************************************************************************/
-struct tile *tile_virtual_new(const struct tile *ptile)
+void tile_virtual_init(struct tile *vtile, const struct tile *ptile)
 {
-  struct tile *vtile;
-
-  vtile = fc_calloc(1, sizeof(*vtile));
+  memset(vtile, 0, sizeof(*vtile));
 
   /* initialise some values */
   vtile->index = -1;
@@ -949,7 +963,7 @@ struct tile *tile_virtual_new(const struct tile *ptile)
   BV_CLR_ALL(vtile->roads);
   vtile->resource = NULL;
   vtile->terrain = NULL;
-  vtile->units = unit_list_new();
+  vtile->units = NULL;
   vtile->worked = NULL;
   vtile->owner = NULL;
   vtile->claimer = NULL;
@@ -990,6 +1004,20 @@ struct tile *tile_virtual_new(const struct tile *ptile)
     vtile->claimer = ptile->claimer;
     vtile->spec_sprite = NULL;
   }
+}
+
+/****************************************************************************
+  Returns a virtual tile. If ptile is given, the properties of this tile are
+  copied, else it is completely blank (except for the unit list
+  vtile->units, which is created for you). Be sure to call tile_virtual_free
+  on it when it is no longer needed.
+****************************************************************************/
+struct tile *tile_virtual_new(const struct tile *ptile)
+{
+  struct tile *vtile = fc_malloc(sizeof(*vtile));
+
+  tile_virtual_init(vtile, ptile);
+  vtile->units = unit_list_new();
 
   return vtile;
 }
@@ -184,6 +184,7 @@ const char *tile_get_info_text(const struct tile *ptile,
                                bool include_nuisances, int linebreaks);
 
 /* Virtual tiles are tiles that do not exist on the game map. */
+void tile_virtual_init(struct tile *vtile, const struct tile *ptile);
 struct tile *tile_virtual_new(const struct tile *ptile);
 void tile_virtual_destroy(struct tile *vtile);
 bool tile_virtual_check(struct tile *vtile);
@@ -1195,17 +1195,16 @@ bool can_unit_do_activity_targeted_at(const struct unit *punit,
             if (base_has_flag(bp, BF_ALWAYS_ON_CITY_CENTER)) {
               cannot_pillage = TRUE;
             } else if (base_has_flag(bp, BF_AUTO_ON_CITY_CENTER)) {
-              struct tile *vtile = tile_virtual_new(ptile);
+              struct tile vtile;
 
               /* Would base get rebuilt if removed */ 
-              tile_remove_base(vtile, bp);
-              if (player_can_build_base(bp, city_owner(pcity), vtile)) {
+              tile_virtual_init(&vtile, ptile);
+              tile_remove_base(&vtile, bp);
+              if (player_can_build_base(bp, city_owner(pcity), &vtile)) {
                 /* No need to worry about conflicting bases - base would had
                  * not been here if conflicting one is. */
                 cannot_pillage = TRUE;
               }
-
-              tile_virtual_destroy(vtile);
             }
           }
 
@@ -1228,17 +1227,16 @@ bool can_unit_do_activity_targeted_at(const struct unit *punit,
             if (road_has_flag(pr, RF_ALWAYS_ON_CITY_CENTER)) {
               cannot_pillage = TRUE;
             } else if (road_has_flag(pr, RF_AUTO_ON_CITY_CENTER)) {
-              struct tile *vtile = tile_virtual_new(ptile);
+              struct tile vtile;
 
               /* Would road get rebuilt if removed */ 
-              tile_remove_road(vtile, pr);
-              if (player_can_build_road(pr, city_owner(pcity), vtile)) {
+              tile_virtual_init(&vtile, ptile);
+              tile_remove_road(&vtile, pr);
+              if (player_can_build_road(pr, city_owner(pcity), &vtile)) {
                 /* No need to worry about conflicting roads - road would had
                  * not been here if conflicting one is. */
                 cannot_pillage = TRUE;
               }
-
-              tile_virtual_destroy(vtile);
             }
           }
 
@@ -407,7 +407,7 @@ int settler_evaluate_improvements(struct unit *punit,
                      enroute->id, eta, inbound_distance);
           }
 
-          oldv = city_tile_value(pcity, ptile, 0, 0);
+          oldv = adv_city_worker_value_get(pcity, cindex);
 
           /* Now, consider various activities... */
           activity_type_iterate(act) {
@@ -15,11 +15,23 @@
 #include <fc_config.h>
 #endif
 
+#include <string.h>
+
+/* utility */
+#include "fcthread.h"
+#include "log.h"
+#include "mem.h"
+
 /* common */
+#include "base.h"
 #include "city.h"
+#include "effects.h"
 #include "game.h"
+#include "government.h"
 #include "map.h"
 #include "player.h"
+#include "road.h"
+#include "tech.h"
 #include "tile.h"
 
 /* server */
@@ -28,13 +40,73 @@
 
 #include "infracache.h"
 
+#ifdef DEBUG
+/* Check every reused entry of the cache against a fresh calculation. */
+#define INFRACACHE_DEBUG
+#endif
+
 /* cache activities within the city map */
 struct worker_activity_cache {
+  unsigned int stamp;           /* when the values were calculated; 0 if
+                                 * they never were */
+  int value;                    /* city_tile_value() of the tile as it is */
   int act[ACTIVITY_LAST];
   int road[MAX_ROAD_TYPES];
   int base[MAX_BASE_TYPES];
 };
 
+/* The cached values are kept from one call of
+ * initialize_infrastructure_cache() to the next. They are calculated
+ * again only when something they depend on has changed: the tile or one
+ * of its adjacent tiles, the city, its owner or the state of the world:
+ * its wonders, the techs known to the world and the MinYear requirements
+ * the year has reached.
+ * Each of those remembers its state and the stamp of its last change; an
+ * entry of the cache is valid while none of them changed after it. */
+
+/* The state of a tile the values depend on. */
+struct infra_tile_state {
+  struct terrain *terrain;
+  struct resource *resource;
+  bv_special special;
+  bv_bases bases;
+  bv_roads roads;
+  struct player *owner;
+  bool city;
+  unsigned int stamp;
+};
+
+/* The state of a player the values depend on. */
+struct infra_player_state {
+  struct government *government;
+  bool ai_controlled;
+  enum ai_level skill_level;
+  bv_techs techs;
+  int wonders[B_LAST];
+  unsigned int stamp;
+};
+
+static struct {
+  unsigned int stamp;           /* stamp of the last change seen */
+  int num_tiles;
+  struct infra_tile_state *tiles;
+  struct infra_player_state players[MAX_NUM_PLAYER_SLOTS];
+  int great_wonder_owners[B_LAST];
+  bool global_advances[A_LAST];
+  int minyears_reached;
+  unsigned int world_stamp;
+} infra;
+
+FC_STATIC_ASSERT(sizeof(infra.great_wonder_owners)
+                 == sizeof(game.info.great_wonder_owners),
+                 great_wonder_owners_size);
+FC_STATIC_ASSERT(sizeof(infra.global_advances)
+                 == sizeof(game.info.global_advances),
+                 global_advances_size);
+
+/* Counted by infra_minyears_count(). */
+static int minyears_reached;
+
 static int adv_calc_irrigate(const struct city *pcity,
                              const struct tile *ptile);
 static int adv_calc_mine(const struct city *pcity, const struct tile *ptile);
@@ -69,7 +141,7 @@ static int adv_calc_irrigate(const struct city *pcity,
   new_terrain = old_terrain->irrigation_result;
 
   if (new_terrain != old_terrain && new_terrain != T_NONE) {
-    struct tile *vtile;
+    struct tile vtile;
 
     if (tile_city(ptile) && terrain_has_flag(new_terrain, TER_NO_CITIES)) {
       /* Not a valid activity. */
@@ -77,38 +149,37 @@ static int adv_calc_irrigate(const struct city *pcity,
     }
     /* Irrigation would change the terrain type, clearing the mine
      * in the process.  Calculate the benefit of doing so. */
-    vtile = tile_virtual_new(ptile);
+    tile_virtual_init(&vtile, ptile);
 
-    tile_change_terrain(vtile, new_terrain);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    tile_change_terrain(&vtile, new_terrain);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
     return goodness;
   } else if (old_terrain == new_terrain
              && !tile_has_special(ptile, S_IRRIGATION)) {
     /* The tile is currently unirrigated; irrigating it would put an
      * S_IRRIGATE on it replacing any S_MINE already there.  Calculate
      * the benefit of doing so. */
-    struct tile *vtile = tile_virtual_new(ptile);
-    tile_clear_special(vtile, S_MINE);
-    tile_set_special(vtile, S_IRRIGATION);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    struct tile vtile;
+
+    tile_virtual_init(&vtile, ptile);
+    tile_clear_special(&vtile, S_MINE);
+    tile_set_special(&vtile, S_IRRIGATION);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
     /* If the player can further irrigate to make farmland, consider the
      * potentially greater benefit.  Note the hack: autosettler ordinarily
      * discounts benefits by the time it takes to make them; farmland takes
      * twice as long, so make it look half as good. */
     if (player_knows_techs_with_flag(city_owner(pcity), TF_FARMLAND)) {
       int oldv = city_tile_value(pcity, ptile, 0, 0);
-      vtile = tile_virtual_new(ptile);
-      tile_clear_special(vtile, S_MINE);
-      tile_set_special(vtile, S_IRRIGATION);
-      tile_set_special(vtile, S_FARMLAND);
-      farmland_goodness = city_tile_value(pcity, vtile, 0, 0);
+      tile_virtual_init(&vtile, ptile);
+      tile_clear_special(&vtile, S_MINE);
+      tile_set_special(&vtile, S_IRRIGATION);
+      tile_set_special(&vtile, S_FARMLAND);
+      farmland_goodness = city_tile_value(pcity, &vtile, 0, 0);
       farmland_goodness = oldv + (farmland_goodness - oldv) / 2;
       if (farmland_goodness > goodness) {
         goodness = farmland_goodness;
       }
-      tile_virtual_destroy(vtile);
     }
     return goodness;
   } else if (old_terrain == new_terrain
@@ -117,11 +188,12 @@ static int adv_calc_irrigate(const struct city *pcity,
              && player_knows_techs_with_flag(city_owner(pcity), TF_FARMLAND)) {
     /* The tile is currently irrigated; irrigating it more puts an
      * S_FARMLAND on it.  Calculate the benefit of doing so. */
-    struct tile *vtile = tile_virtual_new(ptile);
-    fc_assert(!tile_has_special(vtile, S_MINE));
-    tile_set_special(vtile, S_FARMLAND);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    struct tile vtile;
+
+    tile_virtual_init(&vtile, ptile);
+    fc_assert(!tile_has_special(&vtile, S_MINE));
+    tile_set_special(&vtile, S_FARMLAND);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
     return goodness;
   } else {
     return -1;
@@ -147,7 +219,7 @@ static int adv_calc_mine(const struct city *pcity, const struct tile *ptile)
   new_terrain = old_terrain->mining_result;
 
   if (old_terrain != new_terrain && new_terrain != T_NONE) {
-    struct tile *vtile;
+    struct tile vtile;
 
     if (tile_city(ptile) && terrain_has_flag(new_terrain, TER_NO_CITIES)) {
       /* Not a valid activity. */
@@ -155,23 +227,23 @@ static int adv_calc_mine(const struct city *pcity, const struct tile *ptile)
     }
     /* Mining would change the terrain type, clearing the irrigation
      * in the process.  Calculate the benefit of doing so. */
-    vtile = tile_virtual_new(ptile);
+    tile_virtual_init(&vtile, ptile);
 
-    tile_change_terrain(vtile, new_terrain);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    tile_change_terrain(&vtile, new_terrain);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
     return goodness;
   } else if (old_terrain == new_terrain
              && !tile_has_special(ptile, S_MINE)) {
     /* The tile is currently unmined; mining it would put an S_MINE on it
      * replacing any S_IRRIGATION/S_FARMLAND already there.  Calculate
      * the benefit of doing so. */
-    struct tile *vtile = tile_virtual_new(ptile);
-    tile_clear_special(vtile, S_IRRIGATION);
-    tile_clear_special(vtile, S_FARMLAND);
-    tile_set_special(vtile, S_MINE);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    struct tile vtile;
+
+    tile_virtual_init(&vtile, ptile);
+    tile_clear_special(&vtile, S_IRRIGATION);
+    tile_clear_special(&vtile, S_FARMLAND);
+    tile_set_special(&vtile, S_MINE);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
     return goodness;
   } else {
     return -1;
@@ -190,7 +262,7 @@ static int adv_calc_transform(const struct city *pcity,
                              const struct tile *ptile)
 {
   int goodness;
-  struct tile *vtile;
+  struct tile vtile;
   struct terrain *old_terrain, *new_terrain;
 
   fc_assert_ret_val(ptile != NULL, -1)
@@ -217,10 +289,9 @@ static int adv_calc_transform(const struct city *pcity,
     return -1;
   }
 
-  vtile = tile_virtual_new(ptile);
-  tile_change_terrain(vtile, new_terrain);
-  goodness = city_tile_value(pcity, vtile, 0, 0);
-  tile_virtual_destroy(vtile);
+  tile_virtual_init(&vtile, ptile);
+  tile_change_terrain(&vtile, new_terrain);
+  goodness = city_tile_value(pcity, &vtile, 0, 0);
 
   return goodness;
 }
@@ -237,7 +308,7 @@ static int adv_calc_pollution(const struct city *pcity,
                               const struct tile *ptile, int best)
 {
   int goodness;
-  struct tile *vtile;
+  struct tile vtile;
 
   fc_assert_ret_val(ptile != NULL, -1)
 
@@ -245,15 +316,13 @@ static int adv_calc_pollution(const struct city *pcity,
     return -1;
   }
 
-  vtile = tile_virtual_new(ptile);
-  tile_clear_special(vtile, S_POLLUTION);
-  goodness = city_tile_value(pcity, vtile, 0, 0);
+  tile_virtual_init(&vtile, ptile);
+  tile_clear_special(&vtile, S_POLLUTION);
+  goodness = city_tile_value(pcity, &vtile, 0, 0);
 
   /* FIXME: need a better way to guarantee pollution is cleaned up. */
   goodness = (goodness + best + 50) * 2;
 
-  tile_virtual_destroy(vtile);
-
   return goodness;
 }
 
@@ -269,7 +338,7 @@ static int adv_calc_fallout(const struct city *pcity,
                             const struct tile *ptile, int best)
 {
   int goodness;
-  struct tile *vtile;
+  struct tile vtile;
 
   fc_assert_ret_val(ptile != NULL, -1)
 
@@ -277,17 +346,15 @@ static int adv_calc_fallout(const struct city *pcity,
     return -1;
   }
 
-  vtile = tile_virtual_new(ptile);
-  tile_clear_special(vtile, S_FALLOUT);
-  goodness = city_tile_value(pcity, vtile, 0, 0);
+  tile_virtual_init(&vtile, ptile);
+  tile_clear_special(&vtile, S_FALLOUT);
+  goodness = city_tile_value(pcity, &vtile, 0, 0);
 
   /* FIXME: need a better way to guarantee fallout is cleaned up. */
   if (!city_owner(pcity)->ai_controlled) {
     goodness = (goodness + best + 50) * 2;
   }
 
-  tile_virtual_destroy(vtile);
-
   return goodness;
 }
 
@@ -311,11 +378,12 @@ static int adv_calc_road(const struct city *pcity, const struct tile *ptile,
   fc_assert_ret_val(ptile != NULL, -1)
 
   if (player_can_build_road(proad, city_owner(pcity), ptile)) {
-    struct tile *vtile = tile_virtual_new(ptile);
+    struct tile vtile;
 
-    tile_add_road(vtile, proad);
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    tile_virtual_init(&vtile, ptile);
+
+    tile_add_road(&vtile, proad);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
   }
 
   return goodness;
@@ -340,19 +408,20 @@ static int adv_calc_base(const struct city *pcity, const struct tile *ptile,
   fc_assert_ret_val(ptile != NULL, -1)
 
   if (player_can_build_base(pbase, city_owner(pcity), ptile)) {
-    struct tile *vtile = tile_virtual_new(ptile);
+    struct tile vtile;
+
+    tile_virtual_init(&vtile, ptile);
 
-    tile_add_base(vtile, pbase);
+    tile_add_base(&vtile, pbase);
 
     base_type_iterate(cbase) {
       if (BV_ISSET(pbase->conflicts, base_index(cbase))
-          && tile_has_base(vtile, cbase)) {
-        tile_remove_base(vtile, cbase);
+          && tile_has_base(&vtile, cbase)) {
+        tile_remove_base(&vtile, cbase);
       }
     } base_type_iterate_end;
 
-    goodness = city_tile_value(pcity, vtile, 0, 0);
-    tile_virtual_destroy(vtile);
+    goodness = city_tile_value(pcity, &vtile, 0, 0);
   }
 
   return goodness;
@@ -360,72 +429,425 @@ static int adv_calc_base(const struct city *pcity, const struct tile *ptile,
 
 /**************************************************************************
   Returns city_tile_value of the best tile worked by or available to pcity.
+  The values of the tiles must be up to date in the cache.
 **************************************************************************/
 static int best_worker_tile_value(struct city *pcity)
 {
   struct tile *pcenter = city_tile(pcity);
   int best = 0;
 
-  city_tile_iterate(city_map_radius_sq_get(pcity), pcenter, ptile) {
+  city_tile_iterate_index(city_map_radius_sq_get(pcity), pcenter, ptile,
+                          cindex) {
     if (is_free_worked(pcity, ptile)
 	|| tile_worked(ptile) == pcity /* quick test */
 	|| city_can_work_tile(pcity, ptile)) {
-      int tmp = city_tile_value(pcity, ptile, 0, 0);
+      int tmp = pcity->server.adv->act_cache[cindex].value;
 
       if (best < tmp) {
 	best = tmp;
       }
     }
-  } city_tile_iterate_end;
+  } city_tile_iterate_index_end;
 
   return best;
 }
 
+/**************************************************************************
+  Calculate all the cached values of the tile for pcity, except those of
+  cleaning up pollution and fallout, which depend on the other tiles.
+**************************************************************************/
+static void infrastructure_cache_calc(const struct city *pcity,
+                                      const struct tile *ptile,
+                                      struct worker_activity_cache *pcache)
+{
+  activity_type_iterate(act) {
+    pcache->act[act] = -1;
+  } activity_type_iterate_end;
+
+  pcache->value = city_tile_value(pcity, ptile, 0, 0);
+  pcache->act[ACTIVITY_MINE] = adv_calc_mine(pcity, ptile);
+  pcache->act[ACTIVITY_IRRIGATE] = adv_calc_irrigate(pcity, ptile);
+  pcache->act[ACTIVITY_TRANSFORM] = adv_calc_transform(pcity, ptile);
+
+  /* road_bonus() is handled dynamically later; it takes into
+   * account settlers that have already been assigned to building
+   * roads this turn. */
+  road_type_iterate(proad) {
+    pcache->road[road_index(proad)] = adv_calc_road(pcity, ptile, proad);
+  } road_type_iterate_end;
+  base_type_iterate(pbase) {
+    pcache->base[base_index(pbase)] = adv_calc_base(pcity, ptile, pbase);
+  } base_type_iterate_end;
+}
+
+#ifdef INFRACACHE_DEBUG
+/**************************************************************************
+  Check a reused entry of the cache against a fresh calculation, and
+  replace it if it was stale.
+**************************************************************************/
+static void infrastructure_cache_verify(const struct city *pcity,
+                                        const struct tile *ptile,
+                                        struct worker_activity_cache *pcache)
+{
+  struct worker_activity_cache fresh;
+  bool stale;
+
+  infrastructure_cache_calc(pcity, ptile, &fresh);
+
+  stale = (fresh.value != pcache->value);
+  activity_type_iterate(act) {
+    if (act != ACTIVITY_POLLUTION && act != ACTIVITY_FALLOUT
+        && fresh.act[act] != pcache->act[act]) {
+      stale = TRUE;
+    }
+  } activity_type_iterate_end;
+  road_type_iterate(proad) {
+    if (fresh.road[road_index(proad)] != pcache->road[road_index(proad)]) {
+      stale = TRUE;
+    }
+  } road_type_iterate_end;
+  base_type_iterate(pbase) {
+    if (fresh.base[base_index(pbase)] != pcache->base[base_index(pbase)]) {
+      stale = TRUE;
+    }
+  } base_type_iterate_end;
+
+  if (stale) {
+    log_error("Stale infrastructure cache of %s at (%d, %d).",
+              city_name(pcity), TILE_XY(ptile));
+    fresh.stamp = pcache->stamp;
+    *pcache = fresh;
+  }
+}
+#endif /* INFRACACHE_DEBUG */
+
+/**************************************************************************
+  Return TRUE if the cached values of the tile were calculated after the
+  last change of the tile and of its adjacent tiles, and not before
+  'stamp', the last change of the city, its owner and the world.
+**************************************************************************/
+static bool infrastructure_cache_valid(const struct worker_activity_cache
+                                       *pcache,
+                                       const struct tile *ptile,
+                                       unsigned int stamp)
+{
+  if (pcache->stamp == 0 || pcache->stamp < stamp
+      || pcache->stamp < infra.tiles[tile_index(ptile)].stamp) {
+    return FALSE;
+  }
+
+  adjc_iterate(ptile, adjc_tile) {
+    if (pcache->stamp < infra.tiles[tile_index(adjc_tile)].stamp) {
+      return FALSE;
+    }
+  } adjc_iterate_end;
+
+  return TRUE;
+}
+
+/**************************************************************************
+  Note the current state of the tile, and stamp it if it changed.
+**************************************************************************/
+static void infra_tile_refresh(const struct tile *ptile)
+{
+  struct infra_tile_state *pstate = &infra.tiles[tile_index(ptile)];
+  bool city = (NULL != tile_city(ptile));
+
+  if (pstate->stamp != 0
+      && pstate->terrain == tile_terrain(ptile)
+      && pstate->resource == ptile->resource
+      && BV_ARE_EQUAL(pstate->special, ptile->special)
+      && BV_ARE_EQUAL(pstate->bases, ptile->bases)
+      && BV_ARE_EQUAL(pstate->roads, ptile->roads)
+      && pstate->owner == tile_owner(ptile)
+      && pstate->city == city) {
+    return;
+  }
+
+  pstate->terrain = tile_terrain(ptile);
+  pstate->resource = ptile->resource;
+  pstate->special = ptile->special;
+  pstate->bases = ptile->bases;
+  pstate->roads = ptile->roads;
+  pstate->owner = tile_owner(ptile);
+  pstate->city = city;
+  pstate->stamp = ++infra.stamp;
+}
+
+/**************************************************************************
+  Note the current state of the player, and stamp it if it changed.
+**************************************************************************/
+static void infra_player_refresh(const struct player *pplayer)
+{
+  struct infra_player_state *pstate = &infra.players[player_index(pplayer)];
+  bv_techs techs;
+
+  BV_CLR_ALL(techs);
+  advance_index_iterate(A_FIRST, tech) {
+    if (player_invention_state(pplayer, tech) == TECH_KNOWN) {
+      BV_SET(techs, tech);
+    }
+  } advance_index_iterate_end;
+
+  if (pstate->stamp != 0
+      && pstate->government == government_of_player(pplayer)
+      && pstate->ai_controlled == pplayer->ai_controlled
+      && pstate->skill_level == pplayer->ai_common.skill_level
+      && BV_ARE_EQUAL(pstate->techs, techs)
+      && 0 == memcmp(pstate->wonders, pplayer->wonders,
+                     sizeof(pstate->wonders))) {
+    return;
+  }
+
+  pstate->government = government_of_player(pplayer);
+  pstate->ai_controlled = pplayer->ai_controlled;
+  pstate->skill_level = pplayer->ai_common.skill_level;
+  pstate->techs = techs;
+  memcpy(pstate->wonders, pplayer->wonders, sizeof(pstate->wonders));
+  pstate->stamp = ++infra.stamp;
+}
+
+/**************************************************************************
+  Note the current state of the city, and stamp it if it changed.
+**************************************************************************/
+static void infra_city_refresh(struct city *pcity)
+{
+  struct adv_city *adv = pcity->server.adv;
+  bool celebrating = city_celebrating(pcity);
+  bv_imprs improvements;
+
+  BV_CLR_ALL(improvements);
+  city_built_iterate(pcity, pimprove) {
+    BV_SET(improvements, improvement_index(pimprove));
+  } city_built_iterate_end;
+
+  if (adv->infra.stamp != 0
+      && adv->infra.owner == city_owner(pcity)
+      && adv->infra.celebrating == celebrating
+      && adv->infra.size == city_size_get(pcity)
+      && BV_ARE_EQUAL(adv->infra.improvements, improvements)) {
+    return;
+  }
+
+  adv->infra.owner = city_owner(pcity);
+  adv->infra.celebrating = celebrating;
+  adv->infra.size = city_size_get(pcity);
+  adv->infra.improvements = improvements;
+  adv->infra.stamp = ++infra.stamp;
+}
+
+/**************************************************************************
+  Count the MinYear requirements of the list the year has reached.
+**************************************************************************/
+static void infra_minyears_list_count(const struct requirement_list *reqs)
+{
+  if (reqs == NULL) {
+    return;
+  }
+
+  requirement_list_iterate(reqs, preq) {
+    if (preq->source.kind == VUT_MINYEAR
+        && game.info.year >= preq->source.value.minyear) {
+      minyears_reached++;
+    }
+  } requirement_list_iterate_end;
+}
+
+/**************************************************************************
+  Callback of iterate_effect_cache() counting the reached MinYear
+  requirements of the effect.
+**************************************************************************/
+static bool infra_minyears_effect_count(const struct effect *peffect)
+{
+  infra_minyears_list_count(peffect->reqs);
+  infra_minyears_list_count(peffect->nreqs);
+
+  return TRUE;
+}
+
+/**************************************************************************
+  Count the MinYear requirements of the effects, roads and bases the year
+  has reached. As the year is the only input of all of them, the count
+  changes exactly when one of them starts or stops being fulfilled, so
+  the values are not thrown away each turn just because the year moved.
+**************************************************************************/
+static int infra_minyears_count(void)
+{
+  minyears_reached = 0;
+
+  iterate_effect_cache(infra_minyears_effect_count);
+
+  road_type_iterate(proad) {
+    requirement_vector_iterate(&proad->reqs, preq) {
+      if (preq->source.kind == VUT_MINYEAR
+          && game.info.year >= preq->source.value.minyear) {
+        minyears_reached++;
+      }
+    } requirement_vector_iterate_end;
+  } road_type_iterate_end;
+
+  base_type_iterate(pbase) {
+    requirement_vector_iterate(&pbase->reqs, preq) {
+      if (preq->source.kind == VUT_MINYEAR
+          && game.info.year >= preq->source.value.minyear) {
+        minyears_reached++;
+      }
+    } requirement_vector_iterate_end;
+  } base_type_iterate_end;
+
+  return minyears_reached;
+}
+
+/**************************************************************************
+  Note the current state of everything the cached values of the player's
+  cities depend on. Returns the stamp the values calculated now get.
+**************************************************************************/
+static unsigned int infra_refresh(const struct player *pplayer)
+{
+  int minyears = infra_minyears_count();
+
+  if (infra.num_tiles != MAP_INDEX_SIZE) {
+    free(infra.tiles);
+    infra.num_tiles = MAP_INDEX_SIZE;
+    infra.tiles = fc_calloc(infra.num_tiles, sizeof(*infra.tiles));
+  }
+
+  if (infra.world_stamp == 0
+      || 0 != memcmp(infra.great_wonder_owners,
+                     game.info.great_wonder_owners,
+                     sizeof(infra.great_wonder_owners))
+      || 0 != memcmp(infra.global_advances, game.info.global_advances,
+                     sizeof(infra.global_advances))
+      || infra.minyears_reached != minyears) {
+    memcpy(infra.great_wonder_owners, game.info.great_wonder_owners,
+           sizeof(infra.great_wonder_owners));
+    memcpy(infra.global_advances, game.info.global_advances,
+           sizeof(infra.global_advances));
+    infra.minyears_reached = minyears;
+    infra.world_stamp = ++infra.stamp;
+  }
+
+  infra_player_refresh(pplayer);
+
+  city_list_iterate(pplayer->cities, pcity) {
+    if (pcity->server.adv->act_cache_radius_sq
+        != city_map_radius_sq_get(pcity)) {
+      /* Forgets all the values. */
+      adv_city_update(pcity);
+    }
+    infra_city_refresh(pcity);
+
+    city_tile_iterate(city_map_radius_sq_get(pcity), city_tile(pcity),
+                      ptile) {
+      infra_tile_refresh(ptile);
+      adjc_iterate(ptile, adjc_tile) {
+        infra_tile_refresh(adjc_tile);
+      } adjc_iterate_end;
+    } city_tile_iterate_end;
+  } city_list_iterate_end;
+
+  return infra.stamp;
+}
+
+/**************************************************************************
+  Free the states kept for the infrastructure cache.
+**************************************************************************/
+void free_infrastructure_cache(void)
+{
+  free(infra.tiles);
+  infra.tiles = NULL;
+  infra.num_tiles = 0;
+}
+
+/* What the jobs of initialize_infrastructure_cache() share. */
+struct infra_jobs {
+  struct city **cities;
+  unsigned int stamp;           /* stamp of the values calculated now */
+  unsigned int owner_stamp;     /* last change of the owner or the world */
+};
+
+/**************************************************************************
+  Do the tile improvement calculations of one city that are not up to
+  date. Run by fc_thread_run_jobs(), possibly on a worker thread; apart
+  from the cache of the city itself this only reads the game, the
+  improvements being tried out on virtual tiles.
+**************************************************************************/
+static void infrastructure_cache_city_job(int index, void *data)
+{
+  const struct infra_jobs *jobs = data;
+  struct city *pcity = jobs->cities[index];
+  struct worker_activity_cache *act_cache = pcity->server.adv->act_cache;
+  struct tile *pcenter = city_tile(pcity);
+  int radius_sq = city_map_radius_sq_get(pcity);
+  unsigned int stamp = MAX(jobs->owner_stamp,
+                           pcity->server.adv->infra.stamp);
+  int best;
+
+  city_tile_iterate_index(radius_sq, pcenter, ptile, cindex) {
+    struct worker_activity_cache *pcache = &act_cache[cindex];
+
+    if (!infrastructure_cache_valid(pcache, ptile, stamp)) {
+      infrastructure_cache_calc(pcity, ptile, pcache);
+      pcache->stamp = jobs->stamp;
+    } else {
+#ifdef INFRACACHE_DEBUG
+      infrastructure_cache_verify(pcity, ptile, pcache);
+#endif
+    }
+  } city_tile_iterate_index_end;
+
+  /* Cleaning up is valued against the best tile of the city, so it is
+   * calculated again every time. Tiles without pollution or fallout are
+   * quick to rule out. */
+  best = best_worker_tile_value(pcity);
+  city_tile_iterate_index(radius_sq, pcenter, ptile, cindex) {
+    act_cache[cindex].act[ACTIVITY_POLLUTION]
+      = adv_calc_pollution(pcity, ptile, best);
+    act_cache[cindex].act[ACTIVITY_FALLOUT]
+      = adv_calc_fallout(pcity, ptile, best);
+  } city_tile_iterate_index_end;
+}
+
 /**************************************************************************
   Do all tile improvement calculations and cache them for later.
 
   These values are used in settler_evaluate_improvements() so this function
   must be called before doing that.  Currently this is only done when handling
   auto-settlers or when the AI contemplates building worker units.
+
+  The values are kept from one call to the next, and only those that may
+  have changed are calculated again. The cities are calculated
+  concurrently using up to 'workerthreads' threads.
 **************************************************************************/
 void initialize_infrastructure_cache(struct player *pplayer)
 {
+  int num_cities = city_list_size(pplayer->cities);
+  struct infra_jobs jobs;
+  int i = 0;
+
+  if (num_cities == 0) {
+    return;
+  }
+
+  /* The threaded AI fills the caches of its players on its own thread,
+   * while the main thread may fill those of others. They share the
+   * states of the tiles and of the world. A change made while the values
+   * are calculated is stamped by the next refresh, so values that could
+   * have seen either state are calculated again then. */
+  fc_allocate_mutex(&game.server.mutexes.infrastructure_cache);
+  jobs.stamp = infra_refresh(pplayer);
+  jobs.owner_stamp = MAX(infra.world_stamp,
+                         infra.players[player_index(pplayer)].stamp);
+  fc_release_mutex(&game.server.mutexes.infrastructure_cache);
+
+  jobs.cities = fc_malloc(num_cities * sizeof(*jobs.cities));
   city_list_iterate(pplayer->cities, pcity) {
-    struct tile *pcenter = city_tile(pcity);
-    int radius_sq = city_map_radius_sq_get(pcity);
-    int best = best_worker_tile_value(pcity);
-
-    city_map_iterate(radius_sq, city_index, city_x, city_y) {
-      activity_type_iterate(act) {
-        adv_city_worker_act_set(pcity, city_index, act, -1);
-      } activity_type_iterate_end;
-    } city_map_iterate_end;
-
-    city_tile_iterate_index(radius_sq, pcenter, ptile, cindex) {
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_POLLUTION,
-                              adv_calc_pollution(pcity, ptile, best));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_FALLOUT,
-                              adv_calc_fallout(pcity, ptile, best));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_MINE,
-                              adv_calc_mine(pcity, ptile));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_IRRIGATE,
-                              adv_calc_irrigate(pcity, ptile));
-      adv_city_worker_act_set(pcity, cindex, ACTIVITY_TRANSFORM,
-                              adv_calc_transform(pcity, ptile));
-
-      /* road_bonus() is handled dynamically later; it takes into
-       * account settlers that have already been assigned to building
-       * roads this turn. */
-      road_type_iterate(proad) {
-        adv_city_worker_road_set(pcity, cindex, proad,
-                                 adv_calc_road(pcity, ptile, proad));
-      } road_type_iterate_end;
-      base_type_iterate(pbase) {
-        adv_city_worker_base_set(pcity, cindex, pbase,
-                                 adv_calc_base(pcity, ptile, pbase));
-      } base_type_iterate_end;
-    } city_tile_iterate_index_end;
+    jobs.cities[i++] = pcity;
   } city_list_iterate_end;
+
+  fc_thread_run_jobs(game.server.worker_threads, num_cities,
+                     infrastructure_cache_city_job, &jobs);
+  free(jobs.cities);
 }
 
 /**************************************************************************
@@ -460,6 +882,23 @@ int city_tile_value(const struct city *pcity, const struct tile *ptile,
   return value;
 }
 
+/**************************************************************************
+  Return the value of the tile 'city_tile_index' of city 'pcity' as it
+  was when the infrastructure cache was initialized, i.e. the
+  city_tile_value() the activity values are to be compared with.
+**************************************************************************/
+int adv_city_worker_value_get(const struct city *pcity, int city_tile_index)
+{
+  fc_assert_ret_val(NULL != pcity, 0);
+  fc_assert_ret_val(NULL != pcity->server.adv, 0);
+  fc_assert_ret_val(NULL != pcity->server.adv->act_cache, 0);
+  fc_assert_ret_val(pcity->server.adv->act_cache_radius_sq
+                     == city_map_radius_sq_get(pcity), 0);
+  fc_assert_ret_val(city_tile_index < city_map_tiles_from_city(pcity), 0);
+
+  return (pcity->server.adv->act_cache[city_tile_index]).value;
+}
+
 /**************************************************************************
   Set the value for activity 'doing' on tile 'city_tile_index' of
   city 'pcity'.
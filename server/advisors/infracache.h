@@ -13,6 +13,9 @@
 #ifndef FC__INFRACACHE_H
 #define FC__INFRACACHE_H
 
+/* common */
+#include "improvement.h"        /* bv_imprs */
+
 struct player;
 
 struct adv_city {
@@ -21,6 +24,16 @@ struct adv_city {
   struct worker_activity_cache *act_cache;
   int act_cache_radius_sq;
 
+  /* The state of the city the cached values depend on, and the stamp of
+   * its last change. */
+  struct {
+    const struct player *owner;
+    bool celebrating;
+    int size;
+    bv_imprs improvements;
+    unsigned int stamp;
+  } infra;
+
   /* building desirabilities - easiest to handle them here -- Syela */
   /* The units of building_want are output
    * (shields/gold/luxuries) multiplied by a priority
@@ -36,12 +49,14 @@ void adv_city_alloc(struct city *pcity);
 void adv_city_free(struct city *pcity);
 
 void initialize_infrastructure_cache(struct player *pplayer);
+void free_infrastructure_cache(void);
 
 void adv_city_update(struct city *pcity);
 
 int city_tile_value(const struct city *pcity, const struct tile *ptile,
                     int foodneed, int prodneed);
 
+int adv_city_worker_value_get(const struct city *pcity, int city_tile_index);
 void adv_city_worker_act_set(struct city *pcity, int city_tile_index,
                              enum unit_activity act_id, int value);
 int adv_city_worker_act_get(const struct city *pcity, int city_tile_index,
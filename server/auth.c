@@ -31,9 +31,6 @@
 #include "connection.h"
 #include "packets.h"
 
-/* common/scripting */
-#include "luascript_types.h"
-
 /* server */
 #include "connecthand.h"
 #include "fcdb.h"
@@ -54,11 +51,16 @@
 
 #define MAX_AUTH_TRIES 3
 #define MAX_WAIT_TIME 300   /* max time we'll wait on a password */
+#define MAX_DB_WAIT_TIME 60 /* max time we'll wait on the database */
 
 /* after each wrong guess for a password, the server waits this
  * many seconds to reply to the client */
 static const int auth_fail_wait[] = { 1, 1, 2, 3 };
 
+static void auth_user_loaded(struct connection *pconn,
+                             enum fcdb_status status, const char *password);
+static void auth_user_saved(struct connection *pconn,
+                            enum fcdb_status status, const char *password);
 static bool auth_check_password(struct connection *pconn,
                                 const char *password, int len);
 static bool is_guest_name(const char *name);
@@ -98,66 +100,104 @@ bool auth_user(struct connection *pconn, char *username)
     }
   } else {
     /* we are not a guest, we need an extra check as to whether a 
-     * connection can be established: the client must authenticate itself */
-    char buffer[MAX_LEN_MSG];
-
+     * connection can be established: the client must authenticate itself;
+     * we go on in auth_user_loaded() once the database has answered */
     sz_strlcpy(pconn->username, username);
+    pconn->server.status = AS_LOADING_USER;
+    pconn->server.auth_settime = time(NULL);
+    script_fcdb_call_async(FCDB_USER_LOAD, pconn, FALSE, auth_user_loaded);
+  }
 
-    switch(script_fcdb_call("user_load", 1, API_TYPE_CONNECTION, pconn)) {
-    case FCDB_ERROR:
-      if (srvarg.auth_allow_guests) {
-        sz_strlcpy(tmpname, pconn->username);
-        get_unique_guest_name(tmpname); /* don't pass pconn->username here */
-        sz_strlcpy(pconn->username, tmpname);
+  return TRUE;
+}
 
-        log_error("Error reading database; connection -> guest");
-        notify_conn(pconn->self, NULL, E_CONNECTION, ftc_warning,
-                    _("There was an error reading the user "
-                      "database, logging in as guest connection '%s'."),
-                    pconn->username);
-        establish_new_connection(pconn);
-      } else {
-        reject_new_connection(_("There was an error reading the user database "
-                                "and guest logins are not allowed. Sorry"),
-                              pconn);
-        log_normal(_("%s was rejected: Database error and guests not "
-                     "allowed."), pconn->username);
-        return FALSE;
-      }
-      break;
-    case FCDB_SUCCESS_TRUE:
-      /* we found a user */
-      fc_snprintf(buffer, sizeof(buffer), _("Enter password for %s:"),
+/****************************************************************************
+  Go on with the authentication of a user once the database has loaded
+  the user data: ask for the password, or reject the connection.
+****************************************************************************/
+static void auth_user_loaded(struct connection *pconn,
+                             enum fcdb_status status, const char *password)
+{
+  char tmpname[MAX_LEN_NAME] = "\0";
+  char buffer[MAX_LEN_MSG];
+
+  if (pconn->server.status != AS_LOADING_USER) {
+    return;
+  }
+
+  switch (status) {
+  case FCDB_ERROR:
+    if (srvarg.auth_allow_guests) {
+      sz_strlcpy(tmpname, pconn->username);
+      get_unique_guest_name(tmpname); /* don't pass pconn->username here */
+      sz_strlcpy(pconn->username, tmpname);
+
+      log_error("Error reading database; connection -> guest");
+      notify_conn(pconn->self, NULL, E_CONNECTION, ftc_warning,
+                  _("There was an error reading the user "
+                    "database, logging in as guest connection '%s'."),
                   pconn->username);
-      dsend_packet_authentication_req(pconn, AUTH_LOGIN_FIRST, buffer);
+      establish_new_connection(pconn);
+    } else {
+      pconn->server.status = AS_NOT_ESTABLISHED;
+      reject_new_connection(_("There was an error reading the user database "
+                              "and guest logins are not allowed. Sorry"),
+                            pconn);
+      log_normal(_("%s was rejected: Database error and guests not "
+                   "allowed."), pconn->username);
+      connection_close_server(pconn, _("auth failed"));
+    }
+    break;
+  case FCDB_SUCCESS_TRUE:
+    /* we found a user */
+    sz_strlcpy(pconn->server.password, password);
+    fc_snprintf(buffer, sizeof(buffer), _("Enter password for %s:"),
+                pconn->username);
+    dsend_packet_authentication_req(pconn, AUTH_LOGIN_FIRST, buffer);
+    pconn->server.auth_settime = time(NULL);
+    pconn->server.status = AS_REQUESTING_OLD_PASS;
+    break;
+  case FCDB_SUCCESS_FALSE:
+    /* we couldn't find the user, he is new */
+    if (srvarg.auth_allow_newusers) {
+      /* TRANS: Try not to make the translation much longer than the original. */
+      sz_strlcpy(buffer, _("First time login. Set a new password and confirm it."));
+      dsend_packet_authentication_req(pconn, AUTH_NEWUSER_FIRST, buffer);
       pconn->server.auth_settime = time(NULL);
-      pconn->server.status = AS_REQUESTING_OLD_PASS;
-      break;
-    case FCDB_SUCCESS_FALSE:
-      /* we couldn't find the user, he is new */
-      if (srvarg.auth_allow_newusers) {
-        /* TRANS: Try not to make the translation much longer than the original. */
-        sz_strlcpy(buffer, _("First time login. Set a new password and confirm it."));
-        dsend_packet_authentication_req(pconn, AUTH_NEWUSER_FIRST, buffer);
-        pconn->server.auth_settime = time(NULL);
-        pconn->server.status = AS_REQUESTING_NEW_PASS;
-      } else {
-        reject_new_connection(_("This server allows only preregistered "
-                                "users. Sorry."), pconn);
-        log_normal(_("%s was rejected: Only preregistered users allowed."),
-                   pconn->username);
-
-        return FALSE;
-      }
-      break;
-    default:
-      fc_assert(FALSE);
-      break;
+      pconn->server.status = AS_REQUESTING_NEW_PASS;
+    } else {
+      pconn->server.status = AS_NOT_ESTABLISHED;
+      reject_new_connection(_("This server allows only preregistered "
+                              "users. Sorry."), pconn);
+      log_normal(_("%s was rejected: Only preregistered users allowed."),
+                 pconn->username);
+      connection_close_server(pconn, _("auth failed"));
     }
-    return TRUE;
+    break;
+  default:
+    fc_assert(FALSE);
+    break;
   }
+}
 
-  return TRUE;
+/****************************************************************************
+  Establish the connection of a new user once the database has saved it.
+****************************************************************************/
+static void auth_user_saved(struct connection *pconn,
+                            enum fcdb_status status, const char *password)
+{
+  if (pconn->server.status != AS_SAVING_USER) {
+    return;
+  }
+
+  if (status != FCDB_SUCCESS_TRUE) {
+    notify_conn(pconn->self, NULL, E_CONNECTION, ftc_warning,
+                _("Warning: There was an error in saving to the database. "
+                  "Continuing, but your stats will not be saved."));
+    log_error("Error writing to database for: %s", pconn->username);
+  }
+
+  establish_new_connection(pconn);
 }
 
 /****************************************************************************
@@ -184,19 +224,13 @@ bool auth_handle_reply(struct connection *pconn, char *password)
     }
 
     /* the new password is good, create a database entry for
-     * this user; we establish the connection in handle_db_lookup */
+     * this user; we establish the connection in auth_user_saved() */
     create_md5sum((unsigned char *)password, strlen(password),
                   pconn->server.password);
 
-    if (script_fcdb_call("user_save", 1, API_TYPE_CONNECTION, pconn)
-        != FCDB_SUCCESS_TRUE) {
-      notify_conn(pconn->self, NULL, E_CONNECTION, ftc_warning,
-                  _("Warning: There was an error in saving to the database. "
-                    "Continuing, but your stats will not be saved."));
-      log_error("Error writing to database for: %s", pconn->username);
-    }
-
-    establish_new_connection(pconn);
+    pconn->server.status = AS_SAVING_USER;
+    pconn->server.auth_settime = time(NULL);
+    script_fcdb_call_async(FCDB_USER_SAVE, pconn, FALSE, auth_user_saved);
   } else if (pconn->server.status == AS_REQUESTING_OLD_PASS) {
     if (auth_check_password(pconn, password, strlen(password)) == 1) {
       establish_new_connection(pconn);
@@ -257,6 +291,19 @@ void auth_process_status(struct connection *pconn)
       connection_close_server(pconn, _("auth failed"));
     }
     break;
+  case AS_LOADING_USER:
+  case AS_SAVING_USER:
+    /* waiting on the database; auth_user_loaded() or auth_user_saved()
+     * will go on... don't wait too long, a late answer is dropped */
+    if (time(NULL) >= pconn->server.auth_settime + MAX_DB_WAIT_TIME) {
+      pconn->server.status = AS_NOT_ESTABLISHED;
+      reject_new_connection(_("Sorry, the user database did not answer "
+                              "in time..."), pconn);
+      log_normal(_("%s was rejected: Timeout waiting for the user "
+                   "database."), pconn->username);
+      connection_close_server(pconn, _("auth failed"));
+    }
+    break;
   case AS_ESTABLISHED:
     /* this better fail bigtime */
     fc_assert(pconn->server.status != AS_ESTABLISHED);
@@ -279,8 +326,7 @@ static bool auth_check_password(struct connection *pconn,
   ok = (strncmp(checksum, pconn->server.password, MD5_HEX_BYTES) == 0)
                                                               ? TRUE : FALSE;
 
-  script_fcdb_call("user_log", 2, API_TYPE_CONNECTION, pconn, API_TYPE_BOOL,
-                   ok);
+  script_fcdb_call_async(FCDB_USER_LOG, pconn, ok, NULL);
 
   return ok;
 }
@@ -25,6 +25,9 @@
 #include "rand.h"
 #include "support.h"
 
+/* common/aicore */
+#include "cm.h"
+
 /* common */
 #include "city.h"
 #include "events.h"
@@ -247,6 +250,62 @@ void handle_city_make_worker(struct player *pplayer, int city_id,
   sync_cities();
 }
 
+/**************************************************************************
+  Handle request to set all workers and specialists of a city at once.
+  The arrangement is checked and applied as a whole by
+  apply_cmresult_to_city(), the same way auto_arrange_workers() does, and
+  the city is refreshed only once.
+**************************************************************************/
+void handle_city_arrange_workers(struct player *pplayer,
+                                 const struct packet_city_arrange_workers
+                                 *packet)
+{
+  struct city *pcity = player_city_by_number(pplayer, packet->city_id);
+  struct cm_result *cmr;
+  bool valid;
+  int i;
+
+  if (NULL == pcity) {
+    /* Probably lost. */
+    log_verbose("handle_city_arrange_workers() bad city number %d.",
+                packet->city_id);
+    return;
+  }
+
+  cmr = cm_result_new(pcity);
+  valid = (packet->city_radius_sq == cmr->city_radius_sq
+           && packet->specialists_size == specialist_count());
+
+  for (i = 0; valid && i < packet->workers_count; i++) {
+    if (packet->workers[i] < city_map_tiles(cmr->city_radius_sq)) {
+      cmr->worker_positions[packet->workers[i]] = TRUE;
+    } else {
+      valid = FALSE;
+    }
+  }
+
+  if (valid) {
+    specialist_type_iterate(sp) {
+      cmr->specialists[sp] = packet->specialists[sp];
+    } specialist_type_iterate_end;
+
+    valid = apply_cmresult_to_city(pcity, cmr);
+  }
+  cm_result_destroy(cmr);
+
+  if (!valid) {
+    /* The city probably changed since the client computed this. */
+    log_verbose("handle_city_arrange_workers() arrangement does not fit "
+                "\"%s\".", city_name(pcity));
+  }
+
+  city_refresh(pcity);
+  sanity_check_city(pcity);
+  /* Always answer with the city, so the client knows the result. */
+  send_city_info(pplayer, pcity);
+  sync_cities();
+}
+
 /**************************************************************************
   Handle improvement selling request. Caller is responsible to validate
   input before passing to this function if it comes from untrusted source.
@@ -33,6 +33,7 @@
 #include "base.h"
 #include "citizens.h"
 #include "city.h"
+#include "cityindex.h"
 #include "events.h"
 #include "game.h"
 #include "government.h"
@@ -84,10 +85,18 @@
 /* Queue for pending auto_arrange_workers() */
 static struct city_list *arrange_workers_queue = NULL;
 
-/* Suppress sending cities during game_load() and end_phase() */
+/* Defer sending cities during game_load(), turn processing and packet
+ * handling */
 static bool send_city_suppressed = FALSE;
 
+/* Cities whose info is to be sent when the suppression ends */
+static struct city_list *city_info_queue = NULL;
+
+/* Set when sync_cities() was called while sending cities was suppressed */
+static bool sync_cities_deferred = FALSE;
+
 static bool city_workers_queue_remove(struct city *pcity);
+static void city_info_queue_remove(struct city *pcity);
 
 static void announce_trade_route_removal(struct city *pc1, struct city *pc2,
                                          bool source_gone);
@@ -822,6 +831,52 @@ void transfer_city_units(struct player *pplayer, struct player *pvictim,
 #endif /* DEBUG */
 }
 
+/* The restrictions of find_closest_city(). */
+struct closest_city_filter {
+  const struct city *pexclcity;
+  const struct player *pplayer;
+  Continent_id con;
+  bool only_ocean;
+  bool only_continent;
+  bool only_known;
+  bool only_player;
+  bool only_enemy;
+  const struct unit_class *pclass;
+};
+
+/****************************************************************************
+  Return TRUE if the city meets the restrictions of find_closest_city().
+****************************************************************************/
+static bool closest_city_filter_test(const struct city *pcity,
+                                     const void *data)
+{
+  const struct closest_city_filter *filter = data;
+  const struct player *pplayer = filter->pplayer;
+  const struct player *aplayer = city_owner(pcity);
+
+  /* - not the excluded city
+   * - (if required) only cities of player 'pplayer'
+   * - (if required) only cities of players at war with player 'pplayer'
+   * - (if required) on the same continent
+   * - (if required) adjacent to ocean
+   * - (if required) only cities known by the player
+   * - (if required) only cities native to the class */
+  return (pcity != filter->pexclcity
+          && (pplayer == NULL || !filter->only_player || pplayer == aplayer)
+          && (pplayer == NULL || !filter->only_enemy
+              || pplayers_at_war(pplayer, aplayer))
+          && (!filter->only_continent
+              || filter->con == tile_continent(city_tile(pcity)))
+          && (!filter->only_ocean
+              || is_terrain_class_near_tile(city_tile(pcity), TC_OCEAN))
+          && (!filter->only_known
+              || (map_is_known(city_tile(pcity), pplayer)
+                  && map_get_player_site(city_tile(pcity), pplayer)->identity
+                     > IDENTITY_NUMBER_ZERO))
+          && (filter->pclass == NULL
+              || is_native_near_tile(filter->pclass, city_tile(pcity))));
+}
+
 /****************************************************************************
   Find the city closest to 'ptile'. Some restrictions can be applied:
 
@@ -848,9 +903,7 @@ struct city *find_closest_city(const struct tile *ptile,
                                bool only_known, bool only_player,
                                bool only_enemy, const struct unit_class *pclass)
 {
-  Continent_id con;
-  struct city *best_city = NULL;
-  int best_dist = -1;
+  struct closest_city_filter filter;
 
   fc_assert_ret_val(ptile != NULL, NULL);
 
@@ -859,52 +912,17 @@ struct city *find_closest_city(const struct tile *ptile,
     return NULL;
   }
 
-  con = tile_continent(ptile);
-
-  players_iterate(aplayer) {
-    if (pplayer != NULL && only_player && pplayer != aplayer) {
-      /* only cities of player 'pplayer' */
-      continue;
-    }
-
-    if (pplayer != NULL && only_enemy
-        && !pplayers_at_war(pplayer, aplayer)) {
-      /* only cities of players at war with player 'pplayer' */
-      continue;
-    }
-
-    city_list_iterate(aplayer->cities, pcity) {
-      int city_dist;
+  filter.pexclcity = pexclcity;
+  filter.pplayer = pplayer;
+  filter.con = tile_continent(ptile);
+  filter.only_ocean = only_ocean;
+  filter.only_continent = only_continent;
+  filter.only_known = only_known;
+  filter.only_player = only_player;
+  filter.only_enemy = only_enemy;
+  filter.pclass = pclass;
 
-      if (pexclcity && pexclcity == pcity) {
-        /* not this city */
-        continue;
-      }
-
-      city_dist = real_map_distance(ptile, city_tile(pcity));
-
-      /* Find the closest city matching the requirements.
-       * - closer than the current best city
-       * - (if required) on the same continent
-       * - (if required) adjacent to ocean
-       * - (if required) only cities known by the player
-       * - (if required) only cities native to the class */
-      if ((best_dist == -1 || city_dist < best_dist)
-          && (!only_continent || con == tile_continent(pcity->tile))
-          && (!only_ocean || is_terrain_class_near_tile(city_tile(pcity), TC_OCEAN))
-          && (!only_known
-              || (map_is_known(city_tile(pcity), pplayer)
-                  && map_get_player_site(city_tile(pcity), pplayer)->identity
-                     > IDENTITY_NUMBER_ZERO))
-          && (pclass == NULL
-              || is_native_near_tile(pclass, city_tile(pcity)))) {
-        best_dist = city_dist;
-        best_city = pcity;
-      }
-    } city_list_iterate_end;
-  } players_iterate_end;
-
-  return best_city;
+  return cityindex_closest(ptile, closest_city_filter_test, &filter);
 }
 
 /**************************************************************************
@@ -1301,8 +1319,12 @@ bool transfer_city(struct player *ptaker, struct city *pcity,
     /* Send city with updated owner information to giver and to everyone
      * having shared vision pact with him/her before (s)he may
      * lose vision to it. When we later send info to everybody seeing the city,
-     * (s)he may not be included. */
+     * (s)he may not be included. This can't wait for the end of a
+     * suppression of sending cities. */
+    bool was_send_city_suppressed = send_city_suppression(FALSE);
+
     send_city_info(NULL, pcity);
+    send_city_suppression(was_send_city_suppressed);
   }
 
   /* Remove the sight points from the giver. */
@@ -1627,6 +1649,7 @@ void remove_city(struct city *pcity)
   const citizens old_angry_citizens = player_angry_citizens(powner);
   struct dbv tile_processed;
   struct tile_list *process_queue;
+  bv_player seen;
   const char *ctl = city_tile_link(pcity);
 
   BV_CLR_ALL(had_small_wonders);
@@ -1753,6 +1776,7 @@ void remove_city(struct city *pcity)
 
   map_clear_border(pcenter);
   city_workers_queue_remove(pcity);
+  city_info_queue_remove(pcity);
   city_thaw_workers_queue();
   city_refresh_queue_processing();
 
@@ -1804,11 +1828,10 @@ void remove_city(struct city *pcity)
     }
   } base_type_iterate_end;
 
-  players_iterate(other_player) {
-    if (map_is_known_and_seen(pcenter, other_player, V_MAIN)) {
-      reality_check_city(other_player, pcenter);
-    }
-  } players_iterate_end;
+  map_get_seen_players(pcenter, V_MAIN, &seen);
+  players_in_bv_iterate(seen, other_player) {
+    reality_check_city(other_player, pcenter);
+  } players_in_bv_iterate_end;
 
   conn_list_iterate(game.est_connections, pconn) {
     if (NULL == pconn->playing && pconn->observer) {
@@ -2011,29 +2034,92 @@ void unit_enter_city(struct unit *punit, struct city *pcity, bool passenger)
 }
 
 /**************************************************************************
-  Returns true if the player owns a city which has a trade route with
-  the given city.
+  Fill 'viewers' with the players who get the short info of the city:
+  those seeing the city tile and those owning a city which has a trade
+  route with it.
 **************************************************************************/
-static bool player_has_trade_route_with_city(struct player *pplayer,
-                                             struct city *pcity)
+static void city_short_info_viewers(struct city *pcity, bv_player *viewers)
 {
+  map_get_seen_players(pcity->tile, V_MAIN, viewers);
   trade_routes_iterate(pcity, other) {
-    if (city_owner(other) == pplayer) {
-      return TRUE;
-    }
+    BV_SET(*viewers, player_index(city_owner(other)));
   } trade_routes_iterate_end;
+}
 
-  return FALSE;
+/**************************************************************************
+  Add the city to the queue of city infos to send later. If broadcast is
+  set, the info will go to everyone seeing the city, else to the owner.
+**************************************************************************/
+static void city_info_queue_add(struct city *pcity, bool broadcast)
+{
+  if (!pcity->server.info_queued) {
+    if (NULL == city_info_queue) {
+      city_info_queue = city_list_new();
+    }
+    city_list_append(city_info_queue, pcity);
+    pcity->server.info_queued = TRUE;
+  }
+
+  if (broadcast) {
+    pcity->server.info_broadcast = TRUE;
+  }
 }
 
 /**************************************************************************
-  Suppress sending cities during game_load() and end_phase()
+  Remove a city from the queue of city infos to send later.
+**************************************************************************/
+static void city_info_queue_remove(struct city *pcity)
+{
+  if (pcity->server.info_queued) {
+    city_list_remove(city_info_queue, pcity);
+    pcity->server.info_queued = FALSE;
+    pcity->server.info_broadcast = FALSE;
+  }
+}
+
+/**************************************************************************
+  Send the info of each queued city once.
+**************************************************************************/
+static void city_info_queue_processing(void)
+{
+  struct city_list *queue = city_info_queue;
+
+  if (NULL == queue) {
+    return;
+  }
+
+  city_info_queue = NULL;
+  city_list_iterate(queue, pcity) {
+    bool broadcast = pcity->server.info_broadcast;
+
+    pcity->server.info_queued = FALSE;
+    pcity->server.info_broadcast = FALSE;
+    send_city_info(broadcast ? NULL : city_owner(pcity), pcity);
+  } city_list_iterate_end;
+  city_list_destroy(queue);
+}
+
+/**************************************************************************
+  Suppress sending cities during game_load(), turn processing and packet
+  handling. While suppressed, send_city_info() only queues the city, so
+  a city changed several times is packaged and sent once, when the
+  suppression ends. The sync_cities() calls made meanwhile are also done
+  then, once. Returns the former state, to restore it afterwards.
 **************************************************************************/
 bool send_city_suppression(bool now)
 {
   bool formerly = send_city_suppressed;
 
   send_city_suppressed = now;
+
+  if (formerly && !now) {
+    city_info_queue_processing();
+    if (sync_cities_deferred) {
+      sync_cities_deferred = FALSE;
+      sync_cities();
+    }
+  }
+
   return formerly;
 }
 
@@ -2069,21 +2155,21 @@ static void package_dumb_city(struct player* pplayer, struct tile *ptile,
 **************************************************************************/
 void refresh_dumb_city(struct city *pcity)
 {
-  players_iterate(pplayer) {
-    if (map_is_known_and_seen(pcity->tile, pplayer, V_MAIN)
-        || player_has_trade_route_with_city(pplayer, pcity)) {
-      if (update_dumb_city(pplayer, pcity)) {
-	struct packet_city_short_info packet;
-
-	if (city_owner(pcity) != pplayer) {
-	  /* Don't send the short_city information to someone who can see the
-	   * city's internals.  Doing so would really confuse the client. */
-	  package_dumb_city(pplayer, pcity->tile, &packet);
-	  lsend_packet_city_short_info(pplayer->connections, &packet);
-	}
+  bv_player viewers;
+
+  city_short_info_viewers(pcity, &viewers);
+  players_in_bv_iterate(viewers, pplayer) {
+    if (update_dumb_city(pplayer, pcity)) {
+      struct packet_city_short_info packet;
+
+      if (city_owner(pcity) != pplayer) {
+        /* Don't send the short_city information to someone who can see the
+         * city's internals.  Doing so would really confuse the client. */
+        package_dumb_city(pplayer, pcity->tile, &packet);
+        lsend_packet_city_short_info(pplayer->connections, &packet);
       }
     }
-  } players_iterate_end;
+  } players_in_bv_iterate_end;
 
   /* Don't send to non-player observers since they don't have 'dumb city'
    * information. */
@@ -2102,25 +2188,24 @@ static void broadcast_city_info(struct city *pcity)
   struct packet_city_info packet;
   struct packet_city_short_info sc_pack;
   struct player *powner = city_owner(pcity);
+  bv_player viewers;
 
-  /* Send to everyone who can see the city. */
+  /* Send to everyone who can see the city. Only the players seeing it
+   * or trading with it are visited, in player order as before. */
+  city_short_info_viewers(pcity, &viewers);
+  BV_SET(viewers, player_index(powner));
   package_city(pcity, &packet, FALSE);
-  players_iterate(pplayer) {
+  players_in_bv_iterate(viewers, pplayer) {
     if (can_player_see_city_internals(pplayer, pcity)) {
-      if (!send_city_suppressed || pplayer != powner) {
-        update_dumb_city(powner, pcity);
-        lsend_packet_city_info(powner->connections, &packet, FALSE);
-      }
+      update_dumb_city(powner, pcity);
+      lsend_packet_city_info(powner->connections, &packet, FALSE);
     } else {
-      if (map_is_known_and_seen(pcity->tile, pplayer, V_MAIN)
-          || player_has_trade_route_with_city(pplayer, pcity)) {
-        reality_check_city(pplayer, pcity->tile);
-	update_dumb_city(pplayer, pcity);
-	package_dumb_city(pplayer, pcity->tile, &sc_pack);
-	lsend_packet_city_short_info(pplayer->connections, &sc_pack);
-      }
+      reality_check_city(pplayer, pcity->tile);
+      update_dumb_city(pplayer, pcity);
+      package_dumb_city(pplayer, pcity->tile, &sc_pack);
+      lsend_packet_city_short_info(pplayer->connections, &sc_pack);
     }
-  } players_iterate_end;
+  } players_in_bv_iterate_end;
 
   /* Send to global observers. */
   conn_list_iterate(game.est_connections, pconn) {
@@ -2185,7 +2270,8 @@ void send_city_info(struct player *dest, struct city *pcity)
     return;
   }
 
-  if (dest == powner && send_city_suppressed) {
+  if (send_city_suppressed && (NULL == dest || dest == powner)) {
+    city_info_queue_add(pcity, NULL == dest);
     return;
   }
 
@@ -2242,7 +2328,9 @@ void send_city_info_at_tile(struct player *pviewer, struct conn_list *dest,
   if (powner && powner == pviewer) {
     /* send info to owner */
     /* This case implies powner non-NULL which means pcity non-NULL */
-    if (!send_city_suppressed) {
+    if (send_city_suppressed) {
+      city_info_queue_add(pcity, FALSE);
+    } else {
       /* send all info to the owner */
       update_dumb_city(powner, pcity);
       package_city(pcity, &packet, FALSE);
@@ -2930,6 +3018,8 @@ bool city_map_update_tile_now(struct tile *ptile)
 void sync_cities(void)
 {
   if (send_city_suppressed) {
+    /* Done when the suppression ends. */
+    sync_cities_deferred = TRUE;
     return;
   }
 
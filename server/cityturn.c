@@ -21,7 +21,9 @@
 #include <math.h> /* exp, sqrt */
 
 /* utility */
+#include "bitvector.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "rand.h"
@@ -35,6 +37,7 @@
 #include "borders.h"
 #include "citizens.h"
 #include "city.h"
+#include "cityindex.h"
 #include "events.h"
 #include "disaster.h"
 #include "game.h"
@@ -132,8 +135,15 @@ static void nullify_caravan_and_disband_plus(struct city *pcity);
 static bool city_illness_check(const struct city * pcity);
 
 static float city_migration_score(struct city *pcity);
+static void city_migration_score_job(int index, void *data);
+static bool city_migration_source(const struct city *pcity);
+static int city_migration_max_dist(const struct city *acity);
 static bool do_city_migration(struct city *pcity_from,
                               struct city *pcity_to);
+static bool city_migration_better(const struct city *pcity,
+                                  const struct city *acity, float score,
+                                  const struct city *best_city,
+                                  float best_score);
 static bool check_city_migrations_player(const struct player *pplayer);
 
 /**************************************************************************
@@ -145,6 +155,8 @@ bool city_refresh(struct city *pcity)
   bool retval;
 
   pcity->server.needs_refresh = FALSE;
+  /* The migration score has to be calculated again. */
+  pcity->server.mgr_score_calc_turn = -1;
 
   retval = city_map_update_radius_sq(pcity);
   city_units_upkeep(pcity); /* update unit upkeep */
@@ -258,14 +270,58 @@ void remove_obsolete_buildings(struct player *pplayer)
 }
 
 /**************************************************************************
-  Rearrange workers according to a cm_result struct.  The caller must make
-  sure that the result is valid.
+  Return TRUE iff the cm_result struct can be applied to the city: it is
+  for the current city radius, it places every citizen, and the tiles and
+  specialists it uses are available to the city.
 **************************************************************************/
-void apply_cmresult_to_city(struct city *pcity,
+static bool cmresult_fits_city(struct city *pcity,
+                               const struct cm_result *cmr)
+{
+  struct tile *pcenter = city_tile(pcity);
+  int city_radius_sq = city_map_radius_sq_get(pcity);
+  int placed = 0;
+
+  if (cmr->city_radius_sq != city_radius_sq) {
+    return FALSE;
+  }
+
+  city_tile_iterate_skip_free_worked(city_radius_sq, pcenter,
+                                     ptile, index, x, y) {
+    if (cmr->worker_positions[index]) {
+      if (tile_worked(ptile) != pcity && !city_can_work_tile(pcity, ptile)) {
+        return FALSE;
+      }
+      placed++;
+    }
+  } city_tile_iterate_skip_free_worked_end;
+
+  specialist_type_iterate(sp) {
+    if (cmr->specialists[sp] > 0 && !city_can_use_specialist(pcity, sp)) {
+      return FALSE;
+    }
+    placed += cmr->specialists[sp];
+  } specialist_type_iterate_end;
+
+  return placed == city_size_get(pcity);
+}
+
+/**************************************************************************
+  Rearrange workers according to a cm_result struct.  The result is
+  checked first; if it does not fit the city, nothing is changed and
+  FALSE is returned.  The caller has to refresh the city afterwards.
+
+  This is used both by auto_arrange_workers() and for the arrangements
+  the client's city governor sends.
+**************************************************************************/
+bool apply_cmresult_to_city(struct city *pcity,
                             const struct cm_result *cmr)
 {
   struct tile *pcenter = city_tile(pcity);
 
+  if (!cmresult_fits_city(pcity, cmr)) {
+    return FALSE;
+  }
+
   /* Now apply results */
   city_tile_iterate_skip_free_worked(city_map_radius_sq_get(pcity), pcenter,
                                      ptile, index, x, y) {
@@ -287,6 +343,8 @@ void apply_cmresult_to_city(struct city *pcity,
   specialist_type_iterate(sp) {
     pcity->specialists[sp] = cmr->specialists[sp];
   } specialist_type_iterate_end;
+
+  return TRUE;
 }
 
 /**************************************************************************
@@ -387,7 +445,10 @@ void auto_arrange_workers(struct city *pcity)
   }
   fc_assert_ret(cmr->found_a_valid);
 
-  apply_cmresult_to_city(pcity, cmr);
+  if (!apply_cmresult_to_city(pcity, cmr)) {
+    log_error("%s: the arrangement found does not fit the city.",
+              city_name(pcity));
+  }
 
   if (pcity->server.debug) {
     /* Print debug output if requested. */
@@ -2644,6 +2705,9 @@ static bool disband_city(struct city *pcity)
   * if the city has at least one wonder a factor of 1.25 is added
   * for the capital an additional factor of 1.25 is used
   * the score is also modified by the effect EFT_MIGRATION_PCT
+
+  The score is kept for the rest of the turn, or until city_refresh() is
+  called for the city.
 **************************************************************************/
 static float city_migration_score(struct city *pcity)
 {
@@ -2720,6 +2784,19 @@ static float city_migration_score(struct city *pcity)
   return score;
 }
 
+/**************************************************************************
+  Calculate the migration score of one city. Run by fc_thread_run_jobs(),
+  possibly on a worker thread; city_migration_score() only reads the game
+  apart from the score of the city itself, and the requirement cache is
+  not used while the jobs run.
+**************************************************************************/
+static void city_migration_score_job(int index, void *data)
+{
+  struct city **cities = data;
+
+  city_migration_score(cities[index]);
+}
+
 /**************************************************************************
   Do the migrations between the cities that overlap, if the growth of the
   target city is not blocked due to a missing improvement or missing food.
@@ -2954,6 +3031,9 @@ static bool do_city_migration(struct city *pcity_from,
 bool check_city_migrations(void)
 {
   bool internat = FALSE;
+  struct city **cities;
+  struct dbv queued;
+  int num_cities;
 
   if (!game.server.migration) {
     return FALSE;
@@ -2965,6 +3045,44 @@ bool check_city_migrations(void)
     return FALSE;
   }
 
+  /* Calculate up front the migration scores of the cities which may
+   * migrate this turn and of the cities they may migrate to; each score is
+   * kept for the rest of the turn unless the city is refreshed. A city is
+   * queued only once, so that no two jobs write the same city. */
+  num_cities = 0;
+  players_iterate(pplayer) {
+    num_cities += city_list_size(pplayer->cities);
+  } players_iterate_end;
+  cities = fc_malloc(MAX(num_cities, 1) * sizeof(*cities));
+  dbv_init(&queued, MAP_INDEX_SIZE);
+  num_cities = 0;
+  players_iterate(pplayer) {
+    city_list_iterate(pplayer->cities, pcity) {
+      if (!city_migration_source(pcity)) {
+        continue;
+      }
+
+      cityindex_range_iterate(city_tile(pcity), CITY_MAP_MAX_RADIUS
+                                                + GAME_MAX_MGR_DISTANCE,
+                              acity) {
+        int tindex = tile_index(city_tile(acity));
+
+        if (dbv_isset(&queued, tindex)
+            || (acity != pcity
+                && real_map_distance(city_tile(pcity), city_tile(acity))
+                   > city_migration_max_dist(acity))) {
+          continue;
+        }
+        dbv_set(&queued, tindex);
+        cities[num_cities++] = acity;
+      } cityindex_range_iterate_end;
+    } city_list_iterate_end;
+  } players_iterate_end;
+  fc_thread_run_jobs(game.server.worker_threads, num_cities,
+                     city_migration_score_job, cities);
+  dbv_free(&queued);
+  free(cities);
+
   /* check for migration */
   players_iterate(pplayer) {
     if (!pplayer->cities) {
@@ -3108,11 +3226,66 @@ void check_disasters(void)
   } players_iterate_end;
 }
 
+/**************************************************************************
+  Return TRUE if citizens may migrate out of the city this turn.
+**************************************************************************/
+static bool city_migration_source(const struct city *pcity)
+{
+  /* no migration out of the capital */
+  if (is_capital(pcity)) {
+    return FALSE;
+  }
+
+  /* check only each (game.server.mgr_turninterval) turn
+   * (counted from the funding turn) and do not migrate
+   * the same turn a city is founded */
+  return (game.info.turn != pcity->turn_founded
+          && ((game.info.turn - pcity->turn_founded)
+              % game.server.mgr_turninterval) == 0);
+}
+
+/**************************************************************************
+  Return the distance from which citizens may migrate to 'acity'. The
+  value of game.server.mgr_distance is added to the current city radius.
+**************************************************************************/
+static int city_migration_max_dist(const struct city *acity)
+{
+  return ((int)sqrt((double)MAX(city_map_radius_sq_get(acity),0))
+          + game.server.mgr_distance);
+}
+
+/**************************************************************************
+  Return TRUE if 'acity' with the score 'score' is a better migration
+  target for 'pcity' than 'best_city' with the score 'best_score'. Of the
+  cities with the same score, the nearest one and then the one on the
+  lowest tile index is chosen, so the choice does not depend on the order
+  the city index gives the cities in.
+**************************************************************************/
+static bool city_migration_better(const struct city *pcity,
+                                  const struct city *acity, float score,
+                                  const struct city *best_city,
+                                  float best_score)
+{
+  int dist, best_dist;
+
+  if (score != best_score || NULL == best_city) {
+    return score > best_score;
+  }
+
+  dist = real_map_distance(city_tile(pcity), city_tile(acity));
+  best_dist = real_map_distance(city_tile(pcity), city_tile(best_city));
+  if (dist != best_dist) {
+    return dist < best_dist;
+  }
+
+  return tile_index(city_tile(acity)) < tile_index(city_tile(best_city));
+}
+
 /**************************************************************************
   Check for migration for each city of one player.
 
   For each city of the player do:
-  * check each tile within GAME_MAX_MGR_DISTANCE for a city
+  * look up the cities within GAME_MAX_MGR_DISTANCE in the city index
   * if a city is found check the distance
   * compare the migration score
 **************************************************************************/
@@ -3120,7 +3293,7 @@ static bool check_city_migrations_player(const struct player *pplayer)
 {
   char city_link_text[MAX_LEN_LINK];
   float best_city_player_score, best_city_world_score;
-  struct city *best_city_player, *best_city_world, *acity;
+  struct city *best_city_player, *best_city_world;
   float score_from, score_tmp, weight;
   int dist, mgr_dist;
   bool internat = FALSE;
@@ -3129,17 +3302,7 @@ static bool check_city_migrations_player(const struct player *pplayer)
    * city_list_iterate_safe_end must be used because we could
    * remove one city from the list */
   city_list_iterate_safe(pplayer->cities, pcity) {
-    /* no migration out of the capital */
-    if (is_capital(pcity)) {
-      continue;
-    }
-
-    /* check only each (game.server.mgr_turninterval) turn
-     * (counted from the funding turn) and do not migrate
-     * the same turn a city is founded */
-    if (game.info.turn == pcity->turn_founded
-        || ((game.info.turn - pcity->turn_founded)
-            % game.server.mgr_turninterval) != 0) {
+    if (!city_migration_source(pcity)) {
       continue;
     }
 
@@ -3158,21 +3321,17 @@ static bool check_city_migrations_player(const struct player *pplayer)
 
     /* consider all cities within the maximal possible distance
      * (= CITY_MAP_MAX_RADIUS + GAME_MAX_MGR_DISTANCE) */
-    iterate_outward(city_tile(pcity), CITY_MAP_MAX_RADIUS
-                                      + GAME_MAX_MGR_DISTANCE, ptile) {
-      acity = tile_city(ptile);
-
-      if (!acity || acity == pcity) {
-        /* no city or the city in the center */
+    cityindex_range_iterate(city_tile(pcity), CITY_MAP_MAX_RADIUS
+                                              + GAME_MAX_MGR_DISTANCE,
+                            acity) {
+      if (acity == pcity) {
+        /* the city in the center */
         continue;
       }
 
-      /* Calculate the migration distance. The value of
-       * game.server.mgr_distance is added to the current city radius. If the
-       * distance between both cities is lower or equal than this value,
-       * migration is possible. */
-      mgr_dist = (int)sqrt((double)MAX(city_map_radius_sq_get(acity),0))
-                 + game.server.mgr_distance;
+      /* Calculate the migration distance. If the distance between both
+       * cities is lower or equal than this value, migration is possible. */
+      mgr_dist = city_migration_max_dist(acity);
 
       /* distance between the two cities */
       dist = real_map_distance(city_tile(pcity), city_tile(acity));
@@ -3192,7 +3351,10 @@ static bool check_city_migrations_player(const struct player *pplayer)
 
       if (game.server.mgr_nationchance > 0 && city_owner(acity) == pplayer) {
         /* migration between cities of the same owner */
-        if (score_tmp > score_from && score_tmp > best_city_player_score) {
+        if (score_tmp > score_from
+            && city_migration_better(pcity, acity, score_tmp,
+                                     best_city_player,
+                                     best_city_player_score)) {
           /* select the best! */
           best_city_player_score = score_tmp;
           best_city_player = acity;
@@ -3213,7 +3375,10 @@ static bool check_city_migrations_player(const struct player *pplayer)
           }
         }
 
-        if (score_tmp > score_from && score_tmp > best_city_world_score) {
+        if (score_tmp > score_from
+            && city_migration_better(pcity, acity, score_tmp,
+                                     best_city_world,
+                                     best_city_world_score)) {
           /* select the best! */
           best_city_world_score = score_tmp;
           best_city_world = acity;
@@ -3225,7 +3390,7 @@ static bool check_city_migrations_player(const struct player *pplayer)
                     best_city_world_score, score_from);
         }
       }
-    } iterate_outward_end;
+    } cityindex_range_iterate_end;
 
     if (best_city_player_score > 0) {
       /* first, do the migration within one nation */
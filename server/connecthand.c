@@ -352,6 +352,8 @@ bool handle_login_request(struct connection *pconn,
   log_verbose("Client caps: %s", req->capability);
   log_verbose("Server caps: %s", our_capability);
   sz_strlcpy(pconn->capability, req->capability);
+  pconn->server.tile_blocks = has_capability("tile_blocks",
+                                             pconn->capability);
   
   /* Make sure the server has every capability the client needs */
   if (!has_capabilities(our_capability, req->capability)) {
@@ -143,6 +143,7 @@ static void check_edited_tile_terrains(void)
   if (need_continents_reassigned) {
     assign_continent_numbers();
     send_all_known_tiles(NULL);
+    map_invalidate_borders();
     need_continents_reassigned = FALSE;
   }
 
@@ -1423,6 +1424,7 @@ void handle_edit_player_vision(struct connection *pc, int plr_no,
 ****************************************************************************/
 void handle_edit_recalculate_borders(struct connection *pc)
 {
+  map_invalidate_borders();
   map_calculate_borders();
 }
 
@@ -28,6 +28,7 @@
 #include "mem.h"
 #include "rand.h"
 #include "shared.h"
+#include "timing.h"
 
 /* common */
 #include "game.h"
@@ -265,7 +266,7 @@ static struct tile *rand_map_pos_characteristic(wetness_c wc,
   filter.wc = wc;
   filter.tc = tc;
   filter.mc = mc;
-  return rand_map_pos_filtered(&filter, condition_filter);
+  return rand_map_pos_filtered_bands(&filter, condition_filter);
 }
 
 /**************************************************************************
@@ -1172,6 +1173,46 @@ static void make_rivers(void)
   destroy_placed_map();
 }
 
+/**************************************************************************
+  Helper for make_land(): sets one band of the map to ocean of the depth
+  given by the height map, or to the land_fill terrain passed as data.
+**************************************************************************/
+static void make_land_band(int index, int first, int last, void *data)
+{
+  struct terrain *land_fill = data;
+  int i;
+
+  for (i = first; i < last; i++) {
+    struct tile *ptile = index_to_tile(i);
+
+    tile_set_terrain(ptile, T_UNKNOWN); /* set as oceans count is used */
+    if (hmap(ptile) < hmap_shore_level) {
+      int depth = (hmap_shore_level - hmap(ptile)) * 100 / hmap_shore_level;
+      int ocean = 0;
+      int land = 0;
+
+      /* This is to make shallow connection between continents less likely */
+      adjc_iterate(ptile, other) {
+        if (hmap(other) < hmap_shore_level) {
+          ocean++;
+        } else {
+          land++;
+          break;
+        }
+      } adjc_iterate_end;
+
+      depth += 30 * (ocean - land) / MAX(1, (ocean + land));
+
+      depth = MIN(depth, TERRAIN_OCEAN_DEPTH_MAXIMUM);
+
+      tile_set_terrain(ptile, pick_ocean(depth));
+    } else {
+      /* See note in make_land() for 'land_fill'. */
+      tile_set_terrain(ptile, land_fill);
+    }
+  }
+}
+
 /**************************************************************************
   make land simply does it all based on a generated heightmap
   1) with map.server.landpercent it generates a ocean/unknown map
@@ -1206,33 +1247,7 @@ static void make_land(void)
 
   hmap_shore_level = (hmap_max_level * (100 - map.server.landpercent)) / 100;
   ini_hmap_low_level();
-  whole_map_iterate(ptile) {
-    tile_set_terrain(ptile, T_UNKNOWN); /* set as oceans count is used */
-    if (hmap(ptile) < hmap_shore_level) {
-      int depth = (hmap_shore_level - hmap(ptile)) * 100 / hmap_shore_level;
-      int ocean = 0;
-      int land = 0;
-
-      /* This is to make shallow connection between continents less likely */
-      adjc_iterate(ptile, other) {
-        if (hmap(other) < hmap_shore_level) {
-          ocean++;
-        } else {
-          land++;
-          break;
-        }
-      } adjc_iterate_end;
-
-      depth += 30 * (ocean - land) / MAX(1, (ocean + land));
-
-      depth = MIN(depth, TERRAIN_OCEAN_DEPTH_MAXIMUM);
-
-      tile_set_terrain(ptile, pick_ocean(depth));
-    } else {
-      /* See note above for 'land_fill'. */
-      tile_set_terrain(ptile, land_fill);
-    }
-  } whole_map_iterate_end;
+  map_bands_run(map_bands_count(), make_land_band, land_fill);
 
   if (HAS_POLES) {
     renormalize_hmap_poles();
@@ -1354,6 +1369,21 @@ static void print_mapgen_map(void)
   } terrain_type_iterate_end;
 }
 
+/**************************************************************************
+  Log how long the map generation phase that just ended took, and start
+  timing the next one. Enabled with the 'verbose' log level.
+**************************************************************************/
+static void mapgen_timer_phase(struct timer *ptimer, const char *phase)
+{
+#ifdef LOG_TIMERS
+  timer_stop(ptimer);
+  log_verbose("Map generation: %s took %.3f seconds.", phase,
+              timer_read_seconds(ptimer));
+  timer_clear(ptimer);
+  timer_start(ptimer);
+#endif /* LOG_TIMERS */
+}
+
 /**************************************************************************
   See stdinhand.c for information on map generation methods.
 
@@ -1372,6 +1402,11 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
   /* save the current random state: */
   RANDOM_STATE rstate;
   RANDOM_TYPE seed_rand;
+  struct timer *phase_timer = timer_new(TIMER_USER, TIMER_ACTIVE);
+  struct timer *total_timer = timer_new(TIMER_USER, TIMER_ACTIVE);
+
+  timer_start(phase_timer);
+  timer_start(total_timer);
 
   /* Call fc_rand() even when result is not needed to make sure
    * random state proceeds equally for random seeds and explicitly
@@ -1404,6 +1439,7 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
 
     /* create a temperature map */
     create_tmap(FALSE);
+    mapgen_timer_phase(phase_timer, "topology");
 
     if (MAPGEN_FAIR == map.server.generator
         && !map_generate_fair_islands()) {
@@ -1431,6 +1467,7 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
 
       /* free terrain selection lists used by make_island() */
       island_terrain_free();
+      mapgen_timer_phase(phase_timer, "islands");
     }
 
     if (MAPGEN_FRACTAL == map.server.generator) {
@@ -1438,12 +1475,14 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
                                ((MAPSTARTPOS_DEFAULT == map.server.startpos
                                  || MAPSTARTPOS_ALL == map.server.startpos)
                                 ? 0 : player_count()));
+      mapgen_timer_phase(phase_timer, "height map");
     }
 
     if (MAPGEN_RANDOM == map.server.generator) {
       make_random_hmap(MAX(1, 1 + get_sqsize()
                            - (MAPSTARTPOS_DEFAULT != map.server.startpos
                               ? player_count() / 4 : 0)));
+      mapgen_timer_phase(phase_timer, "height map");
     }
 
     /* if hmap only generator make anything else */
@@ -1452,6 +1491,7 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
       make_land();
       free(height_map);
       height_map = NULL;
+      mapgen_timer_phase(phase_timer, "terrains and rivers");
     }
     if (!map.server.tinyisles) {
       remove_tiny_islands();
@@ -1467,6 +1507,7 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
   } else {
     assign_continent_numbers();
   }
+  mapgen_timer_phase(phase_timer, "water and continents");
 
   /* create a temperature map if it was not done before */
   if (!temperature_is_initialized()) {
@@ -1481,6 +1522,7 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
   if (!map.server.have_huts) {
     make_huts(map.server.huts); 
   }
+  mapgen_timer_phase(phase_timer, "resources and huts");
 
   /* restore previous random state: */
   fc_rand_set_state(rstate);
@@ -1551,16 +1593,28 @@ bool map_fractal_generate(bool autosize, struct unit_type *initial_unit)
         default:
           log_error(_("The server couldn't allocate starting positions."));
           destroy_tmap();
+          timer_destroy(phase_timer);
+          timer_destroy(total_timer);
           return FALSE;
       }
     }
   }
 
+  mapgen_timer_phase(phase_timer, "start positions");
+
   /* destroy temperature map */
   destroy_tmap();
 
   print_mapgen_map();
 
+#ifdef LOG_TIMERS
+  timer_stop(total_timer);
+  log_verbose("Map generation took %.3f seconds using %d thread(s).",
+              timer_read_seconds(total_timer), map_bands_count());
+#endif /* LOG_TIMERS */
+  timer_destroy(phase_timer);
+  timer_destroy(total_timer);
+
   return TRUE;
 }
 
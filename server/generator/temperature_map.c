@@ -108,22 +108,17 @@ void destroy_tmap(void)
   temperature_map = NULL;
 }
 
-/***************************************************************************
- * Initialize the temperature_map
- * if arg is FALSE, create a dummy tmap == map_colatitude
- * to be used if hmap or oceans are not placed gen 2-4
- ***************************************************************************/
-void create_tmap(bool real)
+/**************************************************************************
+  Helper for create_tmap(): computes the temperatures of one band of the
+  map. data points to the 'real' argument of create_tmap().
+**************************************************************************/
+static void create_tmap_band(int index, int first, int last, void *data)
 {
+  bool real = *(bool *) data;
   int i;
 
-  /* if map is defined this is not changed */
-  /* TODO: load if from scenario game with tmap */
-  /* to debug, never load a this time */
-  fc_assert_ret(NULL == temperature_map);
-
-  temperature_map = fc_malloc(sizeof(*temperature_map) * MAP_INDEX_SIZE);
-  whole_map_iterate(ptile) {
+  for (i = first; i < last; i++) {
+    struct tile *ptile = index_to_tile(i);
     /* the base temperature is equal to base map_colatitude */
     int t = map_colatitude(ptile);
 
@@ -144,7 +139,25 @@ void create_tmap(bool real)
 
       tmap(ptile) =  t * (1.0 + temperate) * (1.0 + height);
     }
-  } whole_map_iterate_end;
+  }
+}
+
+/***************************************************************************
+ * Initialize the temperature_map
+ * if arg is FALSE, create a dummy tmap == map_colatitude
+ * to be used if hmap or oceans are not placed gen 2-4
+ ***************************************************************************/
+void create_tmap(bool real)
+{
+  int i;
+
+  /* if map is defined this is not changed */
+  /* TODO: load if from scenario game with tmap */
+  /* to debug, never load a this time */
+  fc_assert_ret(NULL == temperature_map);
+
+  temperature_map = fc_malloc(sizeof(*temperature_map) * MAP_INDEX_SIZE);
+  map_bands_run(map_bands_count(), create_tmap_band, &real);
   /* adjust to get well sizes frequencies */
   /* Notice: if colatitude is loaded from a scenario never call adjust.
              Scenario may have an odd colatitude distribution and adjust will
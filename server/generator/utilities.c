@@ -14,13 +14,17 @@
 #include <fc_config.h>
 #endif
 
+#include <string.h>
+
 /* utility */
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "rand.h"
 #include "support.h"            /* bool type */
 
 /* common */
+#include "game.h"
 #include "map.h"
 #include "packets.h"
 #include "terrain.h"
@@ -28,6 +32,15 @@
 
 #include "utilities.h"
 
+/* Maps smaller than this many tiles per thread are not worth splitting. */
+#define MAP_BAND_MIN_TILES 1024
+
+struct map_bands {
+  int num;
+  void (*band)(int index, int first, int last, void *data);
+  void *data;
+};
+
 /****************************************************************************
  Map that contains, according to circumstances, information on whether
  we have already placed terrain (special, hut) here.
@@ -171,6 +184,125 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
   }
 }
 
+/****************************************************************************
+  Return the number of bands map_bands_run() should split the map into.
+****************************************************************************/
+int map_bands_count(void)
+{
+  return MAX(1, MIN(game.server.worker_threads,
+                    MAP_INDEX_SIZE / MAP_BAND_MIN_TILES));
+}
+
+/****************************************************************************
+  Helper for map_bands_run(): works on one band.
+****************************************************************************/
+static void map_band_job(int index, void *data)
+{
+  const struct map_bands *bands = data;
+
+  bands->band(index, MAP_INDEX_SIZE * index / bands->num,
+              MAP_INDEX_SIZE * (index + 1) / bands->num, bands->data);
+}
+
+/****************************************************************************
+  Split the tile indices into num_bands ranges of consecutive indices and
+  call band(index, first, last, data) for each of them, in parallel when
+  the 'workerthreads' server setting allows it. 'last' is excluded from the
+  range. The callback must only write to the tiles of its own range and
+  must not use the random number generator.
+****************************************************************************/
+void map_bands_run(int num_bands,
+                   void (*band)(int index, int first, int last, void *data),
+                   void *data)
+{
+  struct map_bands bands;
+
+  bands.num = num_bands;
+  bands.band = band;
+  bands.data = data;
+
+  fc_thread_run_jobs(game.server.worker_threads, num_bands,
+                     map_band_job, &bands);
+}
+
+struct filtered_scan {
+  void *data;
+  bool (*filter)(const struct tile *ptile, const void *data);
+  int *positions;
+  int *counts;
+};
+
+/****************************************************************************
+  Helper for rand_map_pos_filtered_bands(): collects the matching tiles of
+  one band at the start of the band's own part of the positions array.
+****************************************************************************/
+static void filtered_scan_band(int index, int first, int last, void *data)
+{
+  struct filtered_scan *scan = data;
+  int i, count = 0;
+
+  for (i = first; i < last; i++) {
+    if (scan->filter(index_to_tile(i), scan->data)) {
+      scan->positions[first + count] = i;
+      count++;
+    }
+  }
+  scan->counts[index] = count;
+}
+
+/****************************************************************************
+  Same as rand_map_pos_filtered(), but the full map scan it falls back to
+  is split in bands. The same tile is chosen as rand_map_pos_filtered()
+  would choose, whatever the number of threads. The filter must be
+  thread-safe.
+****************************************************************************/
+struct tile *rand_map_pos_filtered_bands(void *data,
+                                         bool (*filter)(const struct tile *ptile,
+                                                        const void *data))
+{
+  struct filtered_scan scan;
+  struct tile *ptile;
+  int tries = 0;
+  const int max_tries = MAP_INDEX_SIZE / ACTIVITY_FACTOR;
+  int num_bands, count, i;
+
+  do {
+    ptile = map.tiles + fc_rand(MAP_INDEX_SIZE);
+  } while (!filter(ptile, data) && ++tries < max_tries);
+
+  if (tries < max_tries) {
+    return ptile;
+  }
+
+  num_bands = map_bands_count();
+  scan.data = data;
+  scan.filter = filter;
+  scan.positions = fc_malloc(MAP_INDEX_SIZE * sizeof(*scan.positions));
+  scan.counts = fc_malloc(num_bands * sizeof(*scan.counts));
+
+  map_bands_run(num_bands, filtered_scan_band, &scan);
+
+  /* Pack the bands together, keeping the map order. */
+  count = scan.counts[0];
+  for (i = 1; i < num_bands; i++) {
+    memmove(scan.positions + count,
+            scan.positions + MAP_INDEX_SIZE * i / num_bands,
+            scan.counts[i] * sizeof(*scan.positions));
+    count += scan.counts[i];
+  }
+
+  if (count == 0) {
+    ptile = NULL;
+  } else {
+    ptile = map.tiles + scan.positions[fc_rand(count)];
+  }
+
+  free(scan.positions);
+  free(scan.counts);
+
+  return ptile;
+}
+
 /****************************************************************************
   Is given native position normal position
 ****************************************************************************/
@@ -180,6 +312,37 @@ bool is_normal_nat_pos(int x, int y)
   return is_normal_map_pos(x, y);
 }
 
+struct smooth_pass {
+  const float *weight;
+  bool axe;
+  bool zeroes_at_edges;
+  const int *source_map;
+  int *target_map;
+};
+
+/****************************************************************************
+  Helper for smooth_int_map(): diffuses one band of the map along one axis.
+****************************************************************************/
+static void smooth_int_map_band(int index, int first, int last, void *data)
+{
+  const struct smooth_pass *pass = data;
+  int i;
+
+  for (i = first; i < last; i++) {
+    struct tile *ptile = index_to_tile(i);
+    float N = 0, D = 0;
+
+    axis_iterate(ptile, pnear, j, 2, pass->axe) {
+      D += pass->weight[j + 2];
+      N += pass->weight[j + 2] * pass->source_map[tile_index(pnear)];
+    } axis_iterate_end;
+    if (pass->zeroes_at_edges) {
+      D = 1;
+    }
+    pass->target_map[i] = (float)N / D;
+  }
+}
+
 /*******************************************************************************
   Apply a Gaussian diffusion filter on the map. The size of the map is
   MAP_INDEX_SIZE and the map is indexed by native_pos_to_index function.
@@ -190,41 +353,31 @@ void smooth_int_map(int *int_map, bool zeroes_at_edges)
 {
   static const float weight_standard[5] = { 0.13, 0.19, 0.37, 0.19, 0.13 };
   static const float weight_isometric[5] = { 0.15, 0.21, 0.29, 0.21, 0.15 };
-  const float *weight;
-  bool axe = TRUE;
-  int *target_map, *source_map;
+  struct smooth_pass pass;
+  int num_bands = map_bands_count();
   int *alt_int_map = fc_calloc(MAP_INDEX_SIZE, sizeof(*alt_int_map));
 
   fc_assert_ret(NULL != int_map);
 
-  weight = weight_standard;
-  target_map = alt_int_map;
-  source_map = int_map;
+  pass.weight = weight_standard;
+  pass.axe = TRUE;
+  pass.zeroes_at_edges = zeroes_at_edges;
+  pass.target_map = alt_int_map;
+  pass.source_map = int_map;
 
   do {
-    whole_map_iterate(ptile) {
-      float N = 0, D = 0;
-
-      axis_iterate(ptile, pnear, i, 2, axe) {
-        D += weight[i + 2];
-        N += weight[i + 2] * source_map[tile_index(pnear)];
-      } axis_iterate_end;
-      if (zeroes_at_edges) {
-        D = 1;
-      }
-      target_map[tile_index(ptile)] = (float)N / D;
-    } whole_map_iterate_end;
+    map_bands_run(num_bands, smooth_int_map_band, &pass);
 
     if (MAP_IS_ISOMETRIC) {
-      weight = weight_isometric;
+      pass.weight = weight_isometric;
     }
 
-    axe = !axe;
+    pass.axe = !pass.axe;
 
-    source_map = alt_int_map;
-    target_map = int_map;
+    pass.source_map = alt_int_map;
+    pass.target_map = int_map;
 
-  } while (!axe);
+  } while (!pass.axe);
 
   FC_FREE(alt_int_map);
 }
@@ -98,6 +98,15 @@ void adjust_int_map_filtered(int *int_map, int int_map_max, void *data,
 	     (bool (*)(const struct tile *ptile, const void *data) )NULL)
 void smooth_int_map(int *int_map, bool zeroes_at_edges);
 
+/* per-tile passes split over worker threads */
+int map_bands_count(void);
+void map_bands_run(int num_bands,
+                   void (*band)(int index, int first, int last, void *data),
+                   void *data);
+struct tile *rand_map_pos_filtered_bands(void *data,
+                                         bool (*filter)(const struct tile *ptile,
+                                                        const void *data));
+
 /* placed_map tool*/
 void create_placed_map(void);
 void destroy_placed_map(void);
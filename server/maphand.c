@@ -17,6 +17,7 @@
 
 /* utility */
 #include "bitvector.h"
+#include "capability.h"
 #include "fcintl.h"
 #include "log.h"
 #include "mem.h"
@@ -59,6 +60,53 @@
 /* Suppress send_tile_info() during game_load() */
 static bool send_tile_suppressed = FALSE;
 
+/* While positive, send_tile_info() gathers the tiles for the clients
+ * which can take them into blocks of consecutive tiles. */
+static int tile_info_blocks_frozen = 0;
+
+/* A PACKET_TILE_INFO_BLOCK being filled for a connection. */
+struct tile_info_block {
+  struct packet_tile_info_block packet;
+  int count;                    /* Number of tiles in the runs */
+};
+
+/* For each tile and vision layer, the players having a positive seen
+ * count of the tile. Kept up to date with the seen counts of the players'
+ * private maps, so the viewers of a tile can be found without asking every
+ * player. Allocated for tile_seen_players_size tiles. */
+static bv_player *tile_seen_players = NULL;
+static int tile_seen_players_size = 0;
+
+#define TILE_SEEN_PLAYERS(ptile, vlayer)                                    \
+  tile_seen_players[tile_index(ptile) * V_COUNT + (vlayer)]
+
+/* A border source as it was when map_calculate_borders() last claimed its
+ * borders. */
+struct border_source {
+  int stamp;                    /* Changes up to this one were seen */
+  struct player *owner;
+  int radius_sq;
+  int strength;
+  int city_radius_sq;           /* -1 if the source is not a city */
+  bool claim_ocean;
+  int reach_sq;                 /* Distance of the farthest claimed tile */
+};
+
+/* What map_calculate_borders() needs to redo only the part of the borders
+ * that may have changed. Every change to a tile which can matter to the
+ * claims of the sources around it gets a new stamp; a source then only
+ * has to look again at the tiles changed since its last claim, unless
+ * the source itself has changed. */
+static struct {
+  int num_tiles;
+  enum borders_mode mode;
+  int stamp;                    /* Stamp of the latest change */
+  int *tile_stamp;
+  struct border_source *sources;  /* Indexed by the tile of the source */
+} border_cache = { 0, BORDERS_DISABLED, 0, NULL, NULL };
+
+static void border_cache_mark_tile(const struct tile *ptile);
+
 static void player_tile_init(struct tile *ptile, struct player *pplayer);
 static void player_tile_free(struct tile *ptile, struct player *pplayer);
 static void give_tile_info_from_player_to_player(struct player *pfrom,
@@ -78,6 +126,9 @@ static void map_change_own_seen(struct player *pplayer,
 static inline int map_get_seen(const struct player *pplayer,
                                const struct tile *ptile,
                                enum vision_layer vlayer);
+static void tile_seen_players_update(const struct tile *ptile,
+                                     const struct player *pplayer,
+                                     const struct player_tile *plrtile);
 static inline int map_get_own_seen(const struct player *pplayer,
                                    const struct tile *ptile,
                                    enum vision_layer vlayer);
@@ -430,11 +481,165 @@ bool really_gives_vision(struct player *me, struct player *them)
   return BV_ISSET(me->server.really_gives_vision, player_index(them));
 }
 
+/**************************************************************************
+  Send the tile info block being filled for the connection, if any.
+**************************************************************************/
+static void tile_info_block_flush(struct connection *pconn)
+{
+  struct tile_info_block *block = pconn->server.tile_block;
+
+  if (block == NULL || block->packet.runs == 0) {
+    return;
+  }
+
+  /* Unhook first: sending the block must not flush it again. */
+  pconn->flush_pending = NULL;
+  send_packet_tile_info_block(pconn, &block->packet);
+  block->packet.runs = 0;
+  block->count = 0;
+}
+
+/**************************************************************************
+  Add the tile info to the block being filled for the connection. The
+  block is sent first if the tile does not follow its last tile.
+**************************************************************************/
+static void tile_info_block_add(struct connection *pconn,
+                                const struct packet_tile_info *info)
+{
+  struct tile_info_block *block = pconn->server.tile_block;
+  struct packet_tile_info_block *packet;
+  int special = 0, bases = 0, roads = 0;
+  int i;
+
+  FC_STATIC_ASSERT(S_LAST <= 8, too_many_specials_for_tile_info_block);
+  FC_STATIC_ASSERT(MAX_BASE_TYPES <= 32, too_many_bases_for_tile_info_block);
+  FC_STATIC_ASSERT(MAX_ROAD_TYPES <= 8, too_many_roads_for_tile_info_block);
+
+  tile_special_type_iterate(spe) {
+    if (info->special[spe]) {
+      special |= 1 << spe;
+    }
+  } tile_special_type_iterate_end;
+  for (i = 0; i < MAX_BASE_TYPES; i++) {
+    if (BV_ISSET(info->bases, i)) {
+      bases |= 1u << i;
+    }
+  }
+  for (i = 0; i < MAX_ROAD_TYPES; i++) {
+    if (BV_ISSET(info->roads, i)) {
+      roads |= 1 << i;
+    }
+  }
+
+  if (block == NULL) {
+    block = fc_malloc(sizeof(*block));
+    block->packet.runs = 0;
+    block->count = 0;
+    pconn->server.tile_block = block;
+  } else if (block->packet.runs > 0
+             && info->tile != block->packet.first + block->count) {
+    tile_info_block_flush(pconn);
+  }
+  packet = &block->packet;
+
+  i = packet->runs - 1;
+  if (i >= 0 && packet->length[i] < 255
+      && packet->known[i] == info->known
+      && packet->continent[i] == info->continent
+      && packet->owner[i] == info->owner
+      && packet->worked[i] == info->worked
+      && packet->terrain[i] == info->terrain
+      && packet->resource[i] == info->resource
+      && packet->special[i] == special
+      && packet->bases[i] == bases
+      && packet->roads[i] == roads) {
+    /* Same as the tile before. */
+    packet->length[i]++;
+  } else {
+    if (packet->runs >= MAX_TILE_INFO_BLOCK) {
+      tile_info_block_flush(pconn);
+    }
+    if (packet->runs == 0) {
+      packet->first = info->tile;
+      /* Anything sent to the connection from now on sends the block
+       * first, so that the client gets the tiles before it. */
+      pconn->flush_pending = tile_info_block_flush;
+    }
+
+    i = packet->runs++;
+    packet->length[i] = 1;
+    packet->known[i] = info->known;
+    packet->continent[i] = info->continent;
+    packet->owner[i] = info->owner;
+    packet->worked[i] = info->worked;
+    packet->terrain[i] = info->terrain;
+    packet->resource[i] = info->resource;
+    packet->special[i] = special;
+    packet->bases[i] = bases;
+    packet->roads[i] = roads;
+  }
+  block->count++;
+
+  /* The packet cache of PACKET_TILE_INFO did not see this info. */
+  if (dbv_bits(&pconn->server.tiles_in_blocks) != MAP_INDEX_SIZE) {
+    dbv_resize(&pconn->server.tiles_in_blocks, MAP_INDEX_SIZE);
+  }
+  dbv_set(&pconn->server.tiles_in_blocks, info->tile);
+}
+
+/**************************************************************************
+  Send the tile info to the connection, in a block when possible.
+**************************************************************************/
+static void send_tile_info_to_conn(struct connection *pconn,
+                                   const struct packet_tile_info *info)
+{
+  struct dbv *in_blocks = &pconn->server.tiles_in_blocks;
+  bool force = FALSE;
+
+  if (tile_info_blocks_frozen > 0
+      && info->spec_sprite[0] == '\0' && info->label[0] == '\0'
+      && pconn->server.tile_blocks) {
+    tile_info_block_add(pconn, info);
+    return;
+  }
+
+  if (info->tile < dbv_bits(in_blocks) && dbv_isset(in_blocks, info->tile)) {
+    /* The client has newer info than the packet cache: this info must be
+     * sent even if it is the same as the cached one. */
+    dbv_clr(in_blocks, info->tile);
+    force = TRUE;
+  }
+  send_packet_tile_info(pconn, info, force);
+}
+
+/**************************************************************************
+  Start gathering the tile infos into blocks. Calls nest.
+**************************************************************************/
+static void tile_info_blocks_freeze(void)
+{
+  tile_info_blocks_frozen++;
+}
+
+/**************************************************************************
+  Stop gathering the tile infos into blocks, and send the blocks.
+**************************************************************************/
+static void tile_info_blocks_thaw(void)
+{
+  fc_assert_ret(tile_info_blocks_frozen > 0);
+
+  if (--tile_info_blocks_frozen == 0) {
+    conn_list_iterate(game.all_connections, pconn) {
+      tile_info_block_flush(pconn);
+    } conn_list_iterate_end;
+  }
+}
+
 /**************************************************************************
   Start buffering shared vision
 **************************************************************************/
 static void buffer_shared_vision(struct player *pplayer)
 {
+  tile_info_blocks_freeze();
   players_iterate(pplayer2) {
     if (really_gives_vision(pplayer, pplayer2)) {
       conn_list_compression_freeze(pplayer2->connections);
@@ -450,6 +655,7 @@ static void buffer_shared_vision(struct player *pplayer)
 **************************************************************************/
 static void unbuffer_shared_vision(struct player *pplayer)
 {
+  tile_info_blocks_thaw();
   players_iterate(pplayer2) {
     if (really_gives_vision(pplayer, pplayer2)) {
       conn_list_do_unbuffer(pplayer2->connections);
@@ -533,19 +739,23 @@ void send_all_known_tiles(struct conn_list *dest)
   /* send whole map piece by piece to each player to balance the load
      of the send buffers better */
   tiles_sent = 0;
+  tile_info_blocks_freeze();
   conn_list_do_buffer(dest);
 
   whole_map_iterate(ptile) {
     tiles_sent++;
     if ((tiles_sent % map.xsize) == 0) {
+      tile_info_blocks_thaw();
       conn_list_do_unbuffer(dest);
       flush_packets();
       conn_list_do_buffer(dest);
+      tile_info_blocks_freeze();
     }
 
     send_tile_info(dest, ptile, FALSE);
   } whole_map_iterate_end;
 
+  tile_info_blocks_thaw();
   conn_list_do_unbuffer(dest);
   flush_packets();
 }
@@ -626,7 +836,7 @@ void send_tile_info(struct conn_list *dest, struct tile *ptile,
         info.label[0] = '\0';
       }
 
-      send_packet_tile_info(pconn, &info);
+      send_tile_info_to_conn(pconn, &info);
     } else if (pplayer && map_is_known(ptile, pplayer)) {
       struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
       struct vision_site *psite = map_get_player_site(ptile, pplayer);
@@ -661,7 +871,7 @@ void send_tile_info(struct conn_list *dest, struct tile *ptile,
         info.label[0] = '\0';
       }
 
-      send_packet_tile_info(pconn, &info);
+      send_tile_info_to_conn(pconn, &info);
     } else if (send_unknown) {
       info.known = TILE_UNKNOWN;
       info.continent = 0;
@@ -679,7 +889,7 @@ void send_tile_info(struct conn_list *dest, struct tile *ptile,
 
       info.label[0] = '\0';
 
-      send_packet_tile_info(pconn, &info);
+      send_tile_info_to_conn(pconn, &info);
     }
   }
   conn_list_iterate_end;
@@ -1000,6 +1210,7 @@ void map_change_seen(struct player *pplayer,
     fc_assert(0 <= change[v] || -change[v] <= plrtile->seen_count[v]);
     plrtile->seen_count[v] += change[v];
   } vision_layer_iterate_end;
+  tile_seen_players_update(ptile, pplayer, plrtile);
 
   /* V_MAIN vision ranges must always be more than V_INVIS ranges
    * (see comment in common/vision.h), so we assume that the V_MAIN
@@ -1133,7 +1344,11 @@ void change_playertile_site(struct player_tile *ptile,
 ***************************************************************/
 void map_set_known(struct tile *ptile, struct player *pplayer)
 {
-  dbv_set(&pplayer->tile_known, tile_index(ptile));
+  if (!dbv_isset(&pplayer->tile_known, tile_index(ptile))) {
+    dbv_set(&pplayer->tile_known, tile_index(ptile));
+    /* The player's border sources may claim the tile now. */
+    border_cache_mark_tile(ptile);
+  }
 }
 
 /***************************************************************
@@ -1180,6 +1395,16 @@ void player_map_init(struct player *pplayer)
     = fc_realloc(pplayer->server.private_map,
                  MAP_INDEX_SIZE * sizeof(*pplayer->server.private_map));
 
+  if (tile_seen_players_size != MAP_INDEX_SIZE) {
+    /* The map size changed, so did the private maps of all players. */
+    tile_seen_players
+      = fc_realloc(tile_seen_players,
+                   MAP_INDEX_SIZE * V_COUNT * sizeof(*tile_seen_players));
+    memset(tile_seen_players, 0,
+           MAP_INDEX_SIZE * V_COUNT * sizeof(*tile_seen_players));
+    tile_seen_players_size = MAP_INDEX_SIZE;
+  }
+
   whole_map_iterate(ptile) {
     player_tile_init(ptile, pplayer);
   } whole_map_iterate_end;
@@ -1198,6 +1423,11 @@ void player_map_free(struct player *pplayer)
 
   whole_map_iterate(ptile) {
     player_tile_free(ptile, pplayer);
+    if (tile_seen_players_size == MAP_INDEX_SIZE) {
+      vision_layer_iterate(v) {
+        BV_CLR(TILE_SEEN_PLAYERS(ptile, v), player_index(pplayer));
+      } vision_layer_iterate_end;
+    }
   } whole_map_iterate_end;
 
   free(pplayer->server.private_map);
@@ -1256,6 +1486,7 @@ void remove_player_from_maps(struct player *pplayer)
     /* Free all claimed tiles. */
     if (tile_owner(ptile) == pplayer) {
       tile_set_owner(ptile, NULL, NULL);
+      border_cache_mark_tile(ptile);
       /* Update anyone who can see the tile (e.g. global observers) */
       send_tile_info(NULL, ptile, FALSE);
     }
@@ -1283,6 +1514,41 @@ static void player_tile_init(struct tile *ptile, struct player *pplayer)
   plrtile->seen_count[V_MAIN] = !game.server.fogofwar_old;
   plrtile->seen_count[V_INVIS] = 0;
   memcpy(plrtile->own_seen, plrtile->seen_count, sizeof(v_radius_t));
+  tile_seen_players_update(ptile, pplayer, plrtile);
+}
+
+/****************************************************************************
+  Record in the tile's viewer sets whether the player's seen counts of the
+  tile are positive. Must be called whenever they change.
+****************************************************************************/
+static void tile_seen_players_update(const struct tile *ptile,
+                                     const struct player *pplayer,
+                                     const struct player_tile *plrtile)
+{
+  vision_layer_iterate(v) {
+    if (0 < plrtile->seen_count[v]) {
+      BV_SET(TILE_SEEN_PLAYERS(ptile, v), player_index(pplayer));
+    } else {
+      BV_CLR(TILE_SEEN_PLAYERS(ptile, v), player_index(pplayer));
+    }
+  } vision_layer_iterate_end;
+}
+
+/****************************************************************************
+  Fill 'seen' with the players who know the tile and currently see it on
+  the given vision layer, i.e. the players for whom map_is_known_and_seen()
+  is TRUE. Only the players actually seeing the tile are looked at.
+****************************************************************************/
+void map_get_seen_players(const struct tile *ptile,
+                          enum vision_layer vlayer, bv_player *seen)
+{
+  *seen = TILE_SEEN_PLAYERS(ptile, vlayer);
+
+  players_in_bv_iterate(*seen, pplayer) {
+    if (!map_is_known(ptile, pplayer)) {
+      BV_CLR(*seen, player_index(pplayer));
+    }
+  } players_in_bv_iterate_end;
 }
 
 /****************************************************************************
@@ -1379,14 +1645,15 @@ bool update_player_tile_knowledge(struct player *pplayer, struct tile *ptile)
 ****************************************************************************/
 void update_tile_knowledge(struct tile *ptile)
 {
+  bv_player seen;
+
   /* Players */
-  players_iterate(pplayer) {
-    if (map_is_known_and_seen(ptile, pplayer, V_MAIN)) {
-      if (update_player_tile_knowledge(pplayer, ptile)) {
-        send_tile_info(pplayer->connections, ptile, FALSE);
-      }
+  map_get_seen_players(ptile, V_MAIN, &seen);
+  players_in_bv_iterate(seen, pplayer) {
+    if (update_player_tile_knowledge(pplayer, ptile)) {
+      send_tile_info(pplayer->connections, ptile, FALSE);
     }
-  } players_iterate_end;
+  } players_in_bv_iterate_end;
 
   /* Global observers */
   conn_list_iterate(game.est_connections, pconn) {
@@ -1890,6 +2157,8 @@ void check_terrain_change(struct tile *ptile, struct terrain *oldter)
   if (need_to_reassign_continents(oldter, newter)) {
     assign_continent_numbers();
     send_all_known_tiles(NULL);
+    /* Which tiles are claimable depends on the continents. */
+    map_invalidate_borders();
   }
 
   sanity_check_tile(ptile);
@@ -1979,6 +2248,15 @@ static void map_claim_border_ownership(struct tile *ptile,
 {
   struct player *ploser = tile_owner(ptile);
 
+  if (ploser != powner || tile_claimer(ptile) != psource) {
+    border_cache_mark_tile(ptile);
+  }
+  if (psource != NULL && border_cache.sources != NULL) {
+    struct border_source *src = border_cache.sources + tile_index(psource);
+
+    src->reach_sq = MAX(src->reach_sq, sq_map_distance(psource, ptile));
+  }
+
   if (BORDERS_SEE_INSIDE == game.info.borders
       || BORDERS_EXPAND == game.info.borders) {
     if (ploser != powner) {
@@ -2075,6 +2353,75 @@ void map_update_border(struct tile *ptile, struct player *owner,
   }
 }
 
+/*************************************************************************
+  Claim the tile 'dtile', at the square distance 'dr' of the border
+  source 'ptile', for 'owner' if the source can take it.
+*************************************************************************/
+static void map_claim_border_tile(struct tile *ptile, struct player *owner,
+                                  struct tile *dtile, int dr)
+{
+  struct tile *dclaimer = tile_claimer(dtile);
+
+  if (dclaimer == ptile) {
+    /* Already claimed by the ptile */
+    return;
+  }
+
+  if (dr != 0 && is_border_source(dtile)) {
+    /* Do not claim border sources other than self */
+    /* Note that this is extremely important at the moment for
+     * base claiming to work correctly in case there's two
+     * fortresses near each other. There could be infinite
+     * recursion in them claiming each other. */
+    return;
+  }
+
+  if (!map_is_known(dtile, owner) && game.info.borders < BORDERS_EXPAND) {
+    return;
+  }
+
+  /* Always claim source itself (distance, dr, to it 0) */
+  if (dr != 0 && NULL != dclaimer && dclaimer != ptile) {
+    struct city *ccity = tile_city(dclaimer);
+    int strength_old, strength_new;
+
+    if (ccity != NULL) {
+      /* Previously claimed by city */
+      int city_x, city_y;
+
+      map_distance_vector(&city_x, &city_y, ccity->tile, dtile);
+
+      if (is_valid_city_coords(city_map_radius_sq_get(ccity),
+          CITY_REL2ABS(city_x), CITY_REL2ABS(city_y))) {
+        /* Tile is within squared city radius */
+        return;
+      }
+    }
+
+    strength_old = tile_border_strength(dtile, dclaimer);
+    strength_new = tile_border_strength(dtile, ptile);
+
+    if (strength_new <= strength_old) {
+      /* Stronger shall prevail,
+       * in case of equal strength older shall prevail */
+      return;
+    }
+  }
+
+  if (is_ocean_tile(dtile)) {
+    /* Only certain water tiles are claimable */
+    if (is_claimable_ocean(dtile, ptile, owner)) {
+      map_claim_ownership(dtile, owner, ptile);
+    }
+  } else {
+    /* Only land tiles on the same island as the border source
+     * are claimable */
+    if (tile_continent(dtile) == tile_continent(ptile)) {
+      map_claim_ownership(dtile, owner, ptile);
+    }
+  }
+}
+
 /*************************************************************************
   Update borders for this source. Call this for each new source.
 
@@ -2100,71 +2447,118 @@ void map_claim_border(struct tile *ptile, struct player *owner,
   }
 
   circle_dxyr_iterate(ptile, radius_sq, dtile, dx, dy, dr) {
-    struct tile *dclaimer = tile_claimer(dtile);
-
-    if (dclaimer == ptile) {
-      /* Already claimed by the ptile */
-      continue;
-    }
+    map_claim_border_tile(ptile, owner, dtile, dr);
+  } circle_dxyr_iterate_end;
+}
 
-    if (dr != 0 && is_border_source(dtile)) {
-      /* Do not claim border sources other than self */
-      /* Note that this is extremely important at the moment for
-       * base claiming to work correctly in case there's two
-       * fortresses near each other. There could be infinite
-       * recursion in them claiming each other. */
-      continue;
-    }
+/*************************************************************************
+  Record a change to the tile which may matter to the border sources
+  around it.
+*************************************************************************/
+static void border_cache_mark_tile(const struct tile *ptile)
+{
+  if (border_cache.tile_stamp != NULL
+      && tile_index(ptile) < border_cache.num_tiles) {
+    border_cache.tile_stamp[tile_index(ptile)] = ++border_cache.stamp;
+  }
+}
 
-    if (!map_is_known(dtile, owner) && game.info.borders < BORDERS_EXPAND) {
-      continue;
-    }
+/*************************************************************************
+  Fill 'src' with the current state of the border source at the tile.
+*************************************************************************/
+static void border_source_get(struct border_source *src, struct tile *ptile)
+{
+  struct city *pcity = tile_city(ptile);
 
-    /* Always claim source itself (distance, dr, to it 0) */
-    if (dr != 0 && NULL != dclaimer && dclaimer != ptile) {
-      struct city *ccity = tile_city(dclaimer);
-      int strength_old, strength_new;
+  src->owner = tile_owner(ptile);
+  src->radius_sq = tile_border_source_radius_sq(ptile);
+  src->strength = tile_border_source_strength(ptile);
+  src->city_radius_sq = (pcity != NULL ? city_map_radius_sq_get(pcity)
+                                       : -1);
+  src->claim_ocean = (src->owner != NULL
+                      && num_known_tech_with_flag(src->owner,
+                                                  TF_CLAIM_OCEAN) > 0);
+}
 
-      if (ccity != NULL) {
-        /* Previously claimed by city */
-        int city_x, city_y;
+/*************************************************************************
+  Return TRUE if the border source 'now' differs from what was recorded
+  in 'src'.
+*************************************************************************/
+static bool border_source_changed(const struct border_source *src,
+                                  const struct border_source *now)
+{
+  return (src->owner != now->owner
+          || src->radius_sq != now->radius_sq
+          || src->strength != now->strength
+          || src->city_radius_sq != now->city_radius_sq
+          || src->claim_ocean != now->claim_ocean);
+}
 
-        map_distance_vector(&city_x, &city_y, ccity->tile, dtile);
+/*************************************************************************
+  Allocate the border cache for the current map. All the sources count as
+  changed, so the first map_calculate_borders() claims all the borders.
+*************************************************************************/
+static void border_cache_alloc(void)
+{
+  int i;
+
+  border_cache.num_tiles = MAP_INDEX_SIZE;
+  border_cache.mode = game.info.borders;
+  border_cache.stamp = 0;
+  border_cache.tile_stamp = fc_calloc(border_cache.num_tiles,
+                                      sizeof(*border_cache.tile_stamp));
+  border_cache.sources = fc_malloc(border_cache.num_tiles
+                                   * sizeof(*border_cache.sources));
+  for (i = 0; i < border_cache.num_tiles; i++) {
+    border_cache.sources[i].stamp = -1;
+    border_cache.sources[i].owner = NULL;
+    border_cache.sources[i].radius_sq = -1;
+    border_cache.sources[i].strength = -1;
+    border_cache.sources[i].city_radius_sq = -1;
+    border_cache.sources[i].claim_ocean = FALSE;
+    border_cache.sources[i].reach_sq = 0;
+  }
 
-        if (is_valid_city_coords(city_map_radius_sq_get(ccity),
-            CITY_REL2ABS(city_x), CITY_REL2ABS(city_y))) {
-          /* Tile is within squared city radius */
-          continue;
-        }
-      }
+  /* The tiles claimed by a source may lie beyond its current radius. */
+  whole_map_iterate(ptile) {
+    struct tile *claimer = tile_claimer(ptile);
 
-      strength_old = tile_border_strength(dtile, dclaimer);
-      strength_new = tile_border_strength(dtile, ptile);
+    if (claimer != NULL) {
+      struct border_source *src = border_cache.sources + tile_index(claimer);
 
-      if (strength_new <= strength_old) {
-        /* Stronger shall prevail,
-         * in case of equal strength older shall prevail */
-        continue;
-      }
+      src->reach_sq = MAX(src->reach_sq, sq_map_distance(claimer, ptile));
     }
+  } whole_map_iterate_end;
+}
 
-    if (is_ocean_tile(dtile)) {
-      /* Only certain water tiles are claimable */
-      if (is_claimable_ocean(dtile, ptile, owner)) {
-        map_claim_ownership(dtile, owner, ptile);
-      }
-    } else {
-      /* Only land tiles on the same island as the border source
-       * are claimable */
-      if (tile_continent(dtile) == tile_continent(ptile)) {
-        map_claim_ownership(dtile, owner, ptile);
-      }
-    }
-  } circle_dxyr_iterate_end;
+/*************************************************************************
+  Forget what the borders were calculated from. The next
+  map_calculate_borders() claims the borders of all the sources again.
+  Call this when something the claims depend on changes for the whole map
+  (e.g. the continent numbers), or to free the cache.
+*************************************************************************/
+void map_invalidate_borders(void)
+{
+  if (border_cache.tile_stamp != NULL) {
+    free(border_cache.tile_stamp);
+    border_cache.tile_stamp = NULL;
+  }
+  if (border_cache.sources != NULL) {
+    free(border_cache.sources);
+    border_cache.sources = NULL;
+  }
+  border_cache.num_tiles = 0;
 }
 
 /*************************************************************************
   Update borders for all sources. Call this on turn end.
+
+  Only the claims which may have changed since the last call are made
+  again: a source which changed itself (e.g. grew, or got a new owner)
+  claims all the tiles in its radius, any other source only the tiles
+  changed since it last claimed. The sources are handled in the same
+  order as if all the borders were claimed again, so the result is the
+  same.
 *************************************************************************/
 void map_calculate_borders(void)
 {
@@ -2179,10 +2573,73 @@ void map_calculate_borders(void)
 
   log_verbose("map_calculate_borders()");
 
+  if (border_cache.sources != NULL
+      && (border_cache.num_tiles != MAP_INDEX_SIZE
+          || border_cache.mode != game.info.borders)) {
+    map_invalidate_borders();
+  }
+  if (border_cache.sources == NULL) {
+    border_cache_alloc();
+  }
+
+  /* A source which changed makes the tiles it claimed change for the
+   * other sources. Mark them all before anything is claimed again. */
+  whole_map_iterate(ptile) {
+    struct border_source *src = border_cache.sources + tile_index(ptile);
+    struct border_source now;
+
+    if (!is_border_source(ptile)) {
+      if (src->radius_sq >= 0) {
+        /* No longer a source. */
+        circle_iterate(ptile, src->reach_sq, dtile) {
+          border_cache_mark_tile(dtile);
+        } circle_iterate_end;
+        src->radius_sq = -1;
+        src->stamp = -1;
+      }
+      continue;
+    }
+
+    border_source_get(&now, ptile);
+    if (border_source_changed(src, &now)) {
+      circle_iterate(ptile, src->reach_sq, dtile) {
+        border_cache_mark_tile(dtile);
+      } circle_iterate_end;
+      border_cache_mark_tile(ptile);
+      now.stamp = -1;
+      now.reach_sq = src->reach_sq;
+      *src = now;
+    }
+  } whole_map_iterate_end;
+
   whole_map_iterate(ptile) {
-    if (is_border_source(ptile)) {
-      map_claim_border(ptile, ptile->owner, -1);
+    struct border_source *src = border_cache.sources + tile_index(ptile);
+    struct border_source now;
+    int stamp = border_cache.stamp;
+
+    if (!is_border_source(ptile)) {
+      continue;
+    }
+
+    if (tile_owner(ptile) == NULL) {
+      map_claim_border(ptile, NULL, -1);
+      continue;
+    }
+
+    border_source_get(&now, ptile);
+    if (border_source_changed(src, &now)) {
+      /* Changed by the claims made before in this loop. */
+      now.stamp = -1;
+      now.reach_sq = src->reach_sq;
+      *src = now;
     }
+
+    circle_dxyr_iterate(ptile, src->radius_sq, dtile, dx, dy, dr) {
+      if (border_cache.tile_stamp[tile_index(dtile)] > src->stamp) {
+        map_claim_border_tile(ptile, src->owner, dtile, dr);
+      }
+    } circle_dxyr_iterate_end;
+    src->stamp = stamp;
   } whole_map_iterate_end;
 
   log_verbose("map_calculate_borders() workers");
@@ -2311,18 +2768,18 @@ void create_base(struct tile *ptile, struct base_type *pbase,
 void destroy_base(struct tile *ptile, struct base_type *pbase)
 {
   bv_player base_seen;
-  bool virtual = tile_virtual_check(ptile);
 
-  /* Remember what players were able to see the base. */
-  if (!virtual) {
-    BV_CLR_ALL(base_seen);
-    players_iterate(pplayer) {
-      if (map_is_known_and_seen(ptile, pplayer, V_MAIN)) {
-        BV_SET(base_seen, player_index(pplayer));
-      }
-    } players_iterate_end;
+  if (tile_virtual_check(ptile)) {
+    /* Virtual tiles have neither borders nor vision to update; the
+     * infrastructure cache tries out terrain changes on them, possibly
+     * on worker threads. */
+    tile_remove_base(ptile, pbase);
+    return;
   }
 
+  /* Remember what players were able to see the base. */
+  map_get_seen_players(ptile, V_MAIN, &base_seen);
+
   if (territory_claiming_base(pbase)) {
     /* Clearing borders will take care of the vision providing
      * bases as well. */
@@ -2344,15 +2801,13 @@ void destroy_base(struct tile *ptile, struct base_type *pbase)
   }
   tile_remove_base(ptile, pbase);
 
-  if (!virtual) {
-    /* Remove base from vision of players which were able to see the base. */
-    players_iterate(pplayer) {
-      if (BV_ISSET(base_seen, player_index(pplayer))
-          && update_player_tile_knowledge(pplayer, ptile)) {
-        send_tile_info(pplayer->connections, ptile, FALSE);
-      }
-    } players_iterate_end;
-  }
+  /* Remove base from vision of players which were able to see the base. */
+  players_iterate(pplayer) {
+    if (BV_ISSET(base_seen, player_index(pplayer))
+        && update_player_tile_knowledge(pplayer, ptile)) {
+      send_tile_info(pplayer->connections, ptile, FALSE);
+    }
+  } players_iterate_end;
 }
 
 /****************************************************************************
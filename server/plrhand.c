@@ -1607,6 +1607,7 @@ void server_remove_player(struct player *pplayer)
   send_player_remove_info_c(pslot, NULL);
 
   /* Recalculate borders. */
+  map_invalidate_borders();
   map_calculate_borders();
 }
 
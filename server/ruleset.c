@@ -123,7 +123,20 @@ static char *road_sections = NULL;
 
 static struct requirement_vector reqs_list;
 
+/* The ruleset packets as sent to the first new connection of each
+ * capability string, to be sent again to the next ones. */
+#define SPECLIST_TAG packet_stream
+#define SPECLIST_TYPE struct packet_stream
+#include "speclist.h"
+#define packet_stream_list_iterate(plist, pstream)                          \
+  TYPED_LIST_ITERATE(struct packet_stream, plist, pstream)
+#define packet_stream_list_iterate_end LIST_ITERATE_END
+
+static struct packet_stream_list *ruleset_streams = NULL;
+
 static bool load_rulesetdir(const char *rsdir, bool act);
+static void ruleset_streams_free(void);
+static void send_rulesets_packets(struct conn_list *dest);
 static struct section_file *openload_ruleset_file(const char *whichset,
                                                   const char *rsdir);
 static const char *check_ruleset_capabilities(struct section_file *file,
@@ -6139,6 +6152,7 @@ bool load_rulesets(const char *restore, bool act)
 {
   // Trigger signals need to be cleared before loading rulesets
   script_server_trigger_signals_destroy();
+  ruleset_streams_free();
 
   if (load_rulesetdir(game.server.rulesetdir, act)) {
     return TRUE;
@@ -6193,6 +6207,7 @@ static void nullcheck_secfile_destroy(struct section_file *file)
 **************************************************************************/
 void rulesets_deinit(void)
 {
+  ruleset_streams_free();
   script_server_trigger_signals_destroy();
   script_server_free();
   requirement_vector_free(&reqs_list);
@@ -6364,10 +6379,87 @@ bool reload_rulesets_settings(void)
   return ok;
 }
 
+/**************************************************************************
+  Free the recorded streams of ruleset packets. They must not be sent
+  again once the rulesets change.
+**************************************************************************/
+static void ruleset_streams_free(void)
+{
+  if (NULL != ruleset_streams) {
+    packet_stream_list_iterate(ruleset_streams, pstream) {
+      packet_stream_destroy(pstream);
+    } packet_stream_list_iterate_end;
+    packet_stream_list_destroy(ruleset_streams);
+    ruleset_streams = NULL;
+  }
+}
+
+/**************************************************************************
+  Return the recorded stream of ruleset packets for connections with the
+  given capability string, or NULL if there is none.
+**************************************************************************/
+static struct packet_stream *ruleset_stream_find(const char *capability)
+{
+  if (NULL != ruleset_streams) {
+    packet_stream_list_iterate(ruleset_streams, pstream) {
+      if (0 == strcmp(packet_stream_capability(pstream), capability)) {
+        return pstream;
+      }
+    } packet_stream_list_iterate_end;
+  }
+
+  return NULL;
+}
+
 /**************************************************************************
   Send all ruleset information to the specified connections.
+
+  The packets sent to the first new connection of each capability string
+  are recorded, and sent as they are to the next new connections with the
+  same capability string, without building and encoding them again.
 **************************************************************************/
 void send_rulesets(struct conn_list *dest)
+{
+  struct conn_list *uncached = conn_list_new();
+  struct connection *precord = NULL;
+
+  conn_list_iterate(dest, pconn) {
+    struct packet_stream *pstream = ruleset_stream_find(pconn->capability);
+
+    if (NULL == pstream || !packet_stream_send(pstream, pconn)) {
+      conn_list_append(uncached, pconn);
+      if (NULL == pstream && NULL == precord) {
+        precord = pconn;
+      }
+    }
+  } conn_list_iterate_end;
+
+  if (0 < conn_list_size(uncached)) {
+    if (NULL != precord) {
+      packet_stream_record_start(precord);
+    }
+
+    send_rulesets_packets(uncached);
+
+    if (NULL != precord) {
+      struct packet_stream *pstream = packet_stream_record_stop(precord);
+
+      if (NULL != pstream) {
+        if (NULL == ruleset_streams) {
+          ruleset_streams = packet_stream_list_new();
+        }
+        packet_stream_list_append(ruleset_streams, pstream);
+      }
+    }
+  }
+
+  conn_list_destroy(uncached);
+}
+
+/**************************************************************************
+  Build and send all ruleset packets to the specified connections.
+**************************************************************************/
+static void send_rulesets_packets(struct conn_list *dest)
 {
   conn_list_compression_freeze(dest);
 
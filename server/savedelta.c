@@ -0,0 +1,192 @@
+/**********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+
+/*
+  Delta autosaves.
+
+  With the 'savedeltas' setting above zero, only every (savedeltas + 1)th
+  turn autosave is written as a full savegame. The ones in between only
+  contain the entries which differ from that last full save, plus the
+  section [savedelta]:
+
+    base    - file name of the full save, which has to be in the same
+              directory as the delta save
+    turn    - turn of the full save
+    removed - paths of the entries of the full save which no longer exist
+
+  Loading a delta save loads the full save and applies the changes to it,
+  see savedelta_apply(). The result is the same as loading a full save of
+  that turn.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <fc_config.h>
+#endif
+
+#include <string.h>
+
+/* utility */
+#include "log.h"
+#include "mem.h"
+#include "registry.h"
+#include "shared.h"
+#include "string_vector.h"
+#include "support.h"
+
+/* common */
+#include "game.h"
+
+#include "savedelta.h"
+
+/* The last full turn autosave, which following delta saves refer to. */
+static struct {
+  struct section_file *file;    /* Contents of the full save. */
+  char filename[512];           /* Its file name without directory. */
+  int turn;
+  int deltas;                   /* Delta saves written since. */
+} base = { NULL, "", 0, 0 };
+
+/****************************************************************************
+  Forget the full save; the next autosave will be a full one.
+****************************************************************************/
+void savedelta_free(void)
+{
+  if (NULL != base.file) {
+    secfile_destroy(base.file);
+    base.file = NULL;
+  }
+  base.filename[0] = '\0';
+  base.deltas = 0;
+}
+
+/****************************************************************************
+  Remember 'file' written as 'filepath' as the full save later delta saves
+  are based on. Takes ownership of 'file'.
+****************************************************************************/
+void savedelta_set_base(struct section_file *file, const char *filepath)
+{
+  const char *filename = strrchr(filepath, '/');
+
+  savedelta_free();
+
+  if (0 >= game.server.save_deltas) {
+    /* No delta saves wanted; don't keep the whole game in memory. */
+    secfile_destroy(file);
+    return;
+  }
+
+  base.file = file;
+  sz_strlcpy(base.filename, NULL != filename ? filename + 1 : filepath);
+  base.turn = game.info.turn;
+}
+
+/****************************************************************************
+  Return the delta save for the complete savegame 'file', or NULL if the
+  autosave should be a full one.
+****************************************************************************/
+struct section_file *savedelta_new(const struct section_file *file)
+{
+  struct section_file *delta;
+  struct strvec *removed;
+
+  if (NULL == base.file || base.deltas >= game.server.save_deltas) {
+    return NULL;
+  }
+
+  delta = secfile_new(TRUE);
+  removed = strvec_new();
+
+  secfile_diff(base.file, file, delta, removed);
+
+  secfile_insert_str(delta, base.filename, "savedelta.base");
+  secfile_insert_int(delta, base.turn, "savedelta.turn");
+  if (0 < strvec_size(removed)) {
+    secfile_insert_str_vec(delta, strvec_data(removed), strvec_size(removed),
+                           "savedelta.removed");
+  }
+  strvec_destroy(removed);
+
+  base.deltas++;
+
+  return delta;
+}
+
+/****************************************************************************
+  Returns TRUE iff 'file' is a delta save.
+****************************************************************************/
+bool savedelta_is_delta(const struct section_file *file)
+{
+  return NULL != secfile_section_by_name(file, "savedelta");
+}
+
+/****************************************************************************
+  Build the complete savegame from the delta save 'delta' loaded from
+  'filepath'. Returns NULL on failure.
+****************************************************************************/
+struct section_file *savedelta_apply(const struct section_file *delta,
+                                     const char *filepath)
+{
+  const char *base_name = secfile_lookup_str(delta, "savedelta.base");
+  const char **removed_paths;
+  struct section_file *file;
+  struct strvec *removed;
+  char base_path[1024];
+  const char *dir_end;
+  size_t nremoved = 0;
+  bool success;
+
+  if (NULL == base_name || NULL != strchr(base_name, '/')) {
+    log_error("Invalid delta save %s.", filepath);
+    return NULL;
+  }
+
+  /* The full save is next to the delta save. */
+  dir_end = strrchr(filepath, '/');
+  if (NULL != dir_end) {
+    fc_strlcpy(base_path, filepath,
+               MIN(sizeof(base_path), dir_end - filepath + 2));
+  } else {
+    base_path[0] = '\0';
+  }
+  sz_strlcat(base_path, base_name);
+
+  file = secfile_load(base_path, FALSE);
+  if (NULL == file) {
+    log_error("Could not load the full save %s of delta save %s: %s",
+              base_path, filepath, secfile_error());
+    return NULL;
+  }
+
+  removed = strvec_new();
+  removed_paths = secfile_lookup_str_vec(delta, &nremoved,
+                                         "savedelta.removed");
+  if (NULL != removed_paths) {
+    strvec_store(removed, removed_paths, nremoved);
+    free(removed_paths);
+  }
+
+  success = secfile_patch(file, delta, removed);
+  strvec_destroy(removed);
+
+  if (!success) {
+    log_error("Could not apply delta save %s: %s",
+              filepath, secfile_error());
+    secfile_destroy(file);
+    return NULL;
+  }
+
+  /* Not part of the savegame itself. */
+  section_destroy(secfile_section_by_name(file, "savedelta"));
+
+  return file;
+}
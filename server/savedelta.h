@@ -0,0 +1,30 @@
+/**********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+#ifndef FC__SAVEDELTA_H
+#define FC__SAVEDELTA_H
+
+/* utility */
+#include "support.h"            /* bool type */
+
+struct section_file;
+
+void savedelta_free(void);
+
+void savedelta_set_base(struct section_file *file, const char *filepath);
+struct section_file *savedelta_new(const struct section_file *file);
+
+bool savedelta_is_delta(const struct section_file *file);
+struct section_file *savedelta_apply(const struct section_file *delta,
+                                     const char *filepath);
+
+#endif /* FC__SAVEDELTA_H */
@@ -4454,6 +4454,7 @@ static void game_load_internal(struct section_file *file)
     apply_unit_ordering();
 
     /* all vision is ready */
+    map_invalidate_borders();
     map_calculate_borders(); /* does city_thaw_workers_queue() */
     /* city_refresh() below */
 
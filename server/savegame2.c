@@ -104,6 +104,7 @@
 /* utility */
 #include "bitvector.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "idex.h"
 #include "log.h"
 #include "mem.h"
@@ -391,8 +392,31 @@ struct savedata {
 
   /* Set in sg_save_game(); needed in sg_save_map_*(); ... */
   bool save_players;
+
+  /* Parts of the savegame which are built by sg_save_jobs_run(). */
+  struct sg_save_job_list *jobs;
+};
+
+/* A part of the savegame which only reads the game state. It is written
+ * into its own section file, possibly on a worker thread, and appended to
+ * the main file in the order the jobs were added. The result is the same
+ * as if the part had been saved in place, as long as the sections it
+ * writes to already exist in the main file and do not get any entries
+ * added by later parts. See sg_save_job_map() and sg_save_job_player(). */
+struct sg_save_job {
+  struct savedata saving;       /* 'saving.file' is the job's own file. */
+  void (*save_map)(struct savedata *saving);
+  void (*save_player)(struct savedata *saving, struct player *plr);
+  struct player *plr;
 };
 
+#define SPECLIST_TAG sg_save_job
+#define SPECLIST_TYPE struct sg_save_job
+#include "speclist.h"
+#define sg_save_job_list_iterate(joblist, pjob) \
+  TYPED_LIST_ITERATE(struct sg_save_job, joblist, pjob)
+#define sg_save_job_list_iterate_end LIST_ITERATE_END
+
 #define TOKEN_SIZE 10
 
 #define log_worker      log_verbose
@@ -492,6 +516,8 @@ static void sg_load_map_tiles_specials(struct loaddata *loading,
                                        bool rivers_overlay);
 static void sg_save_map_tiles_specials(struct savedata *saving,
                                        bool rivers_overlay);
+static void sg_save_map_tiles_specials_all(struct savedata *saving);
+static void sg_save_map_tiles_rivers_overlay(struct savedata *saving);
 static void sg_load_map_tiles_resources(struct loaddata *loading);
 static void sg_save_map_tiles_resources(struct savedata *saving);
 
@@ -558,6 +584,14 @@ static void sg_save_mapimg(struct savedata *saving);
 static void sg_load_sanitycheck(struct loaddata *loading);
 static void sg_save_sanitycheck(struct savedata *saving);
 
+static void sg_save_job_map(struct savedata *saving,
+                            void (*save_map)(struct savedata *saving));
+static void sg_save_job_player(struct savedata *saving,
+                               void (*save_player)(struct savedata *saving,
+                                                   struct player *plr),
+                               struct player *plr);
+static void sg_save_jobs_run(struct savedata *saving);
+
 
 
 typedef void (*load_version_func_t) (struct loaddata *loading);
@@ -634,6 +668,9 @@ void savegame2_load(struct section_file *file)
     savegame2_load_real(file);
   }
 
+  /* The loaders set wonders and known techs directly. */
+  requirement_cache_invalidate();
+
 #ifdef DEBUG_TIMERS
   timer_stop(loadtimer);
   log_debug("Loading secfile in %.3f seconds.", timer_read_seconds(loadtimer));
@@ -767,6 +804,9 @@ static void savegame2_save_real(struct section_file *file,
   /* [mapimg] */
   sg_save_mapimg(saving);
 
+  /* Parts of [map] and [player<i>] queued above. */
+  sg_save_jobs_run(saving);
+
   /* Sanity checks for the saved game. */
   sg_save_sanitycheck(saving);
 
@@ -859,6 +899,8 @@ struct savedata *savedata_new(struct section_file *file,
 
   saving->save_players = FALSE;
 
+  saving->jobs = sg_save_job_list_new();
+
   return saving;
 }
 
@@ -867,6 +909,7 @@ struct savedata *savedata_new(struct section_file *file,
 ****************************************************************************/
 void savedata_destroy(struct savedata *saving)
 {
+  sg_save_job_list_destroy(saving->jobs);
   free(saving);
 }
 
@@ -2566,27 +2609,29 @@ static void sg_save_map(struct savedata *saving)
     secfile_insert_bool(saving->file, TRUE, "map.have_huts");
   }
 
-  sg_save_map_tiles(saving);
-  sg_save_map_startpos(saving);
-  sg_save_map_tiles_bases(saving);
-  sg_save_map_tiles_roads(saving);
+  /* The map layers are independent of each other; build them in
+   * sg_save_jobs_run(). */
+  sg_save_job_map(saving, sg_save_map_tiles);
+  sg_save_job_map(saving, sg_save_map_startpos);
+  sg_save_job_map(saving, sg_save_map_tiles_bases);
+  sg_save_job_map(saving, sg_save_map_tiles_roads);
   if (!map.server.have_resources) {
     if (map.server.have_rivers_overlay) {
       /* Save the rivers overlay map; this is a special case to allow
        * re-saving scenarios which have rivers overlay data. This only
        * applies if you don't have the rest of the specials. */
       sg_save_savefile_options(saving, " riversoverlay");
-      sg_save_map_tiles_specials(saving, TRUE);
+      sg_save_job_map(saving, sg_save_map_tiles_rivers_overlay);
     }
   } else {
     sg_save_savefile_options(saving, " specials");
-    sg_save_map_tiles_specials(saving, FALSE);
-    sg_save_map_tiles_resources(saving);
+    sg_save_job_map(saving, sg_save_map_tiles_specials_all);
+    sg_save_job_map(saving, sg_save_map_tiles_resources);
   }
 
-  sg_save_map_owner(saving);
-  sg_save_map_worked(saving);
-  sg_save_map_known(saving);
+  sg_save_job_map(saving, sg_save_map_owner);
+  sg_save_job_map(saving, sg_save_map_worked);
+  sg_save_job_map(saving, sg_save_map_known);
 }
 
 /****************************************************************************
@@ -2797,6 +2842,22 @@ static void sg_save_map_tiles_specials(struct savedata *saving,
   } halfbyte_iterate_special_end;
 }
 
+/****************************************************************************
+  Save all specials on map.
+****************************************************************************/
+static void sg_save_map_tiles_specials_all(struct savedata *saving)
+{
+  sg_save_map_tiles_specials(saving, FALSE);
+}
+
+/****************************************************************************
+  Save only the rivers overlay of the map.
+****************************************************************************/
+static void sg_save_map_tiles_rivers_overlay(struct savedata *saving)
+{
+  sg_save_map_tiles_specials(saving, TRUE);
+}
+
 /****************************************************************************
   Load information about resources on map.
 ****************************************************************************/
@@ -3661,6 +3722,7 @@ static void sg_load_players(struct loaddata *loading)
   unit_ordering_apply();
 
   /* All vision is ready; this calls city_thaw_workers_queue(). */
+  map_invalidate_borders();
   map_calculate_borders();
 
   /* Make sure everything is consistent. */
@@ -3743,7 +3805,9 @@ static void sg_save_players(struct savedata *saving)
     sg_save_player_cities(saving, pplayer);
     sg_save_player_units(saving, pplayer);
     sg_save_player_attributes(saving, pplayer);
-    sg_save_player_vision(saving, pplayer);
+    /* The private map is the last part of [player<i>] and by far the
+     * largest one; build it in sg_save_jobs_run(). */
+    sg_save_job_player(saving, sg_save_player_vision, pplayer);
   } players_iterate_end;
 }
 
@@ -6465,6 +6529,106 @@ static void sg_save_sanitycheck(struct savedata *saving)
   sg_check_ret();
 }
 
+/* =======================================================================
+ * Save jobs; parts of the savegame built in parallel.
+ * ======================================================================= */
+
+/****************************************************************************
+  Create a new save job writing into its own section file.
+****************************************************************************/
+static struct sg_save_job *sg_save_job_new(struct savedata *saving)
+{
+  struct sg_save_job *pjob = fc_calloc(1, sizeof(*pjob));
+
+  pjob->saving = *saving;
+  pjob->saving.file = secfile_new(TRUE);
+  pjob->saving.jobs = NULL;
+
+  sg_save_job_list_append(saving->jobs, pjob);
+
+  return pjob;
+}
+
+/****************************************************************************
+  Queue a map part of the savegame.
+****************************************************************************/
+static void sg_save_job_map(struct savedata *saving,
+                            void (*save_map)(struct savedata *saving))
+{
+  struct sg_save_job *pjob;
+
+  /* Check status and return if not OK (sg_success != TRUE). */
+  sg_check_ret();
+
+  pjob = sg_save_job_new(saving);
+  pjob->save_map = save_map;
+}
+
+/****************************************************************************
+  Queue a player part of the savegame.
+****************************************************************************/
+static void sg_save_job_player(struct savedata *saving,
+                               void (*save_player)(struct savedata *saving,
+                                                   struct player *plr),
+                               struct player *plr)
+{
+  struct sg_save_job *pjob;
+
+  /* Check status and return if not OK (sg_success != TRUE). */
+  sg_check_ret();
+
+  pjob = sg_save_job_new(saving);
+  pjob->save_player = save_player;
+  pjob->plr = plr;
+}
+
+/****************************************************************************
+  Run one save job. Called by fc_thread_run_jobs(), possibly on a worker
+  thread.
+****************************************************************************/
+static void sg_save_job_exec(int index, void *data)
+{
+  struct sg_save_job *pjob = ((struct sg_save_job **) data)[index];
+
+  if (NULL != pjob->save_player) {
+    pjob->save_player(&pjob->saving, pjob->plr);
+  } else {
+    pjob->save_map(&pjob->saving);
+  }
+}
+
+/****************************************************************************
+  Build all queued parts of the savegame using 'workerthreads' threads and
+  append them to the main file in the order they were queued.
+****************************************************************************/
+static void sg_save_jobs_run(struct savedata *saving)
+{
+  int count = sg_save_job_list_size(saving->jobs);
+  struct sg_save_job **jobs = fc_calloc(MAX(count, 1), sizeof(*jobs));
+  int i = 0;
+
+  sg_save_job_list_iterate(saving->jobs, pjob) {
+    jobs[i++] = pjob;
+  } sg_save_job_list_iterate_end;
+
+  if (sg_success) {
+    fc_thread_run_jobs(game.server.worker_threads, count,
+                       sg_save_job_exec, jobs);
+  }
+
+  for (i = 0; i < count; i++) {
+    if (sg_success && !secfile_append(saving->file, jobs[i]->saving.file)) {
+      sg_success = FALSE;
+      log_sg("Failed to merge savegame parts: %s", secfile_error());
+    }
+    secfile_destroy(jobs[i]->saving.file);
+    free(jobs[i]);
+  }
+
+  sg_save_job_list_clear(saving->jobs);
+  free(jobs);
+}
+
 /* =======================================================================
  * Compatibility functions for loading a game.
  * ======================================================================= */
@@ -38,11 +38,16 @@
 #endif
 
 /* utility */
+#include "fcthread.h"
 #include "log.h"
 #include "md5.h"
+#include "mem.h"
 #include "registry.h"
 #include "string_vector.h"
 
+/* common */
+#include "connection.h"
+
 /* common/scriptcore */
 #include "luascript.h"
 #include "luascript_types.h"
@@ -64,8 +69,21 @@
 
 #define SCRIPT_FCDB_LUA_FILE "database.lua"
 
-static void script_fcdb_functions_define(void);
-static bool script_fcdb_functions_check(const char *fcdb_luafile);
+static struct fc_lua *script_fcdb_state_new(const char *fcdb_luafile);
+static void script_fcdb_state_destroy(struct fc_lua *lfcl);
+static enum fcdb_status script_fcdb_state_call(struct fc_lua *lfcl,
+                                               const char *func_name,
+                                               int nargs, ...);
+static enum fcdb_status script_fcdb_call_valist(struct fc_lua *lfcl,
+                                                const char *func_name,
+                                                int nargs, va_list args);
+static void script_fcdb_functions_define(struct fc_lua *lfcl);
+static bool script_fcdb_functions_check(struct fc_lua *lfcl,
+                                        const char *fcdb_luafile);
+
+static void script_fcdb_worker_start(const char *fcdb_luafile);
+static void script_fcdb_worker_stop(void);
+static void script_fcdb_worker_main(void *arg);
 
 static void script_fcdb_cmd_reply(struct fc_lua *lfcl, enum log_level level,
                                   const char *format, ...)
@@ -76,6 +94,44 @@ static void script_fcdb_cmd_reply(struct fc_lua *lfcl, enum log_level level,
 *****************************************************************************/
 static struct fc_lua *fcl = NULL;
 
+/*****************************************************************************
+  A call of a user function for a connection. The function is run on a
+  private copy of the connection, which holds only its name, address and
+  password, so that the real one is never touched off the main thread.
+*****************************************************************************/
+struct fcdb_request {
+  enum fcdb_user_func func;
+  bool success;                 /* Argument of user_log() */
+  int conn_id;
+  struct connection conn;
+  enum fcdb_status status;
+  fcdb_reply_fn reply;
+};
+
+#define SPECLIST_TAG fcdb_request
+#define SPECLIST_TYPE struct fcdb_request
+#include "speclist.h"
+
+#define fcdb_request_list_iterate(reqlist, preq)                            \
+  TYPED_LIST_ITERATE(struct fcdb_request, reqlist, preq)
+#define fcdb_request_list_iterate_end LIST_ITERATE_END
+
+/*****************************************************************************
+  The database thread, with its own Lua state and database connection. The
+  lists and the count of pending requests are guarded by the mutex.
+*****************************************************************************/
+static struct {
+  struct fc_lua *fcl;
+  fc_thread thread;
+  bool running;
+  bool quit;
+  fc_mutex mutex;
+  fc_thread_cond cond;
+  struct fcdb_request_list *requests;
+  struct fcdb_request_list *replies;
+  int pending;
+} worker;
+
 /*****************************************************************************
   Add fcdb callback functions; these must be defined in the lua script
   'database.lua':
@@ -96,29 +152,30 @@ static struct fc_lua *fcl = NULL;
   If the request was successful, FCDB_SUCCESS_TRUE is returned.
   If the request was not successful, FCDB_SUCCESS_FALSE is returned.
 *****************************************************************************/
-static void script_fcdb_functions_define(void)
+static void script_fcdb_functions_define(struct fc_lua *lfcl)
 {
-  luascript_func_add(fcl, "database_init", TRUE, 0);
-  luascript_func_add(fcl, "database_free", TRUE, 0);
+  luascript_func_add(lfcl, "database_init", TRUE, 0);
+  luascript_func_add(lfcl, "database_free", TRUE, 0);
 
-  luascript_func_add(fcl, "user_load", TRUE, 1,
+  luascript_func_add(lfcl, "user_load", TRUE, 1,
                      API_TYPE_CONNECTION);
-  luascript_func_add(fcl, "user_save", TRUE, 1,
+  luascript_func_add(lfcl, "user_save", TRUE, 1,
                      API_TYPE_CONNECTION);
-  luascript_func_add(fcl, "user_log", TRUE, 2,
+  luascript_func_add(lfcl, "user_log", TRUE, 2,
                      API_TYPE_CONNECTION, API_TYPE_BOOL);
 }
 
 /*****************************************************************************
   Check the existence of all needed functions.
 *****************************************************************************/
-static bool script_fcdb_functions_check(const char *fcdb_luafile)
+static bool script_fcdb_functions_check(struct fc_lua *lfcl,
+                                        const char *fcdb_luafile)
 {
   bool ret = TRUE;
   struct strvec *missing_func_required = strvec_new();
   struct strvec *missing_func_optional = strvec_new();
 
-  if (!luascript_func_check(fcl, missing_func_required,
+  if (!luascript_func_check(lfcl, missing_func_required,
                             missing_func_optional)) {
     strvec_iterate(missing_func_required, func_name) {
       log_error("Database script '%s' does not define the required function "
@@ -172,66 +229,251 @@ static void script_fcdb_cmd_reply(struct fc_lua *lfcl, enum log_level level,
 
   cmd_reply(CMD_FCDB, lfcl->caller, rfc_status, "%s", buf);
 }
-#endif /* HAVE_FCDB */
 
 /*****************************************************************************
-  Initialize the scripting state. Returns the status of the freeciv database
-  lua state.
+  Create a Lua state for the freeciv database, load the script and connect
+  to the database. Returns NULL on failure.
 *****************************************************************************/
-bool script_fcdb_init(const char *fcdb_luafile)
+static struct fc_lua *script_fcdb_state_new(const char *fcdb_luafile)
 {
-#ifdef HAVE_FCDB
-  if (fcl != NULL) {
-    fc_assert_ret_val(fcl->state != NULL, FALSE);
-
-    return TRUE;
-  }
+  struct fc_lua *lfcl = luascript_new(NULL);
 
-  if (!fcdb_luafile) {
-    /* Use default freeciv database lua file. */
-    fcdb_luafile = FC_CONF_PATH "/" SCRIPT_FCDB_LUA_FILE;
-  }
-
-  fcl = luascript_new(NULL);
-  if (fcl == NULL) {
+  if (lfcl == NULL) {
     log_error("Error loading the Freeciv database lua definition.");
-    return FALSE;
+    return NULL;
   }
 
-  tolua_common_a_open(fcl->state);
-  tolua_fcdb_open(fcl->state);
+  tolua_common_a_open(lfcl->state);
+  tolua_fcdb_open(lfcl->state);
 #ifdef HAVE_FCDB_MYSQL
-  luaL_requiref(fcl->state, "ls_mysql", luaopen_luasql_mysql, 1);
-  lua_pop(fcl->state, 1);
+  luaL_requiref(lfcl->state, "ls_mysql", luaopen_luasql_mysql, 1);
+  lua_pop(lfcl->state, 1);
 #endif
 #ifdef HAVE_FCDB_POSTGRES
-  luaL_requiref(fcl->state, "ls_postgres", luaopen_luasql_postgres, 1);
-  lua_pop(fcl->state, 1);
+  luaL_requiref(lfcl->state, "ls_postgres", luaopen_luasql_postgres, 1);
+  lua_pop(lfcl->state, 1);
 #endif
 #ifdef HAVE_FCDB_SQLITE3
-  luaL_requiref(fcl->state, "ls_sqlite3", luaopen_luasql_sqlite3, 1);
-  lua_pop(fcl->state, 1);
+  luaL_requiref(lfcl->state, "ls_sqlite3", luaopen_luasql_sqlite3, 1);
+  lua_pop(lfcl->state, 1);
 #endif
-  tolua_common_z_open(fcl->state);
+  tolua_common_z_open(lfcl->state);
 
-  luascript_func_init(fcl);
+  luascript_func_init(lfcl);
 
   /* Define the prototypes for the needed lua functions. */
-  script_fcdb_functions_define();
+  script_fcdb_functions_define(lfcl);
 
-  if (luascript_do_file(fcl, fcdb_luafile)
-      || !script_fcdb_functions_check(fcdb_luafile)) {
+  if (luascript_do_file(lfcl, fcdb_luafile)
+      || !script_fcdb_functions_check(lfcl, fcdb_luafile)) {
     log_error("Error loading the Freeciv database lua script '%s'.",
               fcdb_luafile);
-    script_fcdb_free();
-    return FALSE;
+    luascript_destroy(lfcl);
+    return NULL;
   }
 
-  if (script_fcdb_call("database_init", 0) != FCDB_SUCCESS_TRUE) {
+  if (script_fcdb_state_call(lfcl, "database_init", 0)
+      != FCDB_SUCCESS_TRUE) {
     log_error("Error connecting to the database");
-    script_fcdb_free();
+    luascript_destroy(lfcl);
+    return NULL;
+  }
+
+  return lfcl;
+}
+
+/*****************************************************************************
+  Close the database connection of the Lua state and free it.
+*****************************************************************************/
+static void script_fcdb_state_destroy(struct fc_lua *lfcl)
+{
+  if (script_fcdb_state_call(lfcl, "database_free", 0)
+      != FCDB_SUCCESS_TRUE) {
+    log_error("Error closing the database connection. Continuing anyway ...");
+  }
+
+  /* luascript_func_free() is called by luascript_destroy(). */
+  luascript_destroy(lfcl);
+}
+
+/*****************************************************************************
+  Call a lua function of the given Lua state.
+*****************************************************************************/
+static enum fcdb_status script_fcdb_state_call(struct fc_lua *lfcl,
+                                               const char *func_name,
+                                               int nargs, ...)
+{
+  enum fcdb_status status;
+  va_list args;
+
+  va_start(args, nargs);
+  status = script_fcdb_call_valist(lfcl, func_name, nargs, args);
+  va_end(args);
+
+  return status;
+}
+
+/*****************************************************************************
+  Call a lua function of the given Lua state, with the arguments as a
+  va_list.
+*****************************************************************************/
+static enum fcdb_status script_fcdb_call_valist(struct fc_lua *lfcl,
+                                                const char *func_name,
+                                                int nargs, va_list args)
+{
+  int ret;
+
+  if (luascript_func_call_valist(lfcl, func_name, &ret, nargs, args)
+      && fcdb_status_is_valid(ret)) {
+    return (enum fcdb_status) ret;
+  }
+
+  return FCDB_ERROR;
+}
+
+/*****************************************************************************
+  Run the user function of the request in the given Lua state.
+*****************************************************************************/
+static void script_fcdb_request_run(struct fc_lua *lfcl,
+                                    struct fcdb_request *preq)
+{
+  switch (preq->func) {
+  case FCDB_USER_LOAD:
+    preq->status = script_fcdb_state_call(lfcl, "user_load", 1,
+                                          API_TYPE_CONNECTION, &preq->conn);
+    return;
+  case FCDB_USER_SAVE:
+    preq->status = script_fcdb_state_call(lfcl, "user_save", 1,
+                                          API_TYPE_CONNECTION, &preq->conn);
+    return;
+  case FCDB_USER_LOG:
+    preq->status = script_fcdb_state_call(lfcl, "user_log", 2,
+                                          API_TYPE_CONNECTION, &preq->conn,
+                                          API_TYPE_BOOL, preq->success);
+    return;
+  }
+
+  fc_assert(FALSE);
+  preq->status = FCDB_ERROR;
+}
+
+/*****************************************************************************
+  Main function of the database thread: run the requests in order until
+  told to quit. The requests still queued then are run before quitting.
+*****************************************************************************/
+static void script_fcdb_worker_main(void *arg)
+{
+  fc_allocate_mutex(&worker.mutex);
+  while (TRUE) {
+    struct fcdb_request *preq;
+
+    if (fcdb_request_list_size(worker.requests) == 0) {
+      if (worker.quit) {
+        break;
+      }
+      fc_thread_cond_wait(&worker.cond, &worker.mutex);
+      continue;
+    }
+
+    preq = fcdb_request_list_front(worker.requests);
+    fcdb_request_list_pop_front(worker.requests);
+    fc_release_mutex(&worker.mutex);
+
+    script_fcdb_request_run(worker.fcl, preq);
+
+    fc_allocate_mutex(&worker.mutex);
+    fcdb_request_list_append(worker.replies, preq);
+  }
+  fc_release_mutex(&worker.mutex);
+}
+
+/*****************************************************************************
+  Start the database thread with a Lua state of its own. If that fails,
+  the requests are run on the main thread, in the worker's Lua state if
+  there is one.
+*****************************************************************************/
+static void script_fcdb_worker_start(const char *fcdb_luafile)
+{
+  worker.requests = fcdb_request_list_new();
+  worker.replies = fcdb_request_list_new();
+  worker.pending = 0;
+  worker.quit = FALSE;
+  worker.running = FALSE;
+  fc_init_mutex(&worker.mutex);
+  fc_thread_cond_init(&worker.cond);
+
+  worker.fcl = script_fcdb_state_new(fcdb_luafile);
+  if (worker.fcl == NULL) {
+    log_error("Database requests will be run on the main thread.");
+    return;
+  }
+
+  if (has_thread_cond_impl()
+      && fc_thread_start(&worker.thread, script_fcdb_worker_main,
+                         NULL) == 0) {
+    worker.running = TRUE;
+  } else {
+    log_verbose("No database thread, running the requests on the main "
+                "thread.");
+  }
+}
+
+/*****************************************************************************
+  Stop the database thread once it has run the queued requests, deliver
+  the last replies and free the worker.
+*****************************************************************************/
+static void script_fcdb_worker_stop(void)
+{
+  if (worker.running) {
+    fc_allocate_mutex(&worker.mutex);
+    worker.quit = TRUE;
+    fc_thread_cond_signal(&worker.cond);
+    fc_release_mutex(&worker.mutex);
+
+    fc_thread_wait(&worker.thread);
+    worker.running = FALSE;
+  }
+
+  script_fcdb_replies();
+
+  if (worker.fcl != NULL) {
+    script_fcdb_state_destroy(worker.fcl);
+    worker.fcl = NULL;
+  }
+
+  fcdb_request_list_destroy(worker.requests);
+  fcdb_request_list_destroy(worker.replies);
+  worker.requests = NULL;
+  worker.replies = NULL;
+  fc_thread_cond_destroy(&worker.cond);
+  fc_destroy_mutex(&worker.mutex);
+}
+#endif /* HAVE_FCDB */
+
+/*****************************************************************************
+  Initialize the scripting state. Returns the status of the freeciv database
+  lua state.
+*****************************************************************************/
+bool script_fcdb_init(const char *fcdb_luafile)
+{
+#ifdef HAVE_FCDB
+  if (fcl != NULL) {
+    fc_assert_ret_val(fcl->state != NULL, FALSE);
+
+    return TRUE;
+  }
+
+  if (!fcdb_luafile) {
+    /* Use default freeciv database lua file. */
+    fcdb_luafile = FC_CONF_PATH "/" SCRIPT_FCDB_LUA_FILE;
+  }
+
+  fcl = script_fcdb_state_new(fcdb_luafile);
+  if (fcl == NULL) {
     return FALSE;
   }
+
+  script_fcdb_worker_start(fcdb_luafile);
 #endif /* HAVE_FCDB */
 
   return TRUE;
@@ -246,19 +488,13 @@ bool script_fcdb_init(const char *fcdb_luafile)
 enum fcdb_status script_fcdb_call(const char *func_name, int nargs, ...)
 {
 #ifdef HAVE_FCDB
-  enum fcdb_status status = FCDB_ERROR; /* Default return value. */
-  bool success;
-  int ret;
-
+  enum fcdb_status status;
   va_list args;
+
   va_start(args, nargs);
-  success = luascript_func_call_valist(fcl, func_name, &ret, nargs, args);
+  status = script_fcdb_call_valist(fcl, func_name, nargs, args);
   va_end(args);
 
-  if (success && fcdb_status_is_valid(ret)) {
-    status = (enum fcdb_status) ret;
-  }
-
   return status;
 #else
   return FCDB_SUCCESS_TRUE;
@@ -266,18 +502,122 @@ enum fcdb_status script_fcdb_call(const char *func_name, int nargs, ...)
 }
 
 /*****************************************************************************
-  Free the scripting data.
+  Call the user function for the connection on the database thread. The
+  reply, if not NULL, is called from script_fcdb_replies() with the result.
 *****************************************************************************/
-void script_fcdb_free(void)
+void script_fcdb_call_async(enum fcdb_user_func func,
+                            struct connection *pconn, bool success,
+                            fcdb_reply_fn reply)
 {
 #ifdef HAVE_FCDB
-  if (script_fcdb_call("database_free", 0) != FCDB_SUCCESS_TRUE) {
-    log_error("Error closing the database connection. Continuing anyway ...");
+  struct fcdb_request *preq;
+
+  if (fcl == NULL) {
+    /* The database script failed to load. */
+    if (reply != NULL) {
+      reply(pconn, FCDB_ERROR, pconn->server.password);
+    }
+    return;
+  }
+
+  preq = fc_calloc(1, sizeof(*preq));
+  preq->func = func;
+  preq->success = success;
+  preq->conn_id = pconn->id;
+  preq->conn.used = TRUE;       /* Checked by the fcdb API. */
+  sz_strlcpy(preq->conn.username, pconn->username);
+  sz_strlcpy(preq->conn.server.ipaddr, pconn->server.ipaddr);
+  sz_strlcpy(preq->conn.server.password, pconn->server.password);
+  preq->status = FCDB_ERROR;
+  preq->reply = reply;
+
+  if (worker.running) {
+    fc_allocate_mutex(&worker.mutex);
+    fcdb_request_list_append(worker.requests, preq);
+    worker.pending++;
+    fc_thread_cond_signal(&worker.cond);
+    fc_release_mutex(&worker.mutex);
+  } else {
+    /* Answer right away, but still deliver the reply from the main loop
+     * like the thread does. */
+    script_fcdb_request_run(worker.fcl != NULL ? worker.fcl : fcl, preq);
+    fcdb_request_list_append(worker.replies, preq);
+    worker.pending++;
+  }
+#else
+  if (reply != NULL) {
+    reply(pconn, FCDB_SUCCESS_TRUE, pconn->server.password);
+  }
+#endif /* HAVE_FCDB */
+}
+
+/*****************************************************************************
+  Return whether some requests have not got their reply yet.
+*****************************************************************************/
+bool script_fcdb_pending(void)
+{
+#ifdef HAVE_FCDB
+  bool pending;
+
+  if (fcl == NULL) {
+    return FALSE;
   }
 
+  fc_allocate_mutex(&worker.mutex);
+  pending = (worker.pending > 0);
+  fc_release_mutex(&worker.mutex);
+
+  return pending;
+#else
+  return FALSE;
+#endif /* HAVE_FCDB */
+}
+
+/*****************************************************************************
+  Call the replies of the requests answered by the database thread. The
+  replies for connections which have been closed since are dropped.
+*****************************************************************************/
+void script_fcdb_replies(void)
+{
+#ifdef HAVE_FCDB
+  struct fcdb_request_list *replies;
+
+  if (worker.replies == NULL) {
+    return;
+  }
+
+  fc_allocate_mutex(&worker.mutex);
+  if (fcdb_request_list_size(worker.replies) == 0) {
+    fc_release_mutex(&worker.mutex);
+    return;
+  }
+  replies = worker.replies;
+  worker.replies = fcdb_request_list_new();
+  worker.pending -= fcdb_request_list_size(replies);
+  fc_release_mutex(&worker.mutex);
+
+  fcdb_request_list_iterate(replies, preq) {
+    struct connection *pconn = conn_by_number(preq->conn_id);
+
+    if (preq->reply != NULL && pconn != NULL
+        && !pconn->server.is_closing) {
+      preq->reply(pconn, preq->status, preq->conn.server.password);
+    }
+    free(preq);
+  } fcdb_request_list_iterate_end;
+  fcdb_request_list_destroy(replies);
+#endif /* HAVE_FCDB */
+}
+
+/*****************************************************************************
+  Free the scripting data.
+*****************************************************************************/
+void script_fcdb_free(void)
+{
+#ifdef HAVE_FCDB
   if (fcl) {
-    /* luascript_func_free() is called by luascript_destroy(). */
-    luascript_destroy(fcl);
+    script_fcdb_worker_stop();
+    script_fcdb_state_destroy(fcl);
     fcl = NULL;
   }
 #endif /* HAVE_FCDB */
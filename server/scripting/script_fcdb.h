@@ -37,4 +37,24 @@ void script_fcdb_free(void);
 
 bool script_fcdb_do_string(struct connection *caller, const char *str);
 
+/* The user functions may also be called on the database thread, so that a
+ * slow database does not stall the server. The reply is called later on
+ * the main thread, from script_fcdb_replies(), unless the connection has
+ * gone away in the meantime. It gets the password the script has set. */
+enum fcdb_user_func {
+  FCDB_USER_LOAD,
+  FCDB_USER_SAVE,
+  FCDB_USER_LOG
+};
+
+typedef void (*fcdb_reply_fn)(struct connection *pconn,
+                              enum fcdb_status status,
+                              const char *password);
+
+void script_fcdb_call_async(enum fcdb_user_func func,
+                            struct connection *pconn, bool success,
+                            fcdb_reply_fn reply);
+bool script_fcdb_pending(void);
+void script_fcdb_replies(void);
+
 #endif /* FC__SCRIPT_FCDB_H */
@@ -95,6 +95,9 @@
 #include "stdinhand.h"
 #include "voting.h"
 
+/* server/scripting */
+#include "script_fcdb.h"
+
 #include "sernet.h"
 
 static struct connection connections[MAX_NUM_CONNECTIONS];
@@ -218,6 +221,12 @@ static void close_connection(struct connection *pconn)
   conn_pattern_list_destroy(pconn->server.ignore_list);
   pconn->server.ignore_list = NULL;
 
+  if (pconn->server.tile_block != NULL) {
+    free(pconn->server.tile_block);
+    pconn->server.tile_block = NULL;
+  }
+  dbv_free(&pconn->server.tiles_in_blocks);
+
   /* safe to do these even if not in lists: */
   conn_list_remove(game.all_connections, pconn);
   conn_list_remove(game.est_connections, pconn);
@@ -627,6 +636,9 @@ enum server_events server_sniff_all_input(void)
       game.server.last_ping = time(NULL);
     }
 
+    /* go on with the logins the database has answered */
+    script_fcdb_replies();
+
     /* if we've waited long enough after a failure, respond to the client */
     conn_list_iterate(game.all_connections, pconn) {
       if (srvarg.auth_enabled
@@ -643,8 +655,14 @@ enum server_events server_sniff_all_input(void)
       return S_E_END_OF_TURN_TIMEOUT;
     }
 
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
+    if (script_fcdb_pending()) {
+      /* come back soon for the answers of the database */
+      tv.tv_sec = 0;
+      tv.tv_usec = 20000;
+    } else {
+      tv.tv_sec = 1;
+      tv.tv_usec = 0;
+    }
 
     FC_FD_ZERO(&readfs);
     FC_FD_ZERO(&writefs);
@@ -1040,6 +1058,10 @@ int server_make_connection(int new_sock, const char *client_addr, const char *cl
       pconn->server.ignore_list =
           conn_pattern_list_new_full(conn_pattern_destroy);
       pconn->server.is_closing = FALSE;
+      pconn->server.tile_block = NULL;
+      pconn->server.tiles_in_blocks.vec = NULL;
+      pconn->server.tiles_in_blocks.bits = 0;
+      pconn->server.tile_blocks = FALSE;
       pconn->ping_time = -1.0;
       pconn->incoming_packet_notify = NULL;
       pconn->outgoing_packet_notify = NULL;
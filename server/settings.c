@@ -2410,6 +2410,19 @@ static struct setting settings[] = {
              "includes \"New turn\"."), NULL, NULL,
           GAME_MIN_SAVETURNS, GAME_MAX_SAVETURNS, GAME_DEFAULT_SAVETURNS)
 
+  GEN_INT("savedeltas", game.server.save_deltas,
+          SSET_META, SSET_INTERNAL, SSET_RARE, SSET_SERVER_ONLY,
+          N_("Delta auto-saves between full auto-saves"),
+          /* TRANS: The string between double quotes is also translated
+           * separately (it must match!). */
+          N_("If this is greater than zero, only every (savedeltas + 1)th "
+             "\"New turn\" auto-save is a complete savegame. The ones in "
+             "between only record what changed since that complete save, "
+             "which must be kept in the same directory to load them. "
+             "A server restart always begins with a complete save."),
+          NULL, NULL, GAME_MIN_SAVEDELTAS, GAME_MAX_SAVEDELTAS,
+          GAME_DEFAULT_SAVEDELTAS)
+
   GEN_BITWISE("autosaves", game.server.autosaves,
               SSET_META, SSET_INTERNAL, SSET_VITAL, SSET_SERVER_ONLY,
               N_("Which savegames are generated automatically"),
@@ -2444,6 +2457,31 @@ static struct setting settings[] = {
            N_("Compression library to use for savegames."),
            NULL, NULL, NULL, compresstype_name, GAME_DEFAULT_COMPRESS_TYPE)
 
+  GEN_INT("workerthreads", game.server.worker_threads,
+          SSET_META, SSET_INTERNAL, SSET_RARE, SSET_SERVER_ONLY,
+          N_("Number of worker threads"),
+          N_("How many threads the server may use for work which can be "
+             "split into independent parts, such as building the map and "
+             "player sections of a savegame, the per-tile passes of the "
+             "map generator, drawing map images or evaluating the tile "
+             "improvements around the cities of the AI players. With 1, "
+             "all the work is done by the main thread. The result does "
+             "not depend on this setting."),
+          NULL, NULL, GAME_MIN_WORKER_THREADS, GAME_MAX_WORKER_THREADS,
+          GAME_DEFAULT_WORKER_THREADS)
+
+  GEN_BOOL("mapimgbackground", game.server.mapimg_background,
+           SSET_META, SSET_INTERNAL, SSET_RARE, SSET_SERVER_ONLY,
+           N_("Write map images in the background"),
+           /* TRANS: The strings between single quotes are not to be
+            * translated. */
+           N_("If enabled, the map images defined with the 'mapimg' "
+              "command which are created at the end of each turn and use "
+              "the 'ppm' toolkit are only drawn before the next turn "
+              "starts; a background thread writes the files while the "
+              "game goes on."),
+           NULL, NULL, GAME_DEFAULT_MAPIMG_BACKGROUND)
+
   GEN_STRING("savename", game.server.save_name,
              SSET_META, SSET_INTERNAL, SSET_VITAL, SSET_SERVER_ONLY,
              N_("Definition of the save file name"),
@@ -64,6 +64,7 @@
 
 /* common/aicore */
 #include "citymap.h"
+#include "pf_regions.h"
 
 /* common */
 #include "capstr.h"
@@ -115,6 +116,7 @@
 #include "report.h"
 #include "ruleset.h"
 #include "sanitycheck.h"
+#include "savedelta.h"
 #include "savegame2.h"
 #include "score.h"
 #include "sernet.h"
@@ -140,6 +142,8 @@
 static void end_turn(void);
 static void announce_player(struct player *pplayer);
 static void fc_interface_init_server(void);
+static void save_game_real(const char *orig_filename, const char *save_reason,
+                           bool scenario, bool allow_delta);
 
 static enum known_type mapimg_server_tile_known(const struct tile *ptile,
                                                 const struct player *pplayer,
@@ -274,6 +278,7 @@ void srv_init(void)
 
   /* Initialize global mutexes */
   fc_init_mutex(&game.server.mutexes.city_list);
+  fc_init_mutex(&game.server.mutexes.infrastructure_cache);
 
   /* done */
   return;
@@ -848,12 +853,15 @@ static void kill_dying_players(void)
 **************************************************************************/
 static void ai_start_phase(void)
 {
+  bool was_send_city_suppressed = send_city_suppression(TRUE);
+
   phase_players_iterate(pplayer) {
     if (pplayer->ai_controlled) {
       CALL_PLR_AI_FUNC(first_activities, pplayer, pplayer);
     }
   } phase_players_iterate_end;
   kill_dying_players();
+  send_city_suppression(was_send_city_suppressed);
 }
 
 /**************************************************************************
@@ -947,6 +955,8 @@ static void begin_turn(bool is_new_turn)
 **************************************************************************/
 static void begin_phase(bool is_new_phase)
 {
+  bool was_send_city_suppressed;
+
   log_debug("Begin phase");
 
   conn_list_do_buffer(game.est_connections);
@@ -965,6 +975,9 @@ static void begin_phase(bool is_new_phase)
     CALL_PLR_AI_FUNC(phase_begin, pplayer, pplayer, is_new_phase);
   } phase_players_iterate_end;
 
+  /* Freeze sending of cities. */
+  was_send_city_suppressed = send_city_suppression(TRUE);
+
   if (is_new_phase) {
     /* Unit "end of turn" activities - of course these actually go at
      * the start of the turn! */
@@ -996,6 +1009,9 @@ static void begin_phase(bool is_new_phase)
     send_player_cities(pplayer);
   } phase_players_iterate_end;
 
+  /* Unfreeze sending of cities; each changed city is sent once. */
+  send_city_suppression(was_send_city_suppressed);
+
   flush_packets();  /* to curb major city spam */
   conn_list_do_unbuffer(game.est_connections);
 
@@ -1037,6 +1053,8 @@ static void begin_phase(bool is_new_phase)
 **************************************************************************/
 static void end_phase(void)
 {
+  bool was_send_city_suppressed;
+
   log_debug("Endphase");
 
   /* 
@@ -1069,7 +1087,7 @@ static void end_phase(void)
   } phase_players_iterate_end;
 
   /* Freeze sending of cities. */
-  send_city_suppression(TRUE);
+  was_send_city_suppressed = send_city_suppression(TRUE);
 
   /* AI end of turn activities */
   players_iterate(pplayer) {
@@ -1124,12 +1142,12 @@ static void end_phase(void)
 
   kill_dying_players();
 
-  /* Unfreeze sending of cities. */
-  send_city_suppression(FALSE);
-
   phase_players_iterate(pplayer) {
     send_player_cities(pplayer);
   } phase_players_iterate_end;
+
+  /* Unfreeze sending of cities; each changed city is sent once. */
+  send_city_suppression(was_send_city_suppressed);
   flush_packets();  /* to curb major city spam */
 
   do_reveal_effects();
@@ -1247,10 +1265,20 @@ static void end_turn(void)
 **************************************************************************/
 void save_game(const char *orig_filename, const char *save_reason,
                bool scenario)
+{
+  save_game_real(orig_filename, save_reason, scenario, FALSE);
+}
+
+/**************************************************************************
+  Save the game. If 'allow_delta' is set, this may be a delta save (see
+  savedelta.c) and a complete save becomes the base of later delta saves.
+**************************************************************************/
+static void save_game_real(const char *orig_filename, const char *save_reason,
+                           bool scenario, bool allow_delta)
 {
   char filepath[600];
   char *dot, *filename;
-  struct section_file *file;
+  struct section_file *file, *delta = NULL;
   struct timer *timer_cpu, *timer_user;
 
   if (!orig_filename) {
@@ -1364,15 +1392,35 @@ void save_game(const char *orig_filename, const char *save_reason,
     sz_strlcpy(filepath, tmpname);
   }
 
-  if (!secfile_save(file, filepath, game.server.save_compress_level,
+  if (allow_delta) {
+    delta = savedelta_new(file);
+  }
+
+  if (!secfile_save(NULL != delta ? delta : file, filepath,
+                    game.server.save_compress_level,
                     game.server.save_compress_type)) {
     con_write(C_FAIL, _("Failed saving game as %s"), filepath);
     log_error("Game saving failed: %s", secfile_error());
+    if (allow_delta) {
+      /* Start over with a complete save. */
+      savedelta_free();
+    }
+    secfile_destroy(file);
+  } else if (NULL != delta) {
+    con_write(C_OK, _("Game saved as %s (delta save)"), filepath);
+    secfile_destroy(file);
   } else {
     con_write(C_OK, _("Game saved as %s"), filepath);
+    if (allow_delta) {
+      savedelta_set_base(file, filepath);
+    } else {
+      secfile_destroy(file);
+    }
   }
 
-  secfile_destroy(file);
+  if (NULL != delta) {
+    secfile_destroy(delta);
+  }
 
 #ifdef LOG_TIMERS
   log_verbose("Save time: %g seconds (%g apparent)",
@@ -1416,7 +1464,7 @@ void save_game_auto(const char *save_reason, enum autosave_type type)
 
   generate_save_name(game.server.save_name, filename, sizeof(filename),
                      reason_filename);
-  save_game(filename, save_reason, FALSE);
+  save_game_real(filename, save_reason, FALSE, AS_TURN == type);
 }
 
 /**************************************************************************
@@ -1504,6 +1552,7 @@ void server_quit(void)
   timing_log_free();
   registry_module_close();
   fc_destroy_mutex(&game.server.mutexes.city_list);
+  fc_destroy_mutex(&game.server.mutexes.infrastructure_cache);
   free_libfreeciv();
   free_nls();
   con_log_close();
@@ -1614,6 +1663,7 @@ static bool is_client_edit_packet(int type)
 bool server_packet_input(struct connection *pconn, void *packet, int type)
 {
   struct player *pplayer;
+  bool was_send_city_suppressed;
 
   /* a NULL packet can be returned from receive_packet_goto_route() */
   if (!packet) {
@@ -1749,10 +1799,13 @@ bool server_packet_input(struct connection *pconn, void *packet, int type)
   /* Make sure to set this back to NULL before leaving this function: */
   pplayer->current_conn = pconn;
 
+  /* Send each city changed by the request once, when it is handled. */
+  was_send_city_suppressed = send_city_suppression(TRUE);
   if (!server_handle_packet(type, packet, pplayer, pconn)) {
     log_error("Received unknown packet %d from %s.",
               type, conn_description(pconn));
   }
+  send_city_suppression(was_send_city_suppressed);
 
   if (S_S_RUNNING == server_state()
       && type != PACKET_PLAYER_READY) {
@@ -2399,6 +2452,11 @@ static void srv_running(void)
   log_verbose("srv_running() mostly redundant send_server_settings()");
   send_server_settings(NULL);
 
+  /* The map is complete; from now on it only changes through the tile
+   * setters, which keep the path finding regions up to date. */
+  pf_regions_enable(TRUE);
+  game.callbacks.tile_changed = pf_regions_tile_changed;
+
   timer_start(eot_timer);
 
   /* 
@@ -2469,13 +2527,18 @@ static void srv_running(void)
 
         if (!skip_mapimg) {
           /* Save map image(s). */
+          mapimg_set_threads(game.server.worker_threads);
           for (i = 0; i < mapimg_count(); i++) {
             struct mapdef *pmapdef = mapimg_isvalid(i);
-            if (pmapdef != NULL) {
+            if (pmapdef == NULL) {
+              log_error("%s", mapimg_error());
+            } else if (game.server.mapimg_background) {
+              mapimg_create_background(pmapdef, FALSE,
+                                       game.server.save_name,
+                                       srvarg.saves_pathname);
+            } else {
               mapimg_create(pmapdef, FALSE, game.server.save_name,
                             srvarg.saves_pathname);
-            } else {
-              log_error("%s", mapimg_error());
             }
           }
         } else {
@@ -2942,6 +3005,12 @@ void server_game_free(void)
 {
   CALL_FUNC_EACH_AI(game_free);
 
+  /* Delta saves of another game must not refer to this one's saves. */
+  savedelta_free();
+
+  map_invalidate_borders();
+  free_infrastructure_cache();
+
   /* Free all the treaties that were left open when game finished. */
   free_treaties();
 
@@ -65,6 +65,7 @@
 #include "report.h"
 #include "ruleset.h"
 #include "sanitycheck.h"
+#include "savedelta.h"
 #include "savegame2.h"
 #include "score.h"
 #include "sernet.h"
@@ -3731,6 +3732,20 @@ bool load_command(struct connection *caller, const char *filename, bool check,
     return FALSE;
   }
 
+  if (savedelta_is_delta(file)) {
+    /* Rebuild the complete savegame from the full save it refers to. */
+    struct section_file *delta = file;
+
+    file = savedelta_apply(delta, arg);
+    secfile_destroy(delta);
+    if (NULL == file) {
+      cmd_reply(CMD_LOAD, caller, C_FAIL,
+                _("Could not load delta savefile: %s"), arg);
+      dlsend_packet_game_load(game.est_connections, TRUE, arg);
+      return FALSE;
+    }
+  }
+
   if (check) {
     return TRUE;
   }
@@ -5454,6 +5469,8 @@ static bool mapimg_command(struct connection *caller, char *arg, bool check)
       goto cleanup;
     }
 
+    mapimg_set_threads(game.server.worker_threads);
+
     if (strcmp(token[1], "all") == 0) {
       /* 'mapimg create all' */
       if (check) {
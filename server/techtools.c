@@ -993,6 +993,7 @@ void init_tech(struct player *plr, bool update)
       player_invention_set(plr, i, TECH_UNKNOWN);
       game.info.global_advances[i] = global_state[i];
     } advance_index_iterate_end;
+    requirement_cache_invalidate();
   }
 #endif /* TECH_UPKEEP_DEBUGGING */
 
@@ -113,6 +113,7 @@ static void wakeup_neighbor_sentries(struct unit *punit);
 static void do_upgrade_effects(struct player *pplayer);
 
 static bool maybe_cancel_patrol_due_to_enemy(struct unit *punit);
+static bool execute_orders_steps(struct unit *punit);
 static int hp_gain_coord(struct unit *punit);
 
 static bool maybe_become_veteran_real(struct unit *punit, bool settler);
@@ -3499,6 +3500,7 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost)
   int saved_id;
   bool unit_lives;
   bool adj;
+  bool path_progress;
   enum direction8 facing;
 
   /* Some checks. */
@@ -3525,9 +3527,17 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost)
   /* Wakup units next to us before we move. */
   wakeup_neighbor_sentries(punit);
 
+  /* An intermediate step of the unit's orders (the orders of the last
+   * step are cleared before the move, see execute_orders()). The clients
+   * which already know the unit at 'psrctile' only get the packet at
+   * 'pdesttile', which amounts to a position update. */
+  path_progress = (adj && NULL == ptransporter && unit_has_orders(punit));
+
   /* Make info packets at 'psrctile'. */
   if (adj) {
-    package_unit(punit, &src_info);
+    if (!path_progress) {
+      package_unit(punit, &src_info);
+    }
     package_short_unit(punit, &src_sinfo, UNIT_INFO_IDENTITY, 0, FALSE);
   }
 
@@ -3579,14 +3589,18 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost)
     /*  Main unit for adjacent move: the move is visible for every player
      * able to see on the matching unit layer. */
     enum vision_layer vlayer = is_hiding_unit(punit) ? V_INVIS : V_MAIN;
-
-    players_iterate(pplayer) {
-      if (map_is_known_and_seen(psrctile, pplayer, vlayer)
-          || map_is_known_and_seen(pdesttile, pplayer, vlayer)) {
-        BV_SET(pdata->can_see_unit, player_index(pplayer));
-        BV_SET(pdata->can_see_move, player_index(pplayer));
-      }
-    } players_iterate_end;
+    bv_player src_seen, dest_seen;
+
+    map_get_seen_players(psrctile, vlayer, &src_seen);
+    map_get_seen_players(pdesttile, vlayer, &dest_seen);
+    players_in_bv_iterate(src_seen, pplayer) {
+      BV_SET(pdata->can_see_unit, player_index(pplayer));
+      BV_SET(pdata->can_see_move, player_index(pplayer));
+    } players_in_bv_iterate_end;
+    players_in_bv_iterate(dest_seen, pplayer) {
+      BV_SET(pdata->can_see_unit, player_index(pplayer));
+      BV_SET(pdata->can_see_move, player_index(pplayer));
+    } players_in_bv_iterate_end;
   }
   unit_move_data_list_iterate(plist, pmove_data) {
     if (adj && pmove_data == pdata) {
@@ -3649,15 +3663,22 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost)
       if (aplayer == NULL) {
         if (pconn->observer) {
           /* Global observers see all... */
-          send_packet_unit_info(pconn, &src_info);
+          if (!path_progress) {
+            send_packet_unit_info(pconn, &src_info);
+          }
           send_packet_unit_info(pconn, &dest_info);
         }
       } else if (BV_ISSET(pdata->can_see_move, player_index(aplayer))) {
         if (aplayer == pplayer) {
-          send_packet_unit_info(pconn, &src_info);
+          if (!path_progress) {
+            send_packet_unit_info(pconn, &src_info);
+          }
           send_packet_unit_info(pconn, &dest_info);
         } else {
-          send_packet_unit_short_info(pconn, &src_sinfo);
+          if (!path_progress
+              || !can_player_see_unit_at(aplayer, punit, psrctile, FALSE)) {
+            send_packet_unit_short_info(pconn, &src_sinfo);
+          }
           send_packet_unit_short_info(pconn, &dest_sinfo);
         }
       }
@@ -3848,8 +3869,25 @@ static bool maybe_cancel_patrol_due_to_enemy(struct unit *punit)
   turn when the unit is back where it started, even if it have moves left.
 
   A unit will attack under orders only on its final action.
+
+  The packets of all the steps are buffered and sent together.
 ****************************************************************************/
 bool execute_orders(struct unit *punit)
+{
+  bool alive;
+
+  conn_list_do_buffer(game.est_connections);
+  alive = execute_orders_steps(punit);
+  conn_list_do_unbuffer(game.est_connections);
+
+  return alive;
+}
+
+/****************************************************************************
+  Helper for execute_orders(): executes the orders of the unit, until they
+  are complete, interrupted or the unit is done moving this turn.
+****************************************************************************/
+static bool execute_orders_steps(struct unit *punit)
 {
   struct tile *dst_tile;
   bool res, last_order;
@@ -18,6 +18,7 @@
 // utility
 #include "log.h"
 #include "mem.h"
+#include "shared.h"
 #include "support.h"
 
 #include "fcthread.h"
@@ -295,3 +296,141 @@ bool has_thread_cond_impl(void)
   return FALSE;
 #endif
 }
+
+/* Set while fc_thread_run_jobs() runs jobs on several threads. Only the
+ * thread which called it changes it, before the workers are started and
+ * after they have all finished, so the jobs may read it. */
+static bool jobs_running = FALSE;
+
+/* Depth of fc_thread_background_begin() calls not yet ended. Only the
+ * thread doing the background work changes it, and there is at most one
+ * such thread, so it always sees its own value. Others only read it to
+ * leave their caches alone; a late value there does no harm, as the
+ * background thread does not use them. */
+static int background_depth = 0;
+
+struct fc_thread_jobs {
+  fc_mutex mutex;
+  int next;
+  int count;
+  void (*job)(int index, void *data);
+  void *data;
+};
+
+/**********************************************************************
+  Worker for fc_thread_run_jobs(). Takes jobs until none is left.
+***********************************************************************/
+static void fc_thread_jobs_worker(void *arg)
+{
+  struct fc_thread_jobs *jobs = (struct fc_thread_jobs *) arg;
+
+  while (TRUE) {
+    int index;
+
+    fc_allocate_mutex(&jobs->mutex);
+    index = jobs->next++;
+    fc_release_mutex(&jobs->mutex);
+
+    if (index >= jobs->count) {
+      break;
+    }
+
+    jobs->job(index, jobs->data);
+  }
+}
+
+/**********************************************************************
+  Run job(0, data) ... job(num_jobs - 1, data) using at most num_threads
+  threads, the calling one included. Returns once all jobs are done.
+  The order in which the jobs are run is not defined, so each job has
+  to work on its own data.
+
+  A job may call this function again; the inner jobs are then run one
+  after the other by the job's thread, so that the threads do not
+  multiply. The same happens while background work runs, see
+  fc_thread_background_begin(). Apart from that, it must only be called
+  by the main thread.
+***********************************************************************/
+void fc_thread_run_jobs(int num_threads, int num_jobs,
+                        void (*job) (int index, void *data), void *data)
+{
+  struct fc_thread_jobs jobs;
+  fc_thread *threads;
+  int num_started = 0;
+  int i;
+
+  num_threads = MIN(num_threads, num_jobs);
+
+  if (num_threads <= 1 || jobs_running || background_depth > 0) {
+    /* Nothing to gain from threads, already on one of the workers, or
+     * another thread than the main one may be calling. */
+    for (i = 0; i < num_jobs; i++) {
+      job(i, data);
+    }
+    return;
+  }
+
+  jobs.next = 0;
+  jobs.count = num_jobs;
+  jobs.job = job;
+  jobs.data = data;
+  fc_init_mutex(&jobs.mutex);
+
+  jobs_running = TRUE;
+
+  threads = fc_calloc(num_threads - 1, sizeof(*threads));
+  for (i = 0; i < num_threads - 1; i++) {
+    if (fc_thread_start(&threads[num_started], fc_thread_jobs_worker,
+                        &jobs) == 0) {
+      num_started++;
+    } else {
+      log_error("Failed to start worker thread; continuing with %d.",
+                num_started + 1);
+    }
+  }
+
+  /* The calling thread takes its share, and all of them if no other
+   * thread could be started. */
+  fc_thread_jobs_worker(&jobs);
+
+  for (i = 0; i < num_started; i++) {
+    fc_thread_wait(&threads[i]);
+  }
+
+  free(threads);
+  fc_destroy_mutex(&jobs.mutex);
+
+  jobs_running = FALSE;
+}
+
+/**********************************************************************
+  Return TRUE while fc_thread_run_jobs() runs jobs on several threads,
+  or while background work runs. Code which keeps unsynchronized global
+  caches can check this to leave them alone meanwhile.
+***********************************************************************/
+bool fc_thread_jobs_running(void)
+{
+  return jobs_running || background_depth > 0;
+}
+
+/**********************************************************************
+  Called by a thread other than the main one before it runs game code
+  while the main thread goes on, such as the threaded AI planning a
+  player. Until the matching fc_thread_background_end(),
+  fc_thread_jobs_running() returns TRUE and fc_thread_run_jobs() runs
+  the jobs on the calling thread. Calls may nest.
+***********************************************************************/
+void fc_thread_background_begin(void)
+{
+  background_depth++;
+}
+
+/**********************************************************************
+  End the background work started by fc_thread_background_begin().
+***********************************************************************/
+void fc_thread_background_end(void)
+{
+  fc_assert_ret(background_depth > 0);
+
+  background_depth--;
+}
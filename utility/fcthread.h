@@ -70,6 +70,12 @@ void fc_thread_cond_signal(fc_thread_cond *cond);
 
 bool has_thread_cond_impl(void);
 
+void fc_thread_run_jobs(int num_threads, int num_jobs,
+                        void (*job) (int index, void *data), void *data);
+bool fc_thread_jobs_running(void);
+void fc_thread_background_begin(void);
+void fc_thread_background_end(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
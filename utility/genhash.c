@@ -541,6 +541,22 @@ size_t genhash_capacity(const struct genhash *pgenhash)
   return pgenhash->num_buckets;
 }
 
+/****************************************************************************
+  Returns a newly allocated empty genhash table, using the same functions
+  as the given one.
+****************************************************************************/
+struct genhash *genhash_copy_empty(const struct genhash *pgenhash)
+{
+  fc_assert_ret_val(NULL != pgenhash, NULL);
+
+  return genhash_new_nbuckets(pgenhash->key_val_func,
+                              pgenhash->key_comp_func,
+                              pgenhash->key_copy_func,
+                              pgenhash->key_free_func,
+                              pgenhash->data_copy_func,
+                              pgenhash->data_free_func, MIN_BUCKETS);
+}
+
 /****************************************************************************
   Returns a newly allocated mostly deep copy of the given genhash table.
 ****************************************************************************/
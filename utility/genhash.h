@@ -79,6 +79,8 @@ size_t genhash_capacity(const struct genhash *pgenhash);
 
 struct genhash *genhash_copy(const struct genhash *pgenhash)
                 fc__warn_unused_result;
+struct genhash *genhash_copy_empty(const struct genhash *pgenhash)
+                fc__warn_unused_result;
 void genhash_clear(struct genhash *pgenhash);
 
 bool genhash_insert(struct genhash *pgenhash, const void *key,
@@ -163,6 +163,7 @@
 #include "registry.h"
 #include "section_file.h"
 #include "shared.h"
+#include "string_vector.h"
 #include "support.h"
 
 #include "registry_ini.h"
@@ -177,6 +178,10 @@
 
 static inline bool entry_used(const struct entry *pentry);
 static inline void entry_use(struct entry *pentry);
+static struct entry *entry_copy(struct section *psection,
+                                const struct entry *pentry);
+static bool entry_equal(const struct entry *pentry1,
+                        const struct entry *pentry2);
 
 static void entry_to_file(const struct entry *pentry, fz_FILE *fs);
 static void entry_from_inf_token(struct section *psection, const char *name,
@@ -859,6 +864,158 @@ const char *secfile_name(const struct section_file *secfile)
   }
 }
 
+/**************************************************************************
+  Append copies of all sections and entries of 'src' to 'dest', keeping
+  their order. Entries of a section which already exists in 'dest' are
+  added after the entries already there. This allows to build parts of a
+  file separately (e.g. on other threads) and to assemble them later.
+  Returns TRUE on success.
+**************************************************************************/
+bool secfile_append(struct section_file *dest,
+                    const struct section_file *src)
+{
+  SECFILE_RETURN_VAL_IF_FAIL(dest, NULL, NULL != dest, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(src, NULL, NULL != src, FALSE);
+
+  section_list_iterate(src->sections, psrc) {
+    struct section *pdest = secfile_section_by_name(dest, psrc->name);
+
+    if (NULL == pdest) {
+      pdest = secfile_section_new(dest, psrc->name);
+      if (NULL == pdest) {
+        return FALSE;
+      }
+    }
+
+    entry_list_iterate(psrc->entries, psrcent) {
+      if (NULL == entry_copy(pdest, psrcent)) {
+        return FALSE;
+      }
+    } entry_list_iterate_end;
+  } section_list_iterate_end;
+
+  return TRUE;
+}
+
+/**************************************************************************
+  Compare 'current' with 'base'. Copies of the entries of 'current' which
+  are missing in 'base' or have another value there are added to
+  'changes', the paths of the entries of 'base' which are missing in
+  'current' are appended to 'removed'. Applying both to 'base' with
+  secfile_patch() gives the same entries as 'current', only their order
+  may differ.
+**************************************************************************/
+void secfile_diff(const struct section_file *base,
+                  const struct section_file *current,
+                  struct section_file *changes, struct strvec *removed)
+{
+  struct entry_hash *remaining;
+  char path[MAX_LEN_SECPATH];
+
+  SECFILE_RETURN_IF_FAIL(base, NULL, NULL != base);
+  SECFILE_RETURN_IF_FAIL(current, NULL, NULL != current);
+  SECFILE_RETURN_IF_FAIL(changes, NULL, NULL != changes);
+
+  /* All entries of 'base' not (yet) found in 'current'. */
+  remaining = entry_hash_new_nentries(base->num_entries);
+  section_list_iterate(base->sections, psection) {
+    entry_list_iterate(psection->entries, pentry) {
+      entry_path(pentry, path, sizeof(path));
+      entry_hash_insert(remaining, path, pentry);
+    } entry_list_iterate_end;
+  } section_list_iterate_end;
+
+  section_list_iterate(current->sections, psection) {
+    struct section *pchanged = NULL;
+
+    entry_list_iterate(psection->entries, pentry) {
+      struct entry *pbase;
+
+      entry_path(pentry, path, sizeof(path));
+      if (entry_hash_lookup(remaining, path, &pbase)) {
+        entry_hash_remove(remaining, path);
+        if (entry_equal(pentry, pbase)) {
+          continue;
+        }
+      }
+
+      if (NULL == pchanged) {
+        pchanged = secfile_section_by_name(changes, psection->name);
+        if (NULL == pchanged) {
+          pchanged = secfile_section_new(changes, psection->name);
+        }
+      }
+      entry_copy(pchanged, pentry);
+    } entry_list_iterate_end;
+  } section_list_iterate_end;
+
+  if (NULL != removed) {
+    /* Keep the order of 'base' for reproducible output. */
+    section_list_iterate(base->sections, psection) {
+      entry_list_iterate(psection->entries, pentry) {
+        entry_path(pentry, path, sizeof(path));
+        if (entry_hash_lookup(remaining, path, NULL)) {
+          strvec_append(removed, path);
+        }
+      } entry_list_iterate_end;
+    } section_list_iterate_end;
+  }
+
+  entry_hash_destroy(remaining);
+}
+
+/**************************************************************************
+  Apply changes found by secfile_diff() to 'secfile': the entries with the
+  paths in 'removed' are deleted, the entries of 'changes' replace the
+  ones with the same path or are added. Returns TRUE on success.
+**************************************************************************/
+bool secfile_patch(struct section_file *secfile,
+                   const struct section_file *changes,
+                   const struct strvec *removed)
+{
+  char path[MAX_LEN_SECPATH];
+
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(changes, NULL, NULL != changes, FALSE);
+
+  if (NULL != removed) {
+    strvec_iterate(removed, rpath) {
+      struct entry *pentry = secfile_entry_by_path(secfile, rpath);
+
+      if (NULL != pentry) {
+        entry_destroy(pentry);
+      }
+    } strvec_iterate_end;
+  }
+
+  section_list_iterate(changes->sections, pchanged) {
+    struct section *psection = secfile_section_by_name(secfile,
+                                                       pchanged->name);
+
+    if (NULL == psection) {
+      psection = secfile_section_new(secfile, pchanged->name);
+      if (NULL == psection) {
+        return FALSE;
+      }
+    }
+
+    entry_list_iterate(pchanged->entries, pentry) {
+      struct entry *pold;
+
+      entry_path(pentry, path, sizeof(path));
+      pold = secfile_entry_by_path(secfile, path);
+      if (NULL != pold) {
+        entry_destroy(pold);
+      }
+      if (NULL == entry_copy(psection, pentry)) {
+        return FALSE;
+      }
+    } entry_list_iterate_end;
+  } section_list_iterate_end;
+
+  return TRUE;
+}
+
 /**************************************************************************
   Seperates the section and entry names.  Create the section if missing.
 **************************************************************************/
@@ -2934,6 +3091,62 @@ void entry_destroy(struct entry *pentry)
   free(pentry);
 }
 
+/**************************************************************************
+  Add a copy of the entry (value and comment) to the section. Returns the
+  new entry or NULL on failure.
+**************************************************************************/
+static struct entry *entry_copy(struct section *psection,
+                                const struct entry *pentry)
+{
+  struct entry *pcopy = NULL;
+
+  switch (pentry->type) {
+  case ENTRY_BOOL:
+    pcopy = section_entry_bool_new(psection, pentry->name,
+                                   pentry->boolean.value);
+    break;
+  case ENTRY_INT:
+    pcopy = section_entry_int_new(psection, pentry->name,
+                                  pentry->integer.value);
+    break;
+  case ENTRY_STR:
+    pcopy = section_entry_str_new(psection, pentry->name,
+                                  pentry->string.value,
+                                  pentry->string.escaped);
+    break;
+  }
+
+  if (NULL != pcopy && NULL != pentry->comment) {
+    entry_set_comment(pcopy, pentry->comment);
+  }
+
+  return pcopy;
+}
+
+/**************************************************************************
+  Returns TRUE if both entries are of the same type and have the same
+  value. Names and comments are not compared.
+**************************************************************************/
+static bool entry_equal(const struct entry *pentry1,
+                        const struct entry *pentry2)
+{
+  if (pentry1->type != pentry2->type) {
+    return FALSE;
+  }
+
+  switch (pentry1->type) {
+  case ENTRY_BOOL:
+    return pentry1->boolean.value == pentry2->boolean.value;
+  case ENTRY_INT:
+    return pentry1->integer.value == pentry2->integer.value;
+  case ENTRY_STR:
+    return (pentry1->string.escaped == pentry2->string.escaped
+            && 0 == strcmp(pentry1->string.value, pentry2->string.value));
+  }
+
+  return FALSE;
+}
+
 /**************************************************************************
   Returns the parent section of this entry.
 **************************************************************************/
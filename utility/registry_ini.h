@@ -24,6 +24,7 @@ extern "C" {
 struct section_file;
 struct section;
 struct entry;
+struct strvec;
 
 /* Typedefs. */
 typedef const void *secfile_data_t;
@@ -66,6 +67,14 @@ bool secfile_save(const struct section_file *secfile, const char *filename,
                   int compression_level, enum fz_method compression_method);
 void secfile_check_unused(const struct section_file *secfile);
 const char *secfile_name(const struct section_file *secfile);
+bool secfile_append(struct section_file *dest,
+                    const struct section_file *src);
+void secfile_diff(const struct section_file *base,
+                  const struct section_file *current,
+                  struct section_file *changes, struct strvec *removed);
+bool secfile_patch(struct section_file *secfile,
+                   const struct section_file *changes,
+                   const struct strvec *removed);
 
 /* Insertion functions. */
 struct entry *secfile_insert_bool_full(struct section_file *secfile,